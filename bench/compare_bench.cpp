@@ -0,0 +1,110 @@
+/**
+ * calls of the comparator per operation of sjtu::map, with a plain less-than,
+ * a comparator whose call is three-way, and one with a compare() member.
+ * usage: compare_bench [keys]
+ * keys are strings sharing a long prefix, so every comparison is a long loop,
+ * like one between Util::Bint values with many limbs.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "map.hpp"
+
+namespace {
+
+long calls = 0;
+
+struct plain_less {
+    bool operator()(const std::string &a, const std::string &b) const {
+        calls++;
+        return a < b;
+    }
+};
+struct three_way_call {
+    typedef void is_three_way;
+    int operator()(const std::string &a, const std::string &b) const {
+        calls++;
+        return a.compare(b);
+    }
+};
+struct compare_member {
+    bool operator()(const std::string &a, const std::string &b) const {
+        calls++;
+        return a < b;
+    }
+    int compare(const std::string &a, const std::string &b) const {
+        calls++;
+        return a.compare(b);
+    }
+};
+
+// distinct i give distinct keys, in random order: an odd multiplier permutes 32-bit values
+std::string key(unsigned i, char last) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "%010u", i * 2654435761u);
+    return std::string(64, '0') + buf + last;
+}
+
+// calls per operation and nanoseconds per operation of one phase
+struct phase {
+    double calls, ns;
+};
+template<class F>
+phase measure(size_t n, F f) {
+    calls = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    f();
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    phase res = {double(calls) / n, s * 1e9 / n};
+    return res;
+}
+
+template<class Compare>
+void run(const char *name, const std::vector<std::string> &in, const std::vector<std::string> &out) {
+    typedef sjtu::map<std::string, int, Compare> map_type;
+    map_type m;
+    size_t n = in.size();
+    long hits = 0;
+    phase p[4];
+    p[0] = measure(n, [&]() {
+        for (size_t i = 0; i < n; i++)
+            m.insert(sjtu::pair<const std::string, int>(in[i], int(i)));
+    });
+    p[1] = measure(n, [&]() {
+        for (size_t i = 0; i < n; i++)
+            hits += m.find(in[i]) != m.end();
+    });
+    p[2] = measure(n, [&]() {
+        for (size_t i = 0; i < n; i++)
+            hits += m.count(out[i]);
+    });
+    p[3] = measure(n, [&]() {
+        for (size_t i = 0; i < n; i++)
+            hits += m.erase(in[i]);
+    });
+    if (hits != 2 * long(n))
+        std::printf("unreachable\n");
+    std::printf("%-16s", name);
+    for (int i = 0; i < 4; i++)
+        std::printf("  %6.2f %7.0f", p[i].calls, p[i].ns);
+    std::printf("\n");
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t n = argc > 1 ? std::atol(argv[1]) : 200000;
+    std::vector<std::string> in, out;
+    for (size_t i = 0; i < n; i++) {
+        in.push_back(key(unsigned(i), '0'));
+        out.push_back(key(unsigned(i), '1'));
+    }
+    std::printf("%zu keys, comparator calls and ns per operation\n", n);
+    std::printf("%-16s  %14s  %14s  %14s  %14s\n", "comparator", "insert", "find hit", "find miss", "erase");
+    run<plain_less>("less-than", in, out);
+    run<three_way_call>("three-way call", in, out);
+    run<compare_member>("compare() member", in, out);
+    return 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * read throughput of sjtu::rcu_map against a sjtu::map behind a sjtu::rw_lock,
+ * with one writer updating a key every few microseconds.
+ * usage: rcu_bench [keys] [finds per reader]
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "map.hpp"
+#include "concurrent_map.hpp"
+#include "rcu_map.hpp"
+
+namespace {
+
+class locked_map {
+    mutable sjtu::rw_lock l;
+    sjtu::map<int, int> q;
+
+public:
+    bool find(int k) const {
+        sjtu::rw_lock::read_guard g(l);
+        return q.find(k) != q.cend();
+    }
+    void assign(int k, int v) {
+        sjtu::rw_lock::write_guard g(l);
+        q.insert_or_assign(k, v);
+    }
+};
+
+class rcu {
+    sjtu::rcu_map<int, int> q;
+
+public:
+    bool find(int k) const {
+        return q.count(k) != 0;
+    }
+    void assign(int k, int v) {
+        q.insert_or_assign(k, v);
+    }
+};
+
+// million finds per second over all readers
+template<class M>
+double run(int readers, int keys, long finds) {
+    M m;
+    for (int k = 0; k < keys; k++)
+        m.assign(k, k);
+    std::atomic<bool> stop(false);
+    std::thread writer([&m, &stop, keys]() {
+        for (int i = 0; !stop.load(std::memory_order_relaxed); i++) {
+            m.assign(i % keys, i);
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
+    });
+    std::vector<std::thread> th;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int t = 0; t < readers; t++)
+        th.push_back(std::thread([&m, t, keys, finds]() {
+            unsigned long long s = t * 2 + 1;
+            long hits = 0;
+            for (long i = 0; i < finds; i++) {
+                s = s * 6364136223846793005ull + 1442695040888963407ull;
+                hits += m.find((int)((s >> 33) % keys));
+            }
+            if (hits < 0)
+                std::printf("unreachable\n");
+        }));
+    for (size_t i = 0; i < th.size(); i++)
+        th[i].join();
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stop = true;
+    writer.join();
+    return readers * finds / s / 1e6;
+}
+
+}
+
+int main(int argc, char **argv) {
+    int keys = argc > 1 ? std::atoi(argv[1]) : 100000;
+    long finds = argc > 2 ? std::atol(argv[2]) : 1000000;
+    std::printf("%d keys, %ld finds per reader, %u hardware threads\n",
+                keys, finds, std::thread::hardware_concurrency());
+    std::printf("readers  rw_lock+map Mfinds/s  rcu_map Mfinds/s\n");
+    for (int t = 1; t <= 16; t *= 2)
+        std::printf("%7d  %20.2f  %16.2f\n", t, run<locked_map>(t, keys, finds), run<rcu>(t, keys, finds));
+    return 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * throughput of sjtu::skiplist_map against a sjtu::map behind one std::mutex.
+ * usage: skiplist_bench [keys] [ops per thread] [percent of finds]
+ * every thread runs a random mix of find, insert and erase over [0, keys),
+ * and the map starts half full.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "map.hpp"
+#include "skiplist_map.hpp"
+
+namespace {
+
+struct lcg {
+    unsigned long long s;
+    explicit lcg(unsigned long long seed) : s(seed * 2 + 1) {}
+    unsigned next() {
+        s = s * 6364136223846793005ull + 1442695040888963407ull;
+        return (unsigned)(s >> 33);
+    }
+};
+
+class locked_map {
+    std::mutex m;
+    sjtu::map<int, int> q;
+
+public:
+    bool find(int k) {
+        std::lock_guard<std::mutex> g(m);
+        return q.find(k) != q.end();
+    }
+    void insert(int k) {
+        std::lock_guard<std::mutex> g(m);
+        q.insert(sjtu::pair<const int, int>(k, k));
+    }
+    void erase(int k) {
+        std::lock_guard<std::mutex> g(m);
+        q.erase(k);
+    }
+};
+
+class lock_free_map {
+    sjtu::skiplist_map<int, int> q;
+
+public:
+    bool find(int k) {
+        return q.count(k) != 0;
+    }
+    void insert(int k) {
+        q.insert(sjtu::pair<const int, int>(k, k));
+    }
+    void erase(int k) {
+        q.erase(k);
+    }
+};
+
+// million operations per second over all threads
+template<class M>
+double run(int threads, int keys, long ops, int finds) {
+    M m;
+    for (int k = 0; k < keys; k += 2)
+        m.insert(k);
+    std::vector<std::thread> th;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++)
+        th.push_back(std::thread([&m, t, keys, ops, finds]() {
+            lcg r(t + 1);
+            long hits = 0;
+            for (long i = 0; i < ops; i++) {
+                int k = r.next() % keys, what = r.next() % 100;
+                if (what < finds)
+                    hits += m.find(k);
+                else if (what & 1)
+                    m.insert(k);
+                else
+                    m.erase(k);
+            }
+            if (hits < 0)
+                std::printf("unreachable\n");
+        }));
+    for (size_t i = 0; i < th.size(); i++)
+        th[i].join();
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return threads * ops / s / 1e6;
+}
+
+}
+
+int main(int argc, char **argv) {
+    int keys = argc > 1 ? std::atoi(argv[1]) : 100000;
+    long ops = argc > 2 ? std::atol(argv[2]) : 500000;
+    int finds = argc > 3 ? std::atoi(argv[3]) : 50;
+    std::printf("%d keys, %ld ops per thread, %d%% finds, %u hardware threads\n",
+                keys, ops, finds, std::thread::hardware_concurrency());
+    std::printf("threads  mutex+map Mops/s  skiplist_map Mops/s\n");
+    for (int t = 1; t <= 16; t *= 2)
+        std::printf("%7d  %17.2f  %19.2f\n", t, run<locked_map>(t, keys, ops, finds),
+                    run<lock_free_map>(t, keys, ops, finds));
+    return 0;
+}
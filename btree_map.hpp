@@ -0,0 +1,1174 @@
+#ifndef SJTU_BTREE_MAP_HPP
+#define SJTU_BTREE_MAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include "utility.hpp"
+#include "exceptions.hpp"
+
+namespace sjtu {
+
+/**
+ * an ordered map with the interface of sjtu::map, kept in a B+ tree: the values
+ * sit in wide leaves chained in key order, and inner nodes keep copies of their
+ * separator keys side by side, so a lookup reads a few cache lines on each of
+ * few levels.
+ * unlike sjtu::map, insert and erase move values around and so invalidate
+ * iterators and references: this is a deliberate departure from the sjtu::map
+ * interface, and code that keeps them across a change (erase(it++), or the
+ * iterators data/five holds on to) does not carry over. erase returns the
+ * iterator to go on with instead, as in it = m.erase(it).
+ * values and keys are moved by construction, never assigned; a separator is the
+ * only copy of a key ever made. their move constructors, and the key's copy
+ * constructor, are assumed not to throw.
+ */
+template<
+    class Key,
+    class T,
+    class Compare = std::less<Key>,
+    class Allocator = std::allocator<pair<const Key, T>>
+> class btree_map {
+public:
+    typedef pair<const Key, T> value_type;
+    typedef Allocator allocator_type;
+
+private:
+    // nodes of about four cache lines, never with fewer than four slots
+    static const size_t node_bytes = 256;
+    static const size_t leaf_slots = (node_bytes - 3 * sizeof(void *)) / sizeof(value_type) > 4 ?
+                                     (node_bytes - 3 * sizeof(void *)) / sizeof(value_type) : 4;
+    static const size_t inner_slots = (node_bytes - 2 * sizeof(void *)) / (sizeof(Key) + sizeof(void *)) > 4 ?
+                                      (node_bytes - 2 * sizeof(void *)) / (sizeof(Key) + sizeof(void *)) : 4;
+    static const size_t leaf_min = leaf_slots / 2;
+    static const size_t inner_min = inner_slots / 2;
+    static const size_t max_height = 64;
+
+    /**
+     * both kinds of node have room for one entry more than they may keep:
+     * an insertion goes in first and the node is split right after.
+     */
+    struct leaf {
+        size_t n;
+        leaf *prev, *next;
+        typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type slot[leaf_slots + 1];
+
+        value_type *value(size_t i) {
+            return reinterpret_cast<value_type *>(&slot[i]);
+        }
+    };
+    // n keys and n + 1 sons, which are leaves at the last inner level and inner nodes above
+    struct inner {
+        size_t n;
+        typename std::aligned_storage<sizeof(Key), alignof(Key)>::type keys[inner_slots];
+        void *son[inner_slots + 1];
+
+        Key *key(size_t i) {
+            return reinterpret_cast<Key *>(&keys[i]);
+        }
+    };
+
+    // whether V is a pair whose first is a Key, so emplace can read the key off it
+    template<class V>
+    struct key_first : std::false_type {};
+    template<class U, class W>
+    struct key_first<pair<U, W>> : std::is_same<typename std::remove_const<U>::type, Key> {};
+
+    typedef std::allocator_traits<Allocator> value_traits;
+    typedef typename value_traits::template rebind_alloc<leaf> leaf_allocator;
+    typedef typename value_traits::template rebind_alloc<inner> inner_allocator;
+    typedef std::allocator_traits<leaf_allocator> leaf_traits;
+    typedef std::allocator_traits<inner_allocator> inner_traits;
+
+    // the inner nodes on the way down to a leaf, and which son was taken in each
+    struct path {
+        inner *node[max_height];
+        size_t pos[max_height];
+    };
+
+    void *root; // a leaf when height == 0, nullptr when empty
+    size_t height, _size;
+    leaf *head, *tail;
+    Compare cmp;
+    Allocator alloc;
+
+    leaf *new_leaf() {
+        leaf_allocator a(alloc);
+        leaf *l = leaf_traits::allocate(a, 1);
+        l->n = 0;
+        l->prev = l->next = nullptr;
+        return l;
+    }
+    void free_leaf(leaf *l) {
+        leaf_allocator a(alloc);
+        leaf_traits::deallocate(a, l, 1);
+    }
+    inner *new_inner() {
+        inner_allocator a(alloc);
+        inner *p = inner_traits::allocate(a, 1);
+        p->n = 0;
+        return p;
+    }
+    void free_inner(inner *p) {
+        inner_allocator a(alloc);
+        inner_traits::deallocate(a, p, 1);
+    }
+
+    template<class V>
+    static void move_construct(V *dst, V &src) {
+        new (dst) V(std::move(src));
+    }
+    // the key is only const to users: a value that is destroyed right after gives it up too
+    static void move_construct(value_type *dst, value_type &src) {
+        new (dst) value_type(std::move(const_cast<Key &>(src.first)), std::move(src.second));
+    }
+    // move n objects from src to dst, which may overlap, by construction
+    template<class V>
+    static void relocate(V *dst, V *src, size_t n) {
+        if (n == 0 || dst == src)
+            return;
+        if (std::is_trivially_copyable<V>::value) {
+            std::memmove(static_cast<void *>(dst), static_cast<const void *>(src), n * sizeof(V));
+        } else if (dst < src) {
+            for (size_t i = 0; i < n; i++) {
+                move_construct(dst + i, src[i]);
+                src[i].~V();
+            }
+        } else {
+            for (size_t i = n; i-- > 0;) {
+                move_construct(dst + i, src[i]);
+                src[i].~V();
+            }
+        }
+    }
+    static void relocate_sons(void **dst, void **src, size_t n) {
+        std::memmove(dst, src, n * sizeof(void *));
+    }
+
+    void destroy(void *p, size_t h) {
+        if (h == 0) {
+            leaf *l = static_cast<leaf *>(p);
+            for (size_t i = 0; i < l->n; i++)
+                value_traits::destroy(alloc, l->value(i));
+            free_leaf(l);
+            return;
+        }
+        inner *q = static_cast<inner *>(p);
+        for (size_t i = 0; i <= q->n; i++)
+            destroy(q->son[i], h - 1);
+        for (size_t i = 0; i < q->n; i++)
+            q->key(i)->~Key();
+        free_inner(q);
+    }
+
+    // first son of p that may hold k (sons to the right of a key hold the keys not less than it)
+    template<class K>
+    size_t son_of(inner *p, const K &k) const {
+        size_t lo = 0, hi = p->n;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (cmp(k, *p->key(mid)))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        return lo;
+    }
+    template<class K>
+    size_t leaf_lower(leaf *l, const K &k) const {
+        size_t lo = 0, hi = l->n;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (cmp(l->value(mid)->first, k))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+    template<class K>
+    size_t leaf_upper(leaf *l, const K &k) const {
+        size_t lo = 0, hi = l->n;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (cmp(k, l->value(mid)->first))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        return lo;
+    }
+    // the leaf where k is or would be; the path there is recorded if asked for
+    template<class K>
+    leaf *descend(const K &k, path *w = nullptr) const {
+        void *p = root;
+        for (size_t d = 0; d < height; d++) {
+            inner *q = static_cast<inner *>(p);
+            size_t i = son_of(q, k);
+            if (w != nullptr)
+                w->node[d] = q, w->pos[d] = i;
+            p = q->son[i];
+        }
+        return static_cast<leaf *>(p);
+    }
+
+    template<class K>
+    pair<leaf *, size_t> find_pos(const K &k) const {
+        if (root == nullptr)
+            return pair<leaf *, size_t>(nullptr, 0);
+        leaf *l = descend(k);
+        size_t i = leaf_lower(l, k);
+        if (i == l->n || cmp(k, l->value(i)->first))
+            return pair<leaf *, size_t>(nullptr, 0);
+        return pair<leaf *, size_t>(l, i);
+    }
+    // a position one past the end of its leaf stands for the first of the next one
+    pair<leaf *, size_t> normalize(leaf *l, size_t i) const {
+        if (l != nullptr && i == l->n)
+            return pair<leaf *, size_t>(l->next, 0);
+        return pair<leaf *, size_t>(l, i);
+    }
+    /**
+     * a transparent probe may be equivalent to a run of keys that crosses a separator,
+     * so the first of them is searched for left of every separator not less than k.
+     */
+    template<class K>
+    pair<leaf *, size_t> lower_pos(const K &k) const {
+        if (root == nullptr)
+            return pair<leaf *, size_t>(nullptr, 0);
+        void *p = root;
+        for (size_t d = 0; d < height; d++) {
+            inner *q = static_cast<inner *>(p);
+            size_t lo = 0, hi = q->n;
+            while (lo < hi) {
+                size_t mid = (lo + hi) / 2;
+                if (cmp(*q->key(mid), k))
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            p = q->son[lo];
+        }
+        leaf *l = static_cast<leaf *>(p);
+        return normalize(l, leaf_lower(l, k));
+    }
+    template<class K>
+    pair<leaf *, size_t> upper_pos(const K &k) const {
+        if (root == nullptr)
+            return pair<leaf *, size_t>(nullptr, 0);
+        leaf *l = descend(k);
+        return normalize(l, leaf_upper(l, k));
+    }
+
+    /**
+     * put a new value at position i of leaf l, found through w, constructing it from args.
+     * every node the splits will need is allocated before anything changes, and the
+     * splits only happen once the value is in place, so a throw leaves the tree as it was.
+     */
+    template<class... Args>
+    pair<leaf *, size_t> insert_at(leaf *l, size_t i, path &w, Args&&... args) {
+        if (l == nullptr) {
+            l = new_leaf();
+            try {
+                value_traits::construct(alloc, l->value(0), std::forward<Args>(args)...);
+            } catch (...) {
+                free_leaf(l);
+                throw;
+            }
+            l->n = 1;
+            root = head = tail = l;
+            _size = 1;
+            return pair<leaf *, size_t>(l, 0);
+        }
+
+        leaf *spare_leaf = nullptr;
+        inner *spare[max_height + 1];
+        size_t need = 0, got = 0;
+        if (l->n == leaf_slots) {
+            size_t splits = 0;
+            while (splits < height && w.node[height - 1 - splits]->n == inner_slots - 1)
+                splits++;
+            need = splits + (splits == height);
+            try {
+                spare_leaf = new_leaf();
+                for (; got < need; got++)
+                    spare[got] = new_inner();
+            } catch (...) {
+                if (spare_leaf != nullptr)
+                    free_leaf(spare_leaf);
+                while (got > 0)
+                    free_inner(spare[--got]);
+                throw;
+            }
+        }
+
+        relocate(l->value(i + 1), l->value(i), l->n - i);
+        try {
+            value_traits::construct(alloc, l->value(i), std::forward<Args>(args)...);
+        } catch (...) {
+            relocate(l->value(i), l->value(i + 1), l->n - i);
+            if (spare_leaf != nullptr)
+                free_leaf(spare_leaf);
+            while (got > 0)
+                free_inner(spare[--got]);
+            throw;
+        }
+        l->n++;
+        _size++;
+        if (l->n <= leaf_slots)
+            return pair<leaf *, size_t>(l, i);
+
+        // l overflowed: its upper half moves to r, which is hung next to it
+        leaf *r = spare_leaf;
+        size_t keep = (l->n + 1) / 2;
+        r->n = l->n - keep;
+        relocate(r->value(0), l->value(keep), r->n);
+        l->n = keep;
+        r->prev = l, r->next = l->next;
+        if (l->next != nullptr)
+            l->next->prev = r;
+        else
+            tail = r;
+        l->next = r;
+
+        typename std::aligned_storage<sizeof(Key), alignof(Key)>::type sep;
+        new (&sep) Key(r->value(0)->first);
+        add_son(w, reinterpret_cast<Key *>(&sep), r, spare);
+        return i < keep ? pair<leaf *, size_t>(l, i) : pair<leaf *, size_t>(r, i - keep);
+    }
+    /**
+     * hang right next to the node at the bottom of w, with separator key *sep, which is
+     * moved out. full inner nodes split in turn, taking their new halves from spare.
+     */
+    void add_son(path &w, Key *sep, void *right, inner **spare) {
+        size_t used = 0;
+        for (size_t d = height; ; d--) {
+            if (d == 0) {
+                inner *r = spare[used++];
+                new (r->key(0)) Key(std::move(*sep));
+                sep->~Key();
+                r->n = 1;
+                r->son[0] = root, r->son[1] = right;
+                root = r;
+                height++;
+                return;
+            }
+            inner *p = w.node[d - 1];
+            size_t i = w.pos[d - 1];
+            relocate(p->key(i + 1), p->key(i), p->n - i);
+            relocate_sons(p->son + i + 2, p->son + i + 1, p->n - i);
+            new (p->key(i)) Key(std::move(*sep));
+            sep->~Key();
+            p->son[i + 1] = right;
+            p->n++;
+            if (p->n < inner_slots)
+                return;
+
+            // the left half keeps lc sons, the key between the halves goes up
+            inner *q = spare[used++];
+            size_t lc = (p->n + 2) / 2;
+            q->n = p->n - lc;
+            new (sep) Key(std::move(*p->key(lc - 1)));
+            p->key(lc - 1)->~Key();
+            relocate(q->key(0), p->key(lc), q->n);
+            relocate_sons(q->son, p->son + lc, q->n + 1);
+            p->n = lc - 1;
+            right = q;
+        }
+    }
+
+    void reset_key(inner *p, size_t k, const Key &key) {
+        p->key(k)->~Key();
+        new (p->key(k)) Key(key);
+    }
+    // append b to a and free it
+    void merge_leaves(leaf *a, leaf *b) {
+        relocate(a->value(a->n), b->value(0), b->n);
+        a->n += b->n;
+        a->next = b->next;
+        if (b->next != nullptr)
+            b->next->prev = a;
+        else
+            tail = a;
+        free_leaf(b);
+    }
+    // drop key k and son k + 1 of p
+    void remove_son(inner *p, size_t k) {
+        p->key(k)->~Key();
+        relocate(p->key(k), p->key(k + 1), p->n - k - 1);
+        relocate_sons(p->son + k + 1, p->son + k + 2, p->n - k - 1);
+        p->n--;
+    }
+    // son k + 1 of g goes into son k, with key k of g pulled down between them
+    void merge_inner(inner *g, size_t k) {
+        inner *a = static_cast<inner *>(g->son[k]), *b = static_cast<inner *>(g->son[k + 1]);
+        relocate(a->key(a->n), g->key(k), 1);
+        relocate(a->key(a->n + 1), b->key(0), b->n);
+        relocate_sons(a->son + a->n + 1, b->son, b->n + 1);
+        a->n += b->n + 1;
+        free_inner(b);
+        relocate(g->key(k), g->key(k + 1), g->n - k - 1);
+        relocate_sons(g->son + k + 1, g->son + k + 2, g->n - k - 1);
+        g->n--;
+    }
+
+    /**
+     * remove the value at i of leaf l, found through w, then borrow or merge upwards.
+     * return where the value that followed it has moved to (nullptr for the end):
+     * only the leaf level moves values, so it is followed through the first step.
+     */
+    pair<leaf *, size_t> erase_at(leaf *l, size_t i, path &w) {
+        value_traits::destroy(alloc, l->value(i));
+        relocate(l->value(i), l->value(i + 1), l->n - i - 1);
+        l->n--;
+        _size--;
+        if (height == 0) {
+            if (l->n == 0) {
+                free_leaf(l);
+                root = head = tail = nullptr;
+                return pair<leaf *, size_t>(nullptr, 0);
+            }
+            return normalize(l, i);
+        }
+        if (l->n >= leaf_min)
+            return normalize(l, i);
+
+        inner *p = w.node[height - 1];
+        size_t j = w.pos[height - 1];
+        if (j > 0) {
+            leaf *s = static_cast<leaf *>(p->son[j - 1]);
+            if (s->n > leaf_min) {
+                relocate(l->value(1), l->value(0), l->n);
+                relocate(l->value(0), s->value(s->n - 1), 1);
+                s->n--, l->n++;
+                reset_key(p, j - 1, l->value(0)->first);
+                return normalize(l, i + 1);
+            }
+        }
+        if (j < p->n) {
+            leaf *s = static_cast<leaf *>(p->son[j + 1]);
+            if (s->n > leaf_min) {
+                relocate(l->value(l->n), s->value(0), 1);
+                relocate(s->value(0), s->value(1), s->n - 1);
+                s->n--, l->n++;
+                reset_key(p, j, s->value(0)->first);
+                return normalize(l, i);
+            }
+        }
+        leaf *to = l;
+        if (j > 0) {
+            to = static_cast<leaf *>(p->son[j - 1]);
+            i += to->n;
+            merge_leaves(to, l);
+            remove_son(p, j - 1);
+        } else {
+            merge_leaves(l, static_cast<leaf *>(p->son[1]));
+            remove_son(p, 0);
+        }
+        pair<leaf *, size_t> next = normalize(to, i);
+
+        for (size_t d = height - 1; ; d--) {
+            p = w.node[d];
+            if (d == 0) {
+                if (p->n == 0) {
+                    root = p->son[0];
+                    height--;
+                    free_inner(p);
+                }
+                return next;
+            }
+            if (p->n + 1 >= inner_min)
+                return next;
+            inner *g = w.node[d - 1];
+            j = w.pos[d - 1];
+            if (j > 0) {
+                inner *s = static_cast<inner *>(g->son[j - 1]);
+                if (s->n + 1 > inner_min) {
+                    relocate(p->key(1), p->key(0), p->n);
+                    relocate_sons(p->son + 1, p->son, p->n + 1);
+                    relocate(p->key(0), g->key(j - 1), 1);
+                    relocate(g->key(j - 1), s->key(s->n - 1), 1);
+                    p->son[0] = s->son[s->n];
+                    s->n--, p->n++;
+                    return next;
+                }
+            }
+            if (j < g->n) {
+                inner *s = static_cast<inner *>(g->son[j + 1]);
+                if (s->n + 1 > inner_min) {
+                    relocate(p->key(p->n), g->key(j), 1);
+                    relocate(g->key(j), s->key(0), 1);
+                    p->son[p->n + 1] = s->son[0];
+                    relocate(s->key(0), s->key(1), s->n - 1);
+                    relocate_sons(s->son, s->son + 1, s->n);
+                    s->n--, p->n++;
+                    return next;
+                }
+            }
+            merge_inner(g, j > 0 ? j - 1 : 0);
+        }
+    }
+
+    /**
+     * fill the empty tree with the n values from it, in key order: the leaves are filled
+     * evenly, then every level of inner nodes on top of them, so no node is below its minimum.
+     */
+    template<class InputIt>
+    void build(InputIt it, size_t n) {
+        if (n == 0)
+            return;
+        std::vector<void *> level, up;
+        std::vector<const Key *> low, up_low;
+        std::vector<inner *> made;
+        try {
+            size_t leaves = (n + leaf_slots - 1) / leaf_slots;
+            for (size_t j = 0; j < leaves; j++) {
+                leaf *l = new_leaf();
+                l->prev = tail;
+                if (tail != nullptr)
+                    tail->next = l;
+                else
+                    head = l;
+                tail = l;
+                for (size_t c = n / leaves + (j < n % leaves); l->n < c; ++it) {
+                    value_traits::construct(alloc, l->value(l->n), *it);
+                    l->n++;
+                }
+                level.push_back(l);
+                low.push_back(&l->value(0)->first);
+            }
+            height = 0;
+            while (level.size() > 1) {
+                size_t m = level.size(), parents = (m + inner_slots - 1) / inner_slots, s = 0;
+                up.clear(), up_low.clear();
+                for (size_t j = 0; j < parents; j++) {
+                    inner *p = new_inner();
+                    made.push_back(p);
+                    size_t c = m / parents + (j < m % parents);
+                    p->son[0] = level[s];
+                    for (size_t k = 1; k < c; k++) {
+                        new (p->key(k - 1)) Key(*low[s + k]);
+                        p->n++;
+                        p->son[k] = level[s + k];
+                    }
+                    up.push_back(p);
+                    up_low.push_back(low[s]);
+                    s += c;
+                }
+                level.swap(up), low.swap(up_low);
+                height++;
+            }
+        } catch (...) {
+            for (size_t j = 0; j < made.size(); j++) {
+                for (size_t k = 0; k < made[j]->n; k++)
+                    made[j]->key(k)->~Key();
+                free_inner(made[j]);
+            }
+            for (leaf *l = head, *r; l != nullptr; l = r) {
+                r = l->next;
+                for (size_t k = 0; k < l->n; k++)
+                    value_traits::destroy(alloc, l->value(k));
+                free_leaf(l);
+            }
+            root = head = tail = nullptr;
+            height = 0;
+            throw;
+        }
+        root = level[0];
+        _size = n;
+    }
+
+    void steal(btree_map &o) {
+        root = o.root, height = o.height, _size = o._size;
+        head = o.head, tail = o.tail;
+        o.root = o.head = o.tail = nullptr;
+        o.height = o._size = 0;
+    }
+
+public:
+    class const_iterator;
+    class iterator {
+        friend class btree_map;
+        friend const_iterator;
+
+    public:
+        typedef pair<const Key, T> value_type;
+        typedef value_type&         reference;
+        typedef value_type*           pointer;
+        typedef std::ptrdiff_t        difference_type;
+        typedef std::bidirectional_iterator_tag iterator_category;
+
+    private:
+        btree_map *_map;
+        leaf *l; // nullptr at end()
+        size_t i;
+
+    public:
+        iterator() : _map(nullptr), l(nullptr), i(0) {}
+        iterator(const iterator &o) : _map(o._map), l(o.l), i(o.i) {}
+        iterator(btree_map *__map, leaf *_l, size_t _i) : _map(__map), l(_l), i(_i) {}
+        iterator &operator=(const iterator &o) {
+            _map = o._map, l = o.l, i = o.i;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator res(*this);
+            ++*this;
+            return res;
+        }
+        iterator &operator++() {
+            if (_map == nullptr || l == nullptr)
+                throw invalid_iterator();
+            if (++i == l->n)
+                l = l->next, i = 0;
+            return *this;
+        }
+        iterator operator--(int) {
+            iterator res(*this);
+            --*this;
+            return res;
+        }
+        iterator &operator--() {
+            if (_map == nullptr || *this == _map->begin())
+                throw invalid_iterator();
+            if (l == nullptr)
+                l = _map->tail, i = l->n - 1;
+            else if (i == 0)
+                l = l->prev, i = l->n - 1;
+            else
+                i--;
+            return *this;
+        }
+
+        reference operator*() const {
+            return *l->value(i);
+        }
+        pointer operator->() const noexcept {
+            return l->value(i);
+        }
+
+        bool operator==(const iterator &o) const {
+            return _map == o._map && l == o.l && i == o.i;
+        }
+        bool operator==(const const_iterator &o) const {
+            return _map == o._map && l == o.l && i == o.i;
+        }
+        bool operator!=(const iterator &o) const {
+            return !(*this == o);
+        }
+        bool operator!=(const const_iterator &o) const {
+            return !(*this == o);
+        }
+    };
+    class const_iterator {
+        friend class btree_map;
+        friend iterator;
+
+    public:
+        typedef const pair<const Key, T> value_type;
+        typedef value_type&         reference;
+        typedef value_type*           pointer;
+        typedef std::ptrdiff_t        difference_type;
+        typedef std::bidirectional_iterator_tag iterator_category;
+
+    private:
+        const btree_map *_map;
+        leaf *l;
+        size_t i;
+
+    public:
+        const_iterator() : _map(nullptr), l(nullptr), i(0) {}
+        const_iterator(const iterator &o) : _map(o._map), l(o.l), i(o.i) {}
+        const_iterator(const const_iterator &o) : _map(o._map), l(o.l), i(o.i) {}
+        const_iterator(const btree_map *__map, leaf *_l, size_t _i) : _map(__map), l(_l), i(_i) {}
+        const_iterator &operator=(const const_iterator &o) {
+            _map = o._map, l = o.l, i = o.i;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator res(*this);
+            ++*this;
+            return res;
+        }
+        const_iterator &operator++() {
+            if (_map == nullptr || l == nullptr)
+                throw invalid_iterator();
+            if (++i == l->n)
+                l = l->next, i = 0;
+            return *this;
+        }
+        const_iterator operator--(int) {
+            const_iterator res(*this);
+            --*this;
+            return res;
+        }
+        const_iterator &operator--() {
+            if (_map == nullptr || *this == _map->cbegin())
+                throw invalid_iterator();
+            if (l == nullptr)
+                l = _map->tail, i = l->n - 1;
+            else if (i == 0)
+                l = l->prev, i = l->n - 1;
+            else
+                i--;
+            return *this;
+        }
+
+        reference operator*() const {
+            return *l->value(i);
+        }
+        pointer operator->() const noexcept {
+            return l->value(i);
+        }
+
+        bool operator==(const iterator &o) const {
+            return _map == o._map && l == o.l && i == o.i;
+        }
+        bool operator==(const const_iterator &o) const {
+            return _map == o._map && l == o.l && i == o.i;
+        }
+        bool operator!=(const iterator &o) const {
+            return !(*this == o);
+        }
+        bool operator!=(const const_iterator &o) const {
+            return !(*this == o);
+        }
+    };
+
+private:
+    iterator make_iterator(const pair<leaf *, size_t> &p) {
+        return iterator(this, p.first, p.second);
+    }
+    const_iterator make_iterator(const pair<leaf *, size_t> &p) const {
+        return const_iterator(this, p.first, p.second);
+    }
+    void check_hint(const const_iterator &hint) const {
+        if (hint._map != this)
+            throw invalid_iterator();
+    }
+    /**
+     * where k goes if it belongs right before hint, without a descent: true when k
+     * falls between two neighbours in one leaf, or after the maximum (hint == end(),
+     * the sorted append). l is then the leaf, i the position in it, and w is filled
+     * in (the right spine for an append) only if l is full and so must split.
+     */
+    template<class K>
+    bool hinted(const const_iterator &hint, const K &k, leaf *&l, size_t &i, path &w) {
+        check_hint(hint);
+        if (hint.l == nullptr) {
+            l = tail, i = l == nullptr ? 0 : l->n;
+            if (l == nullptr || !cmp(l->value(i - 1)->first, k))
+                return false;
+            if (l->n == leaf_slots) {
+                void *p = root;
+                for (size_t d = 0; d < height; d++) {
+                    inner *q = static_cast<inner *>(p);
+                    w.node[d] = q, w.pos[d] = q->n;
+                    p = q->son[q->n];
+                }
+            }
+            return true;
+        }
+        l = hint.l, i = hint.i;
+        if (i == 0 || !cmp(l->value(i - 1)->first, k) || !cmp(k, l->value(i)->first))
+            return false;
+        if (l->n == leaf_slots)
+            descend(k, &w);
+        return true;
+    }
+    // K is Key or anything a transparent Compare can order against it; the value comes from args
+    template<class K, class... Args>
+    pair<iterator, bool> insert_key(const K &k, Args&&... args) {
+        path w;
+        leaf *l = root == nullptr ? nullptr : descend(k, &w);
+        size_t i = l == nullptr ? 0 : leaf_lower(l, k);
+        if (l != nullptr && i < l->n && !cmp(k, l->value(i)->first))
+            return pair<iterator, bool>(iterator(this, l, i), false);
+        return pair<iterator, bool>(make_iterator(insert_at(l, i, w, std::forward<Args>(args)...)), true);
+    }
+
+    // the mapped value is only built once the key is known to be absent
+    template<class K, class... Args>
+    pair<iterator, bool> emplace_key(K &&k, Args&&... args) {
+        path w;
+        leaf *l = root == nullptr ? nullptr : descend(k, &w);
+        size_t i = l == nullptr ? 0 : leaf_lower(l, k);
+        if (l != nullptr && i < l->n && !cmp(k, l->value(i)->first))
+            return pair<iterator, bool>(iterator(this, l, i), false);
+        return pair<iterator, bool>(make_iterator(insert_at(l, i, w, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(k)), std::forward_as_tuple(std::forward<Args>(args)...))), true);
+    }
+    template<class K, class M>
+    pair<iterator, bool> assign_key(K &&k, M &&obj) {
+        path w;
+        leaf *l = root == nullptr ? nullptr : descend(k, &w);
+        size_t i = l == nullptr ? 0 : leaf_lower(l, k);
+        if (l != nullptr && i < l->n && !cmp(k, l->value(i)->first)) {
+            l->value(i)->second = std::forward<M>(obj);
+            return pair<iterator, bool>(iterator(this, l, i), false);
+        }
+        return pair<iterator, bool>(make_iterator(insert_at(l, i, w, std::forward<K>(k), std::forward<M>(obj))), true);
+    }
+
+public:
+    btree_map() : root(nullptr), height(0), _size(0), head(nullptr), tail(nullptr), cmp(), alloc() {}
+    explicit btree_map(const Allocator &a) : root(nullptr), height(0), _size(0), head(nullptr), tail(nullptr), cmp(), alloc(a) {}
+    btree_map(const btree_map &o) : root(nullptr), height(0), _size(0), head(nullptr), tail(nullptr), cmp(o.cmp),
+                                    alloc(value_traits::select_on_container_copy_construction(o.alloc)) {
+        build(o.cbegin(), o._size);
+    }
+    btree_map(const btree_map &o, const Allocator &a) : root(nullptr), height(0), _size(0), head(nullptr), tail(nullptr),
+                                                        cmp(o.cmp), alloc(a) {
+        build(o.cbegin(), o._size);
+    }
+    /**
+     * build from [first, last), which must be sorted by Compare and free of
+     * duplicate keys, in O(n) with every leaf filled evenly.
+     */
+    template<class ForwardIt>
+    btree_map(sorted_unique_t, ForwardIt first, ForwardIt last, const Allocator &a = Allocator())
+        : root(nullptr), height(0), _size(0), head(nullptr), tail(nullptr), cmp(), alloc(a) {
+        build(first, std::distance(first, last));
+    }
+    btree_map(btree_map &&o) noexcept : root(nullptr), height(0), _size(0), head(nullptr), tail(nullptr),
+                                        cmp(std::move(o.cmp)), alloc(std::move(o.alloc)) {
+        steal(o);
+    }
+    ~btree_map() {
+        clear();
+    }
+
+    btree_map &operator=(const btree_map &o) {
+        if (this == &o)
+            return *this;
+        clear();
+        cmp = o.cmp;
+        if (value_traits::propagate_on_container_copy_assignment::value)
+            alloc = o.alloc;
+        build(o.cbegin(), o._size);
+        return *this;
+    }
+    btree_map &operator=(btree_map &&o) noexcept(value_traits::propagate_on_container_move_assignment::value) {
+        if (this == &o)
+            return *this;
+        clear();
+        cmp = std::move(o.cmp);
+        if (value_traits::propagate_on_container_move_assignment::value || alloc == o.alloc) {
+            if (value_traits::propagate_on_container_move_assignment::value)
+                alloc = std::move(o.alloc);
+            steal(o);
+        } else {
+            build(std::make_move_iterator(o.begin()), o._size);
+            o.clear();
+        }
+        return *this;
+    }
+    void swap(btree_map &o) noexcept {
+        std::swap(root, o.root), std::swap(height, o.height), std::swap(_size, o._size);
+        std::swap(head, o.head), std::swap(tail, o.tail);
+        using std::swap;
+        swap(cmp, o.cmp);
+        if (value_traits::propagate_on_container_swap::value)
+            swap(alloc, o.alloc);
+    }
+    allocator_type get_allocator() const {
+        return alloc;
+    }
+
+    /**
+     * access specified element with bounds checking.
+     * throw index_out_of_bound if no such element exists.
+     */
+    T &at(const Key &key) {
+        pair<leaf *, size_t> p = find_pos(key);
+        if (p.first == nullptr)
+            throw index_out_of_bound();
+        return p.first->value(p.second)->second;
+    }
+    const T &at(const Key &key) const {
+        pair<leaf *, size_t> p = find_pos(key);
+        if (p.first == nullptr)
+            throw index_out_of_bound();
+        return p.first->value(p.second)->second;
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    T &at(const K &key) {
+        pair<leaf *, size_t> p = find_pos(key);
+        if (p.first == nullptr)
+            throw index_out_of_bound();
+        return p.first->value(p.second)->second;
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const T &at(const K &key) const {
+        pair<leaf *, size_t> p = find_pos(key);
+        if (p.first == nullptr)
+            throw index_out_of_bound();
+        return p.first->value(p.second)->second;
+    }
+    /**
+     * access specified element, inserting a value-initialized T if the key is absent.
+     */
+    T &operator[](const Key &key) {
+        return try_emplace(key).first->second;
+    }
+    T &operator[](Key &&key) {
+        return try_emplace(std::move(key)).first->second;
+    }
+    // behave like at(): throw index_out_of_bound if no such element exists
+    const T &operator[](const Key &key) const {
+        return at(key);
+    }
+
+    iterator begin() {
+        return iterator(this, head, 0);
+    }
+    const_iterator begin() const {
+        return const_iterator(this, head, 0);
+    }
+    const_iterator cbegin() const {
+        return const_iterator(this, head, 0);
+    }
+    iterator end() {
+        return iterator(this, nullptr, 0);
+    }
+    const_iterator end() const {
+        return const_iterator(this, nullptr, 0);
+    }
+    const_iterator cend() const {
+        return const_iterator(this, nullptr, 0);
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+    size_t size() const {
+        return _size;
+    }
+    void clear() {
+        if (root != nullptr)
+            destroy(root, height);
+        root = head = tail = nullptr;
+        height = _size = 0;
+    }
+
+    /**
+     * insert value if its key is absent.
+     * return a pair of the iterator to the element with that key, and whether
+     * the insertion took place.
+     */
+    pair<iterator, bool> insert(const value_type &value) {
+        return insert_key(value.first, value);
+    }
+    pair<iterator, bool> insert(value_type &&value) {
+        return insert_key(value.first, std::move(value));
+    }
+    /**
+     * the hint must be an iterator of this map (throw invalid_iterator otherwise).
+     * a key that belongs right before it, inside its leaf or after the maximum with
+     * hint == end(), is put there with one or two comparisons, so a sorted load with
+     * end() as the hint costs O(1) comparisons per element; any other hint is ignored.
+     */
+    iterator insert(const_iterator hint, const value_type &value) {
+        leaf *l;
+        size_t i;
+        path w;
+        if (hinted(hint, value.first, l, i, w))
+            return make_iterator(insert_at(l, i, w, value));
+        return insert(value).first;
+    }
+    iterator insert(const_iterator hint, value_type &&value) {
+        leaf *l;
+        size_t i;
+        path w;
+        if (hinted(hint, value.first, l, i, w))
+            return make_iterator(insert_at(l, i, w, std::move(value)));
+        return insert(std::move(value)).first;
+    }
+    /**
+     * given a key and a value, or a pair, the element is built once, in its slot.
+     * from any other arguments it is built aside first: its key decides the slot.
+     */
+    template<class... Args>
+    pair<iterator, bool> emplace(Args&&... args) {
+        typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type buf;
+        value_type *v = reinterpret_cast<value_type *>(&buf);
+        value_traits::construct(alloc, v, std::forward<Args>(args)...);
+        try {
+            pair<iterator, bool> res = insert_key(v->first, std::move(*v));
+            value_traits::destroy(alloc, v);
+            return res;
+        } catch (...) {
+            value_traits::destroy(alloc, v);
+            throw;
+        }
+    }
+    template<class K, class M, class = typename std::enable_if<std::is_same<typename std::decay<K>::type, Key>::value>::type>
+    pair<iterator, bool> emplace(K &&k, M &&obj) {
+        return insert_key(k, std::forward<K>(k), std::forward<M>(obj));
+    }
+    template<class P, class = typename std::enable_if<key_first<typename std::decay<P>::type>::value>::type>
+    pair<iterator, bool> emplace(P &&p) {
+        return insert_key(p.first, std::forward<P>(p));
+    }
+    template<class... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args) {
+        check_hint(hint);
+        return emplace(std::forward<Args>(args)...).first;
+    }
+    template<class K, class M, class = typename std::enable_if<std::is_same<typename std::decay<K>::type, Key>::value>::type>
+    iterator emplace_hint(const_iterator hint, K &&k, M &&obj) {
+        leaf *l;
+        size_t i;
+        path w;
+        if (hinted(hint, k, l, i, w))
+            return make_iterator(insert_at(l, i, w, std::forward<K>(k), std::forward<M>(obj)));
+        return emplace(std::forward<K>(k), std::forward<M>(obj)).first;
+    }
+    template<class... Args>
+    pair<iterator, bool> try_emplace(const Key &key, Args&&... args) {
+        return emplace_key(key, std::forward<Args>(args)...);
+    }
+    template<class... Args>
+    pair<iterator, bool> try_emplace(Key &&key, Args&&... args) {
+        return emplace_key(std::move(key), std::forward<Args>(args)...);
+    }
+    template<class M>
+    pair<iterator, bool> insert_or_assign(const Key &key, M &&obj) {
+        return assign_key(key, std::forward<M>(obj));
+    }
+    template<class M>
+    pair<iterator, bool> insert_or_assign(Key &&key, M &&obj) {
+        return assign_key(std::move(key), std::forward<M>(obj));
+    }
+
+    /**
+     * erase the element at pos, and return an iterator to the element after it:
+     * erasing invalidates every other iterator, so erase while iterating as
+     *     it = m.erase(it);
+     * throw if pos pointed to a bad element (pos == this->end() || pos points an element out of this)
+     */
+    iterator erase(iterator pos) {
+        if (this != pos._map || pos.l == nullptr)
+            throw invalid_iterator();
+        path w;
+        descend(pos->first, &w);
+        return make_iterator(erase_at(pos.l, pos.i, w));
+    }
+    /**
+     * erase every element in [first, last), and return an iterator to the element
+     * that followed them, which is last where it has moved to.
+     * throw if either iterator is out of this or last comes before first.
+     */
+    iterator erase(iterator first, iterator last) {
+        if (this != first._map || this != last._map)
+            throw invalid_iterator();
+        size_t n = 0;
+        for (const_iterator it = first; it != last; ++it, n++)
+            if (it.l == nullptr)
+                throw invalid_iterator();
+        for (; n > 0; n--)
+            first = erase(first);
+        return first;
+    }
+    /**
+     * erase the element with the given key, if any.
+     * return the number of elements removed (0 or 1).
+     */
+    size_t erase(const Key &key) {
+        if (root == nullptr)
+            return 0;
+        path w;
+        leaf *l = descend(key, &w);
+        size_t i = leaf_lower(l, key);
+        if (i == l->n || cmp(key, l->value(i)->first))
+            return 0;
+        erase_at(l, i, w);
+        return 1;
+    }
+
+    size_t count(const Key &key) const {
+        return find_pos(key).first != nullptr ? 1 : 0;
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    size_t count(const K &key) const {
+        // a probe may be equivalent to several keys
+        size_t n = 0;
+        for (const_iterator i = lower_bound(key), e = upper_bound(key); i != e; ++i)
+            n++;
+        return n;
+    }
+    iterator find(const Key &key) {
+        return make_iterator(find_pos(key));
+    }
+    const_iterator find(const Key &key) const {
+        return make_iterator(find_pos(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    iterator find(const K &key) {
+        return make_iterator(find_pos(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator find(const K &key) const {
+        return make_iterator(find_pos(key));
+    }
+
+    // first element whose key is not less than key
+    iterator lower_bound(const Key &key) {
+        return make_iterator(lower_pos(key));
+    }
+    const_iterator lower_bound(const Key &key) const {
+        return make_iterator(lower_pos(key));
+    }
+    // first element whose key is greater than key
+    iterator upper_bound(const Key &key) {
+        return make_iterator(upper_pos(key));
+    }
+    const_iterator upper_bound(const Key &key) const {
+        return make_iterator(upper_pos(key));
+    }
+    pair<iterator, iterator> equal_range(const Key &key) {
+        return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+    }
+    pair<const_iterator, const_iterator> equal_range(const Key &key) const {
+        return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    iterator lower_bound(const K &key) {
+        return make_iterator(lower_pos(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator lower_bound(const K &key) const {
+        return make_iterator(lower_pos(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    iterator upper_bound(const K &key) {
+        return make_iterator(upper_pos(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator upper_bound(const K &key) const {
+        return make_iterator(upper_pos(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    pair<iterator, iterator> equal_range(const K &key) {
+        return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    pair<const_iterator, const_iterator> equal_range(const K &key) const {
+        return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+    }
+};
+
+template<class Key, class T, class Compare, class Allocator>
+void swap(btree_map<Key, T, Compare, Allocator> &a, btree_map<Key, T, Compare, Allocator> &b) noexcept {
+    a.swap(b);
+}
+
+}
+
+#endif
@@ -0,0 +1,340 @@
+#ifndef SJTU_CONCURRENT_MAP_HPP
+#define SJTU_CONCURRENT_MAP_HPP
+
+#include <atomic>
+#include <functional>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "map.hpp"
+
+namespace sjtu {
+
+/**
+ * a reader-writer spin lock in one word: bit 0 is set by a writer that holds
+ * the lock or waits for the readers to leave, and every reader adds 2.
+ * a waiting writer keeps new readers out, so writers are not starved.
+ */
+class rw_lock {
+    std::atomic<size_t> state;
+
+    static void pause() {
+        std::this_thread::yield();
+    }
+
+public:
+    rw_lock() : state(0) {}
+    rw_lock(const rw_lock &) = delete;
+    rw_lock &operator=(const rw_lock &) = delete;
+
+    void lock_shared() {
+        while (true) {
+            size_t s = state.load(std::memory_order_relaxed);
+            if (!(s & 1) && state.compare_exchange_weak(s, s + 2, std::memory_order_acquire))
+                return;
+            pause();
+        }
+    }
+    void unlock_shared() {
+        state.fetch_sub(2, std::memory_order_release);
+    }
+    void lock() {
+        while (true) {
+            size_t s = state.load(std::memory_order_relaxed);
+            if (!(s & 1) && state.compare_exchange_weak(s, s | 1, std::memory_order_acquire))
+                break;
+            pause();
+        }
+        while (state.load(std::memory_order_acquire) != 1)
+            pause();
+    }
+    void unlock() {
+        state.store(0, std::memory_order_release);
+    }
+
+    class read_guard {
+        rw_lock &l;
+
+    public:
+        explicit read_guard(rw_lock &_l) : l(_l) {
+            l.lock_shared();
+        }
+        ~read_guard() {
+            l.unlock_shared();
+        }
+    };
+    class write_guard {
+        rw_lock &l;
+
+    public:
+        explicit write_guard(rw_lock &_l) : l(_l) {
+            l.lock();
+        }
+        ~write_guard() {
+            l.unlock();
+        }
+    };
+};
+
+/**
+ * a thread-safe ordered map: keys are spread by Hash over a fixed number of
+ * sjtu::map shards, each behind its own rw_lock, so operations on keys of
+ * different shards never wait for each other.
+ *
+ * point operations report their result instead of returning iterators, which
+ * would outlive the lock. ordered traversal goes through snapshot(): every shard
+ * is copied under its read lock and the copies are merged into one sjtu::map,
+ * whose iterators behave as usual. each shard is copied at its own instant, so
+ * the snapshot is consistent per shard, not across shards.
+ */
+template<
+    class Key,
+    class T,
+    class Compare = std::less<Key>,
+    class Hash = std::hash<Key>,
+    class Allocator = std::allocator<pair<const Key, T>>
+> class concurrent_map {
+public:
+    typedef pair<const Key, T> value_type;
+    typedef Allocator allocator_type;
+    typedef map<Key, T, Compare, Allocator> map_type;
+    typedef typename map_type::const_iterator const_iterator;
+
+private:
+    struct shard {
+        char pad[64]; // keeps the lock away from the cache lines of the shard before
+        mutable rw_lock lock;
+        map_type m;
+
+        explicit shard(const Allocator &a) : m(a) {}
+    };
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<shard> shard_allocator;
+    typedef std::allocator_traits<shard_allocator> shard_traits;
+
+    shard *shards;
+    size_t n;
+    Hash hash;
+    shard_allocator alloc;
+
+    shard &shard_of(const Key &k) {
+        return shards[hash(k) % n];
+    }
+    const shard &shard_of(const Key &k) const {
+        return shards[hash(k) % n];
+    }
+
+    // walks a list of value pointers, moving the values out
+    class mover {
+    public:
+        typedef typename concurrent_map::value_type value_type;
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::ptrdiff_t      difference_type;
+        typedef value_type*         pointer;
+        typedef value_type&&        reference;
+
+    private:
+        value_type **p;
+
+    public:
+        explicit mover(value_type **_p) : p(_p) {}
+        reference operator*() const {
+            return std::move(**p);
+        }
+        mover &operator++() {
+            ++p;
+            return *this;
+        }
+        mover operator++(int) {
+            mover res(*this);
+            ++p;
+            return res;
+        }
+        bool operator==(const mover &o) const {
+            return p == o.p;
+        }
+        bool operator!=(const mover &o) const {
+            return p != o.p;
+        }
+    };
+    // the next element of one shard copy in the k-way merge
+    struct cursor {
+        typename map_type::iterator it;
+        size_t part;
+    };
+    // orders cursors so the smallest key comes out of a priority_queue first
+    struct later {
+        const key_order<Compare> *cmp;
+        bool operator()(const cursor &a, const cursor &b) const {
+            return (*cmp)(b.it->first, a.it->first);
+        }
+    };
+
+public:
+    static size_t default_shards() {
+        size_t c = std::thread::hardware_concurrency() * 4;
+        return c < 16 ? 16 : c;
+    }
+
+    explicit concurrent_map(size_t shard_count = default_shards(), const Allocator &a = Allocator())
+        : shards(nullptr), n(shard_count == 0 ? 1 : shard_count), hash(), alloc(a) {
+        shards = shard_traits::allocate(alloc, n);
+        size_t i = 0;
+        try {
+            for (; i < n; i++)
+                shard_traits::construct(alloc, shards + i, Allocator(a));
+        } catch (...) {
+            while (i > 0)
+                shard_traits::destroy(alloc, shards + --i);
+            shard_traits::deallocate(alloc, shards, n);
+            throw;
+        }
+    }
+    concurrent_map(const concurrent_map &) = delete;
+    concurrent_map &operator=(const concurrent_map &) = delete;
+    ~concurrent_map() {
+        for (size_t i = 0; i < n; i++)
+            shard_traits::destroy(alloc, shards + i);
+        shard_traits::deallocate(alloc, shards, n);
+    }
+
+    size_t shard_count() const {
+        return n;
+    }
+
+    /**
+     * insert value if its key is absent; return whether it was inserted.
+     */
+    bool insert(const value_type &value) {
+        shard &s = shard_of(value.first);
+        rw_lock::write_guard g(s.lock);
+        return s.m.insert(value).second;
+    }
+    bool insert(value_type &&value) {
+        shard &s = shard_of(value.first);
+        rw_lock::write_guard g(s.lock);
+        return s.m.insert(std::move(value)).second;
+    }
+    template<class... Args>
+    bool try_emplace(const Key &key, Args&&... args) {
+        shard &s = shard_of(key);
+        rw_lock::write_guard g(s.lock);
+        return s.m.try_emplace(key, std::forward<Args>(args)...).second;
+    }
+    // return true if a new element was inserted, false if the value was assigned
+    template<class M>
+    bool insert_or_assign(const Key &key, M &&obj) {
+        shard &s = shard_of(key);
+        rw_lock::write_guard g(s.lock);
+        return s.m.insert_or_assign(key, std::forward<M>(obj)).second;
+    }
+    size_t erase(const Key &key) {
+        shard &s = shard_of(key);
+        rw_lock::write_guard g(s.lock);
+        return s.m.erase(key);
+    }
+
+    size_t count(const Key &key) const {
+        const shard &s = shard_of(key);
+        rw_lock::read_guard g(s.lock);
+        return s.m.count(key);
+    }
+    /**
+     * a copy of the value mapped to key.
+     * throw index_out_of_bound if no such element exists.
+     */
+    T at(const Key &key) const {
+        const shard &s = shard_of(key);
+        rw_lock::read_guard g(s.lock);
+        return s.m.at(key);
+    }
+    /**
+     * call f(const value_type &) on the element with the given key, under the read
+     * lock of its shard; return whether the element exists.
+     */
+    template<class F>
+    bool visit(const Key &key, F f) const {
+        const shard &s = shard_of(key);
+        rw_lock::read_guard g(s.lock);
+        const_iterator it = s.m.find(key);
+        if (it == s.m.cend())
+            return false;
+        f(*it);
+        return true;
+    }
+    /**
+     * call f(T &) on the value mapped to key, under the write lock of its shard,
+     * so a read-modify-write is atomic; return whether the element exists.
+     */
+    template<class F>
+    bool update(const Key &key, F f) {
+        shard &s = shard_of(key);
+        rw_lock::write_guard g(s.lock);
+        typename map_type::iterator it = s.m.find(key);
+        if (it == s.m.end())
+            return false;
+        f(it->second);
+        return true;
+    }
+
+    // sizes are read shard by shard, so under concurrent updates the sum is approximate
+    size_t size() const {
+        size_t res = 0;
+        for (size_t i = 0; i < n; i++) {
+            rw_lock::read_guard g(shards[i].lock);
+            res += shards[i].m.size();
+        }
+        return res;
+    }
+    bool empty() const {
+        return size() == 0;
+    }
+    void clear() {
+        for (size_t i = 0; i < n; i++) {
+            rw_lock::write_guard g(shards[i].lock);
+            shards[i].m.clear();
+        }
+    }
+
+    /**
+     * an ordered copy of the whole map: the shards are copied one at a time under
+     * their read locks, then merged k ways into one sjtu::map outside every lock.
+     */
+    map_type snapshot() const {
+        std::vector<map_type> parts;
+        parts.reserve(n);
+        size_t total = 0;
+        for (size_t i = 0; i < n; i++) {
+            rw_lock::read_guard g(shards[i].lock);
+            parts.push_back(shards[i].m);
+            total += parts.back().size();
+        }
+
+        key_order<Compare> cmp;
+        later by_key = {&cmp};
+        std::priority_queue<cursor, std::vector<cursor>, later> heads(by_key);
+        for (size_t i = 0; i < n; i++)
+            if (!parts[i].empty())
+                heads.push(cursor{parts[i].begin(), i});
+        std::vector<value_type *> order;
+        order.reserve(total);
+        while (!heads.empty()) {
+            cursor c = heads.top();
+            heads.pop();
+            order.push_back(&*c.it);
+            if (++c.it != parts[c.part].end())
+                heads.push(c);
+        }
+        return map_type(sorted_unique, mover(order.data()), mover(order.data() + order.size()),
+                        Allocator(alloc));
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,144 @@
+#include<iostream>
+#include<map>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include<string>
+#include "map.hpp"
+
+using namespace std;
+
+bool check1(){ //lower_bound, upper_bound against std::map
+	sjtu::map<int, int> Q;
+	std::map<int, int> stdQ;
+	for(int i = 1; i <= 100000; i++){
+		int a = rand() % 200000 * 2, b = rand();
+		Q[a] = b; stdQ[a] = b;
+	}
+	for(int i = 1; i <= 100000; i++){
+		int a = rand() % 400010 - 5;
+		sjtu::map<int, int>::iterator it = Q.lower_bound(a);
+		std::map<int, int>::iterator stdit = stdQ.lower_bound(a);
+		if((it == Q.end()) != (stdit == stdQ.end())) return 0;
+		if(stdit != stdQ.end() && (it -> first != stdit -> first || it -> second != stdit -> second)) return 0;
+		it = Q.upper_bound(a);
+		stdit = stdQ.upper_bound(a);
+		if((it == Q.end()) != (stdit == stdQ.end())) return 0;
+		if(stdit != stdQ.end() && it -> first != stdit -> first) return 0;
+	}
+	return 1;
+}
+
+bool check2(){ //equal_range
+	sjtu::map<int, int> Q;
+	for(int i = 0; i < 1000; i++) Q[i * 3] = i;
+	for(int i = -3; i < 3003; i++){
+		sjtu::pair<sjtu::map<int, int>::iterator, sjtu::map<int, int>::iterator> r = Q.equal_range(i);
+		if(i >= 0 && i < 3000 && i % 3 == 0){
+			if(r.first == Q.end() || r.first -> first != i) return 0;
+			sjtu::map<int, int>::iterator nx = r.first; ++nx;
+			if(r.second != nx) return 0;
+		}
+		else{
+			if(r.first != r.second) return 0;
+			if(r.first != Q.lower_bound(i)) return 0;
+		}
+	}
+	return 1;
+}
+
+bool check3(){ //const versions and range scans
+	sjtu::map<int, int> Q;
+	std::map<int, int> stdQ;
+	for(int i = 1; i <= 10000; i++){
+		int a = rand() % 50000, b = rand();
+		Q[a] = b; stdQ[a] = b;
+	}
+	const sjtu::map<int, int> Qc(Q);
+	for(int i = 1; i <= 1000; i++){
+		int l = rand() % 50000, r = l + rand() % 1000;
+		long long s1 = 0, s2 = 0;
+		for(sjtu::map<int, int>::const_iterator it = Qc.lower_bound(l); it != Qc.upper_bound(r); ++it) s1 += it -> second;
+		for(std::map<int, int>::iterator it = stdQ.lower_bound(l); it != stdQ.upper_bound(r); ++it) s2 += it -> second;
+		if(s1 != s2) return 0;
+		sjtu::pair<sjtu::map<int, int>::const_iterator, sjtu::map<int, int>::const_iterator> e = Qc.equal_range(l);
+		if((e.first != Qc.cend() && e.first -> first == l) != (stdQ.count(l) == 1)) return 0;
+	}
+	return 1;
+}
+
+bool check4(){ //bounds on an empty map and past the ends
+	sjtu::map<int, int> Q;
+	if(Q.lower_bound(1) != Q.end() || Q.upper_bound(1) != Q.end()) return 0;
+	if(Q.equal_range(1).first != Q.end()) return 0;
+	Q[5] = 5;
+	if(Q.lower_bound(6) != Q.end() || Q.upper_bound(5) != Q.end()) return 0;
+	if(Q.lower_bound(-100) != Q.begin() || Q.upper_bound(4) != Q.begin()) return 0;
+	return 1;
+}
+
+bool check5(){ //string keys
+	sjtu::map<string, int> Q;
+	std::map<string, int> stdQ;
+	for(int i = 0; i < 10000; i++){
+		string s = "";
+		for(int j = rand() % 6; j >= 0; j--) s += char('a' + rand() % 26);
+		Q[s] = i; stdQ[s] = i;
+	}
+	for(int i = 0; i < 10000; i++){
+		string s = "";
+		for(int j = rand() % 6; j >= 0; j--) s += char('a' + rand() % 26);
+		sjtu::map<string, int>::iterator it = Q.upper_bound(s);
+		std::map<string, int>::iterator stdit = stdQ.upper_bound(s);
+		if((it == Q.end()) != (stdit == stdQ.end())) return 0;
+		if(stdit != stdQ.end() && it -> first != stdit -> first) return 0;
+	}
+	return 1;
+}
+
+//orders int keys against a decade, which stands for all ten keys from 10 * d on
+struct decade{
+	int d;
+};
+struct by_decade{
+	typedef void is_transparent;
+	bool operator()(int a, int b) const { return a < b; }
+	bool operator()(int a, decade b) const { return a < 10 * b.d; }
+	bool operator()(decade a, int b) const { return 10 * a.d + 9 < b; }
+};
+
+bool check6(){ //a transparent probe that matches many keys gets all of them
+	sjtu::map<int, int, by_decade> Q;
+	std::map<int, int> stdQ;
+	for(int i = 0; i < 3000; i++){
+		int a = rand() % 1000;
+		Q[a] = i; stdQ[a] = i;
+	}
+	const sjtu::map<int, int, by_decade> &Qc = Q;
+	for(int d = -2; d <= 101; d++){
+		decade p = {d};
+		std::map<int, int>::iterator first = stdQ.lower_bound(10 * d), last = stdQ.lower_bound(10 * d + 10);
+		size_t n = std::distance(first, last);
+		sjtu::pair<sjtu::map<int, int, by_decade>::iterator, sjtu::map<int, int, by_decade>::iterator> r = Q.equal_range(p);
+		sjtu::pair<sjtu::map<int, int, by_decade>::const_iterator, sjtu::map<int, int, by_decade>::const_iterator> cr = Qc.equal_range(p);
+		if(r.first != Q.lower_bound(p) || r.second != Q.upper_bound(p)) return 0;
+		if(cr.first != Qc.lower_bound(p) || cr.second != Qc.upper_bound(p)) return 0;
+		if((first == stdQ.end()) != (r.first == Q.end()) || (last == stdQ.end()) != (r.second == Q.end())) return 0;
+		size_t k = 0;
+		for(sjtu::map<int, int, by_decade>::iterator it = r.first; it != r.second; ++it, ++first, k++)
+			if(it -> first != first -> first || it -> second != first -> second) return 0;
+		if(k != n || Q.count(p) != n) return 0;
+	}
+	return 1;
+}
+
+int main(){
+	srand(time(NULL));
+	if(!check1()) cout << "Test 1 Failed......" << endl; else cout << "Test 1 Passed!" << endl;
+	if(!check2()) cout << "Test 2 Failed......" << endl; else cout << "Test 2 Passed!" << endl;
+	if(!check3()) cout << "Test 3 Failed......" << endl; else cout << "Test 3 Passed!" << endl;
+	if(!check4()) cout << "Test 4 Failed......" << endl; else cout << "Test 4 Passed!" << endl;
+	if(!check5()) cout << "Test 5 Failed......" << endl; else cout << "Test 5 Passed!" << endl;
+	if(!check6()) cout << "Test 6 Failed......" << endl; else cout << "Test 6 Passed!" << endl;
+	return 0;
+}
@@ -0,0 +1,118 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<string>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "map.hpp"
+#include "concurrent_map.hpp"
+
+using namespace std;
+
+long calls = 0;
+
+struct Less{ //the reference: an ordinary less-than
+	bool operator()(int a, int b) const { calls++; return a < b; }
+};
+struct Call{ //three-way through its call, which it declares
+	typedef void is_three_way;
+	int operator()(int a, int b) const { calls++; return a < b ? -1 : a > b; }
+};
+struct Member{ //three-way through compare(); its call is never needed
+	bool operator()(int a, int b) const { calls++; return a < b; }
+	long compare(int a, int b) const { calls++; return (long)a - b; }
+};
+
+struct IntLess{ //a less-than that returns int is still a less-than
+	int operator()(int a, int b) const { calls++; return a < b; }
+};
+
+template<class M>
+bool same(M &Q, const std::map<int, int> &stdQ){
+	if(Q.size() != stdQ.size()) return 0;
+	typename M::iterator it = Q.begin();
+	for(std::map<int, int>::const_iterator stdit = stdQ.begin(); stdit != stdQ.end(); ++stdit, ++it)
+		if(it -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	return it == Q.end();
+}
+
+template<class C>
+bool check(){ //every lookup and update agrees with std::map
+	typedef sjtu::map<int, int, C> smap;
+	smap Q;
+	std::map<int, int> stdQ;
+	for(int i = 0; i < 60000; i++){
+		int a = rand() % 20000 - 10000, b = rand();
+		switch(rand() % 8){
+		case 0: Q[a] = b; stdQ[a] = b; break;
+		case 1: Q.insert(sjtu::pair<const int, int>(a, b)); stdQ.insert(std::pair<int, int>(a, b)); break;
+		case 2: Q.insert(Q.upper_bound(a), sjtu::pair<const int, int>(a, b)); stdQ.insert(std::pair<int, int>(a, b)); break;
+		case 3: if(Q.erase(a) != stdQ.erase(a)) return 0; break;
+		case 4: {
+			typename smap::iterator it = Q.lower_bound(a);
+			std::map<int, int>::iterator stdit = stdQ.lower_bound(a);
+			if((it == Q.end()) != (stdit == stdQ.end()) || (it != Q.end() && it -> first != stdit -> first)) return 0;
+			break;
+		}
+		case 5: {
+			sjtu::pair<typename smap::iterator, typename smap::iterator> r = Q.equal_range(a);
+			std::pair<std::map<int, int>::iterator, std::map<int, int>::iterator> stdr = stdQ.equal_range(a);
+			if((r.first == Q.end()) != (stdr.first == stdQ.end()) || (r.second == Q.end()) != (stdr.second == stdQ.end())) return 0;
+			if(r.second != Q.end() && r.second -> first != stdr.second -> first) return 0;
+			break;
+		}
+		default: if(Q.count(a) != stdQ.count(a)) return 0;
+		}
+	}
+	if(!same(Q, stdQ)) return 0;
+
+	std::vector<typename smap::batch_op> ops;
+	for(int i = 0; i < 5000; i++){
+		int a = rand() % 20000 - 10000;
+		if(rand() % 2){ ops.push_back(typename smap::batch_op(a, a)); stdQ[a] = a; }
+		else{ ops.push_back(typename smap::batch_op(a)); stdQ.erase(a); }
+	}
+	Q.apply_batch(ops.begin(), ops.end());
+	if(!same(Q, stdQ)) return 0;
+	smap R;
+	std::map<int, int> stdR;
+	for(int i = 0; i < 5000; i++){ int a = rand() % 40000 - 20000; R[a] = 1; stdR[a] = 1; }
+	Q.merge_union(R);
+	stdQ.insert(stdR.begin(), stdR.end());
+	return same(Q, stdQ);
+}
+
+template<class C>
+long calls_per_find(int n){
+	sjtu::map<int, int, C> Q;
+	for(int i = 0; i < n; i++) Q[(int)(i * 2654435761u % 1000003)] = i;
+	calls = 0;
+	for(int i = 0; i < n; i++) Q.find((int)(i * 2654435761u % 1000003));
+	return calls;
+}
+
+bool check4(){ //a find costs about one call per level, never two
+	int n = 100000; //a red-black tree of n nodes is at most 34 levels tall
+	long l = calls_per_find<Less>(n), c = calls_per_find<Call>(n), m = calls_per_find<Member>(n);
+	return l <= 35L * n && c <= 34L * n && m == c && c < l;
+}
+
+bool check5(){ //a concurrent_map snapshot merges its shards by the three-way order
+	sjtu::concurrent_map<int, int, Call> Q(8);
+	std::map<int, int> stdQ;
+	for(int i = 0; i < 20000; i++){ int a = rand() % 50000 - 25000; Q.insert_or_assign(a, i); stdQ[a] = i; }
+	sjtu::map<int, int, Call> S = Q.snapshot();
+	return same(S, stdQ);
+}
+
+int main(){
+	srand(time(NULL));
+	if(!check<Less>()) cout << "Test 1 Failed......" << endl; else cout << "Test 1 Passed!" << endl;
+	if(!check<Call>()) cout << "Test 2 Failed......" << endl; else cout << "Test 2 Passed!" << endl;
+	if(!check<Member>()) cout << "Test 3 Failed......" << endl; else cout << "Test 3 Passed!" << endl;
+	if(!check4()) cout << "Test 4 Failed......" << endl; else cout << "Test 4 Passed!" << endl;
+	if(!check5()) cout << "Test 5 Failed......" << endl; else cout << "Test 5 Passed!" << endl;
+	if(!check<IntLess>()) cout << "Test 6 Failed......" << endl; else cout << "Test 6 Passed!" << endl;
+	return 0;
+}
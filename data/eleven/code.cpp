@@ -0,0 +1,213 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<string>
+#include<new>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "flat_map.hpp"
+#include<cassert>
+
+using namespace std;
+
+typedef sjtu::flat_map<int, int> fmap;
+
+class Integer {
+public:
+	static int counter;
+	int val;
+	Integer(int val) : val(val) { counter++; }
+	Integer(const Integer &rhs) : val(rhs.val) { counter++; }
+	Integer& operator = (const Integer &rhs) { assert(false); return *this; }
+	~Integer() { counter--; }
+};
+int Integer::counter = 0;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+
+bool check1(){ //random inserts and erases against std::map
+	fmap Q;
+	std::map<int, int> stdQ;
+	for(int i = 1; i <= 50000; i++){
+		int a = rand() % 5000, b = rand();
+		if(rand() % 3){
+			Q[a] = b; stdQ[a] = b;
+		}
+		else if(Q.erase(a) != stdQ.erase(a)) return 0;
+	}
+	if(Q.size() != stdQ.size()) return 0;
+	fmap::const_iterator it = Q.cbegin();
+	for(std::map<int, int>::iterator stdit = stdQ.begin(); stdit != stdQ.end(); ++stdit, ++it)
+		if(it -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	if(it != Q.cend()) return 0;
+	for(int i = 1; i <= 50000; i++){
+		int a = rand() % 5010 - 5;
+		fmap::iterator lo = Q.lower_bound(a), hi = Q.upper_bound(a);
+		std::map<int, int>::iterator stdlo = stdQ.lower_bound(a);
+		if((lo == Q.end()) != (stdlo == stdQ.end())) return 0;
+		if(stdlo != stdQ.end() && lo -> first != stdlo -> first) return 0;
+		if(hi - lo != (long)stdQ.count(a)) return 0;
+	}
+	return 1;
+}
+
+bool check2(){ //random access iterators and their checks
+	fmap Q;
+	for(int i = 0; i < 1000; i++) Q.insert(Q.end(), sjtu::pair<const int, int>(i * 2, i));
+	fmap::iterator it = Q.begin();
+	for(int i = 0; i < 1000; i += 7)
+		if(it[i].second != i || (it + i) -> first != i * 2) return 0;
+	if(Q.end() - Q.begin() != 1000 || !(Q.begin() < Q.end())) return 0;
+	try{
+		it -= 1;
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	try{
+		Q.end()++;
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	try{
+		Q.begin() + 1001;
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	fmap P;
+	try{
+		P.erase(Q.begin());
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	Q.erase(Q.begin() + 100, Q.begin() + 900);
+	if(Q.size() != 200 || Q.at(198) != 99 || Q.at(1800) != 900) return 0;
+	try{
+		Q.at(200);
+		return 0;
+	}catch(sjtu::index_out_of_bound){}
+	return 1;
+}
+
+bool check3(){ //bulk builds: unsorted range, sorted range and from sjtu::map
+	std::vector<sjtu::pair<int, int> > v;
+	for(int i = 0; i < 20000; i++) v.push_back(sjtu::pair<int, int>(rand() % 10000, i));
+	fmap Q(v.begin(), v.end());
+	std::map<int, int> stdQ;
+	for(size_t i = 0; i < v.size(); i++) stdQ.insert(std::make_pair(v[i].first, v[i].second));
+	if(Q.size() != stdQ.size()) return 0;
+	for(std::map<int, int>::iterator it = stdQ.begin(); it != stdQ.end(); ++it)
+		if(Q.at(it -> first) != it -> second) return 0;
+	sjtu::map<int, int> M;
+	for(int i = 0; i < 20000; i++) M[rand()] = i;
+	fmap F(M);
+	if(F.size() != M.size() || F.capacity() != M.size()) return 0;
+	sjtu::map<int, int>::const_iterator mit = M.cbegin();
+	for(fmap::iterator it = F.begin(); it != F.end(); ++it, ++mit)
+		if(it -> first != mit -> first || it -> second != mit -> second) return 0;
+	sjtu::map<int, int> back(sjtu::sorted_unique, F.begin(), F.end());
+	return back.size() == M.size() && back.cbegin() -> first == M.cbegin() -> first;
+}
+
+bool check4(){ //values that may not be assigned
+	{
+	sjtu::flat_map<Integer, Integer, Compare> Q;
+	for(int i = 0; i < 2000; i++) Q.insert(sjtu::pair<const Integer, Integer>(Integer(rand() % 1000), Integer(i)));
+	sjtu::flat_map<Integer, Integer, Compare> P(Q);
+	for(int i = 0; i < 1000; i += 2) P.erase(Integer(i));
+	for(int i = 1; i < 1000; i += 2) if(P.count(Integer(i)) != Q.count(Integer(i))) return 0;
+	P = Q;
+	if(P.size() != Q.size()) return 0;
+	}
+	return Integer::counter == 0;
+}
+
+bool check5(){ //try_emplace, insert_or_assign, clear and reuse
+	sjtu::flat_map<string, int> Q;
+	for(int i = 0; i < 3000; i++){
+		char s[16];
+		sprintf(s, "k%05d", i * 7 % 3000);
+		if(!Q.try_emplace(s, i).second) return 0;
+		if(Q.insert_or_assign(s, i + 1).second) return 0;
+	}
+	if(Q["k00007"] != 2) return 0;
+	size_t c = Q.capacity();
+	Q.clear();
+	if(!Q.empty() || Q.capacity() != c) return 0;
+	Q.shrink_to_fit();
+	return Q.capacity() == 0 && Q.begin() == Q.end();
+}
+
+//a key that counts its copies
+struct Tag{
+	static int copies;
+	int v;
+	Tag(int x = 0) : v(x) {}
+	Tag(const Tag &o) : v(o.v) { copies++; }
+	Tag(Tag &&o) noexcept : v(o.v) {}
+	bool operator<(const Tag &o) const { return v < o.v; }
+};
+int Tag::copies = 0;
+
+bool check6(){ //shifts and growth move keys, they do not copy them
+	sjtu::flat_map<Tag, string> Q;
+	for(int i = 1000; i > 0; i--) Q.try_emplace(Tag(i), "v");
+	for(int i = 0; i < 500; i++) Q.erase(Tag(rand() % 1000 + 1));
+	Q.emplace(Tag(0), "w");
+	Q.shrink_to_fit();
+	return Tag::copies == 0 && Q.begin() -> first.v == 0;
+}
+
+//a value whose copy throws when the countdown runs out, and which has no move of its own
+struct Fragile{
+	static int countdown, alive;
+	int v;
+	Fragile(int x) : v(x) { alive++; }
+	Fragile(const Fragile &o) : v(o.v) {
+		if(countdown > 0 && --countdown == 0) throw std::bad_alloc();
+		alive++;
+	}
+	~Fragile() { alive--; }
+};
+int Fragile::countdown = 0, Fragile::alive = 0;
+
+bool check7(){ //a copy that throws while shifting leaves the map as it was
+	{
+	sjtu::flat_map<int, Fragile> Q;
+	std::map<int, int> stdQ;
+	for(int i = 0; i < 300; i++){
+		int a = rand() % 1000;
+		if(Q.insert(sjtu::pair<const int, Fragile>(a, Fragile(i))).second) stdQ.insert(std::make_pair(a, i));
+	}
+	for(int round = 0; round < 300; round++){
+		int a = rand() % 1000;
+		Fragile::countdown = rand() % 300 + 1;
+		try{
+			if(rand() % 2 == 0){
+				if(Q.insert(sjtu::pair<const int, Fragile>(a, Fragile(round))).second) stdQ.insert(std::make_pair(a, round));
+			}else{
+				Q.erase(a), stdQ.erase(a);
+			}
+		}catch(std::bad_alloc &){}
+		Fragile::countdown = 0;
+		if(Q.size() != stdQ.size() || Fragile::alive != (int)stdQ.size()) return 0;
+		std::map<int, int>::iterator stdit = stdQ.begin();
+		for(sjtu::flat_map<int, Fragile>::iterator it = Q.begin(); it != Q.end(); ++it, ++stdit)
+			if(it -> first != stdit -> first || it -> second.v != stdit -> second) return 0;
+	}
+	}
+	return Fragile::alive == 0;
+}
+
+int main(){
+	srand(time(NULL));
+	if(!check1()) cout << "Test 1 Failed......" << endl; else cout << "Test 1 Passed!" << endl;
+	if(!check2()) cout << "Test 2 Failed......" << endl; else cout << "Test 2 Passed!" << endl;
+	if(!check3()) cout << "Test 3 Failed......" << endl; else cout << "Test 3 Passed!" << endl;
+	if(!check4()) cout << "Test 4 Failed......" << endl; else cout << "Test 4 Passed!" << endl;
+	if(!check5()) cout << "Test 5 Failed......" << endl; else cout << "Test 5 Passed!" << endl;
+	if(!check6()) cout << "Test 6 Failed......" << endl; else cout << "Test 6 Passed!" << endl;
+	if(!check7()) cout << "Test 7 Failed......" << endl; else cout << "Test 7 Passed!" << endl;
+	return 0;
+}
@@ -0,0 +1,145 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<string>
+#include<thread>
+#include<atomic>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "rcu_map.hpp"
+
+using namespace std;
+
+typedef sjtu::rcu_map<int, long long> rmap;
+
+bool check1(){ //the point operations against std::map
+	rmap Q;
+	std::map<int, long long> stdQ;
+	for(int i = 0; i < 20000; i++){
+		int a = rand() % 2000, b = rand();
+		switch(rand() % 4){
+			case 0: if(Q.insert(sjtu::pair<const int, long long>(a, b)) != stdQ.insert(std::make_pair(a, (long long)b)).second) return 0; break;
+			case 1: if(Q.insert_or_assign(a, b) != (stdQ.count(a) == 0)) return 0; stdQ[a] = b; break;
+			case 2: if(Q.erase(a) != stdQ.erase(a)) return 0; break;
+			default: if(Q.count(a) != stdQ.count(a)) return 0;
+		}
+	}
+	if(Q.size() != stdQ.size()) return 0;
+	for(std::map<int, long long>::iterator it = stdQ.begin(); it != stdQ.end(); ++it)
+		if(Q.at(it -> first) != it -> second) return 0;
+	try{
+		Q.at(-1);
+		return 0;
+	}catch(sjtu::index_out_of_bound){}
+	rmap::version_type S = Q.snapshot();
+	Q.clear();
+	if(!Q.empty() || S.size() != stdQ.size()) return 0;
+	std::map<int, long long>::iterator stdit = stdQ.begin();
+	for(rmap::const_iterator it = S.cbegin(); it != S.cend(); ++it, ++stdit)
+		if(it -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	return true;
+}
+
+bool check2(){ //a batch is seen whole or not at all
+	rmap Q;
+	Q.write([](rmap::version_type &v){ for(int i = 0; i < 1000; i++) v[i] = 0; });
+	std::atomic<bool> stop(false), ok(true);
+	vector<thread> th;
+	for(int t = 0; t < 3; t++)
+		th.push_back(thread([&Q, &stop, &ok](){
+			while(!stop){
+				rmap::view v = Q.read();
+				long long first = v -> cbegin() -> second;
+				size_t n = 0;
+				for(rmap::const_iterator it = v -> cbegin(); it != v -> cend(); ++it, n++)
+					if(it -> second != first) ok = false;
+				if(n != 1000) ok = false;
+			}
+		}));
+	for(long long r = 1; r <= 300; r++)
+		Q.write([r](rmap::version_type &v){ for(int i = 0; i < 1000; i += 3) v[i] = r; for(int i = 1; i < 1000; i += 3) v[i] = r; for(int i = 2; i < 1000; i += 3) v[i] = r; });
+	stop = true;
+	for(size_t i = 0; i < th.size(); i++) th[i].join();
+	return ok && Q.at(999) == 300;
+}
+
+bool check3(){ //readers race a writer that inserts, erases and updates
+	rmap Q;
+	for(int i = 0; i < 5000; i++) Q.insert(sjtu::pair<const int, long long>(i, 2 * i));
+	std::atomic<bool> stop(false), ok(true);
+	vector<thread> th;
+	for(int t = 0; t < 3; t++)
+		th.push_back(thread([&Q, &stop, &ok, t](){
+			unsigned s = t + 1;
+			while(!stop){
+				s = s * 1103515245 + 12345;
+				int a = (s >> 8) % 5000;
+				long long seen = -1;
+				if(Q.visit(a, [&seen](const sjtu::pair<const int, long long> &v){ seen = v.second; }) && seen % 2 != 0) ok = false;
+			}
+		}));
+	for(int i = 0; i < 20000; i++){
+		int a = rand() % 5000;
+		switch(i % 3){
+			case 0: Q.erase(a); break;
+			case 1: Q.try_emplace(a, 2 * a); break;
+			default: Q.update(a, [](long long &v){ v += 2; });
+		}
+	}
+	stop = true;
+	for(size_t i = 0; i < th.size(); i++) th[i].join();
+	return ok;
+}
+
+//std::allocator that counts the blocks it has handed out and not got back, across threads
+std::atomic<long long> blocks(0);
+template<class U>
+struct counting {
+	typedef U value_type;
+	counting() {}
+	template<class V> counting(const counting<V> &) {}
+	U *allocate(size_t n){ blocks++; return std::allocator<U>().allocate(n); }
+	void deallocate(U *p, size_t n){ blocks--; std::allocator<U>().deallocate(p, n); }
+	template<class V> bool operator==(const counting<V> &) const { return true; }
+	template<class V> bool operator!=(const counting<V> &) const { return false; }
+};
+
+bool check4(){ //replaced versions are freed as soon as no reader can see them
+	{
+	typedef sjtu::rcu_map<int, long long, std::less<int>, counting<sjtu::pair<const int, long long> > > cmap;
+	cmap Q;
+	//what the current version holds: its nodes and the version itself
+	long long base = blocks;
+	Q.write([](cmap::version_type &v){ for(int i = 0; i < 100000; i++) v.try_emplace(i, i); });
+	if(blocks != base + 100000) return 0;
+	Q.clear(); //no reader: the old version goes at once
+	if(blocks != base) return 0;
+	Q.write([](cmap::version_type &v){ for(int i = 0; i < 100000; i++) v.try_emplace(i, i); });
+	{
+		cmap::view held = Q.read();
+		Q.clear();
+		if(blocks != base + 1 + 100000 || held -> size() != 100000) return 0;
+	}
+	if(blocks != base) return 0; //freed when the reader let go
+	//a writer that retires a few versions and leaves them behind a reader, then exits
+	{
+		cmap::view held = Q.read();
+		thread w([&Q](){ for(int i = 0; i < 10; i++) Q.insert_or_assign(i, i); });
+		w.join();
+		if(blocks <= base + 10) return 0;
+	}
+	for(int i = 0; i < 64; i++) Q.count(i); //readers free them before long
+	if(blocks != base + 10 || Q.size() != 10) return 0;
+	}
+	return blocks == 0;
+}
+
+int main(){
+	srand(time(NULL));
+	if(!check1()) cout << "Test 1 Failed......" << endl; else cout << "Test 1 Passed!" << endl;
+	if(!check2()) cout << "Test 2 Failed......" << endl; else cout << "Test 2 Passed!" << endl;
+	if(!check3()) cout << "Test 3 Failed......" << endl; else cout << "Test 3 Passed!" << endl;
+	if(!check4()) cout << "Test 4 Failed......" << endl; else cout << "Test 4 Passed!" << endl;
+	return 0;
+}
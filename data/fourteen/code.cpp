@@ -0,0 +1,188 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<string>
+#include<thread>
+#include<atomic>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "skiplist_map.hpp"
+
+using namespace std;
+
+typedef sjtu::skiplist_map<int, long long> smap;
+
+struct lcg{
+	unsigned long long s;
+	explicit lcg(unsigned long long seed) : s(seed * 2 + 1) {}
+	int operator()(int n){ s = s * 6364136223846793005ull + 1442695040888963407ull; return (int)((s >> 33) % n); }
+};
+
+bool check1(){ //threads on disjoint keys, then an ordered walk
+	smap Q;
+	vector<thread> th;
+	for(int t = 0; t < 4; t++)
+		th.push_back(thread([&Q, t](){
+			for(int i = t; i < 40000; i += 4) Q.insert(sjtu::pair<const int, long long>(i, i));
+			for(int i = t; i < 40000; i += 8) Q.erase(i);
+		}));
+	for(size_t i = 0; i < th.size(); i++) th[i].join();
+	int expect = 0;
+	size_t n = 0;
+	for(smap::const_iterator it = Q.cbegin(); it != Q.cend(); ++it, n++){
+		while(expect % 8 < 4) expect++;
+		if(it -> first != expect || it -> second != expect) return 0;
+		expect++;
+	}
+	while(expect % 8 < 4) expect++;
+	return expect == 40000 + 4 && n == Q.size();
+}
+
+bool check2(){ //threads fighting over the same keys agree on what they did
+	smap Q;
+	std::atomic<long long> net(0);
+	vector<thread> th;
+	for(int t = 0; t < 4; t++)
+		th.push_back(thread([&Q, &net, t](){
+			lcg r(t + 1);
+			long long mine = 0;
+			for(int i = 0; i < 60000; i++){
+				int a = r(500);
+				if(r(2)) mine += Q.insert(sjtu::pair<const int, long long>(a, t)).second;
+				else mine -= Q.erase(a);
+			}
+			net += mine;
+		}));
+	for(size_t i = 0; i < th.size(); i++) th[i].join();
+	long long n = 0;
+	int last = -1;
+	for(smap::iterator it = Q.begin(); it != Q.end(); ++it, n++){
+		if(it -> first <= last) return 0;
+		last = it -> first;
+	}
+	return n == net && (size_t)n == Q.size();
+}
+
+bool check3(){ //the sjtu::map interface against std::map
+	smap Q;
+	std::map<int, long long> stdQ;
+	for(int i = 0; i < 30000; i++){
+		int a = rand() % 3000, b = rand();
+		switch(rand() % 4){
+			case 0: Q[a] = b; stdQ[a] = b; break;
+			case 1: if(Q.insert_or_assign(a, b).second != (stdQ.count(a) == 0)) return 0; stdQ[a] = b; break;
+			case 2: if(Q.erase(a) != stdQ.erase(a)) return 0; break;
+			default:
+				smap::iterator it = Q.lower_bound(a);
+				std::map<int, long long>::iterator stdit = stdQ.lower_bound(a);
+				if((it == Q.end()) != (stdit == stdQ.end())) return 0;
+				if(it != Q.end() && it -> first != stdit -> first) return 0;
+		}
+	}
+	if(Q.size() != stdQ.size()) return 0;
+	smap::const_iterator it = Q.cend();
+	for(std::map<int, long long>::reverse_iterator stdit = stdQ.rbegin(); stdit != stdQ.rend(); ++stdit)
+		if((--it) -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	try{
+		--it;
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	try{
+		Q.at(-1);
+		return 0;
+	}catch(sjtu::index_out_of_bound){}
+	try{
+		Q.erase(Q.end());
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	smap R(Q);
+	Q.clear();
+	if(!Q.empty() || Q.begin() != Q.end() || R.size() != stdQ.size()) return 0;
+	Q = R;
+	smap::iterator e = Q.find(stdQ.begin() -> first);
+	Q.erase(e);
+	try{
+		Q.erase(e);
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	return e -> first == stdQ.begin() -> first && Q.size() == stdQ.size() - 1 && Q.count(e -> first) == 0;
+}
+
+bool check4(){ //readers walk and hold iterators while writers erase under them
+	smap Q;
+	for(int i = 0; i < 20000; i++) Q[i] = i;
+	std::atomic<bool> stop(false), ok(true);
+	vector<thread> th;
+	for(int t = 0; t < 2; t++)
+		th.push_back(thread([&Q, t](){
+			lcg r(t + 7);
+			for(int i = 0; i < 100000; i++){
+				int a = r(20000);
+				if(Q.erase(a) == 0) Q.insert(sjtu::pair<const int, long long>(a, a));
+			}
+		}));
+	th.push_back(thread([&Q, &stop, &ok](){
+		while(!stop){
+			int last = -1;
+			smap::const_iterator held = Q.cbegin();
+			for(smap::const_iterator it = Q.cbegin(); it != Q.cend(); ++it){
+				if(it -> first <= last || it -> second != it -> first) ok = false;
+				last = it -> first;
+			}
+			if(held != Q.cend() && held -> second != held -> first) ok = false;
+		}
+	}));
+	th[0].join(), th[1].join();
+	stop = true;
+	th[2].join();
+	return ok;
+}
+
+//counts the values alive, across threads
+struct Live{
+	static std::atomic<int> alive;
+	long long v;
+	Live(long long x = 0) : v(x) { alive++; }
+	Live(const Live &o) : v(o.v) { alive++; }
+	~Live() { alive--; }
+};
+std::atomic<int> Live::alive(0);
+
+bool check5(){ //erased nodes are freed soon, whichever thread erased them
+	{
+	sjtu::skiplist_map<int, Live> Q;
+	for(int i = 0; i < 1000; i++) Q.try_emplace(i, i);
+	int base = Live::alive;
+	for(int i = 0; i < 60; i++) Q.erase(i * 7);
+	if(Live::alive != base - 60) return 0; //nobody else is pinned: freed at once
+	sjtu::skiplist_map<int, Live>::const_iterator held = Q.cbegin();
+	thread th([&Q](){
+		for(int i = 0; i < 30; i++) Q.erase(500 + i * 7);
+	});
+	th.join();
+	//the held iterator keeps the erased nodes after their thread is gone
+	if(Live::alive != base - 60 || Q.size() != 1000 - 90 || held -> second.v != held -> first) return 0;
+	held = Q.cend();
+	for(int i = 0; i < 64; i++) Q.count(i);
+	if(Live::alive != base - 90) return 0;
+	//threads come and go: each leaves its garbage behind, and the next ones free it
+	for(int t = 0; t < 50; t++){
+		thread w([&Q, t](){ Q.erase(800 + t), Q.try_emplace(2000 + t, t); });
+		w.join();
+	}
+	for(int i = 0; i < 64; i++) Q.count(i);
+	if(Live::alive != base - 90 || Q.size() != 1000 - 90) return 0;
+	}
+	return Live::alive == 0;
+}
+
+int main(){
+	srand(time(NULL));
+	if(!check1()) cout << "Test 1 Failed......" << endl; else cout << "Test 1 Passed!" << endl;
+	if(!check2()) cout << "Test 2 Failed......" << endl; else cout << "Test 2 Passed!" << endl;
+	if(!check3()) cout << "Test 3 Failed......" << endl; else cout << "Test 3 Passed!" << endl;
+	if(!check4()) cout << "Test 4 Failed......" << endl; else cout << "Test 4 Passed!" << endl;
+	if(!check5()) cout << "Test 5 Failed......" << endl; else cout << "Test 5 Passed!" << endl;
+	return 0;
+}
@@ -0,0 +1,112 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<iterator>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "map.hpp"
+
+using namespace std;
+
+typedef sjtu::ranked_map<int, int> rmap;
+
+bool check1(){ //select and rank against the keys of std::map
+	rmap Q;
+	std::map<int, int> stdQ;
+	for(int i = 1; i <= 100000; i++){
+		int a = rand() % 300000, b = rand();
+		Q[a] = b; stdQ[a] = b;
+	}
+	size_t k = 0;
+	for(std::map<int, int>::iterator it = stdQ.begin(); it != stdQ.end(); ++it, ++k){
+		if(Q.select(k) -> first != it -> first || Q.select(k) -> second != it -> second) return 0;
+		if(Q.rank(it -> first) != k) return 0;
+	}
+	try{
+		Q.select(Q.size());
+		return 0;
+	}catch(sjtu::index_out_of_bound){}
+	return 1;
+}
+
+bool check2(){ //rank and count_range after erasing
+	rmap Q;
+	std::map<int, int> stdQ;
+	for(int i = 1; i <= 50000; i++){
+		int a = rand() % 100000;
+		Q[a] = i; stdQ[a] = i;
+	}
+	for(int i = 1; i <= 20000; i++){
+		int a = rand() % 100000;
+		if(Q.erase(a) != stdQ.erase(a)) return 0;
+	}
+	for(int i = 1; i <= 1000; i++){
+		int lo = rand() % 100000, hi = lo + rand() % 1000;
+		size_t cnt = std::distance(stdQ.lower_bound(lo), stdQ.lower_bound(hi));
+		if(Q.count_range(lo, hi) != cnt) return 0;
+		if(Q.rank(lo) != (size_t)std::distance(stdQ.begin(), stdQ.lower_bound(lo))) return 0;
+	}
+	return 1;
+}
+
+bool check3(){ //iterator arithmetic
+	rmap Q;
+	for(int i = 0; i < 10000; i++) Q[i * 2] = i;
+	rmap::iterator it = Q.begin();
+	for(int i = 0; i < 1000; i++){
+		int d = rand() % 10000;
+		rmap::iterator jt = Q.begin() + d;
+		if(jt -> first != d * 2 || jt - Q.begin() != d || Q.end() - jt != 10000 - d) return 0;
+		if(Q.begin()[d].second != d) return 0;
+		std::advance(it, d - (it - Q.begin()));
+		if(it != jt) return 0;
+		if(std::distance(Q.cbegin(), rmap::const_iterator(jt)) != d) return 0;
+	}
+	try{
+		it = Q.end();
+		it += 1;
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	return 1;
+}
+
+bool check4(){ //range erase keeps ranks right
+	rmap Q;
+	std::vector<int> keys;
+	for(int i = 0; i < 20000; i++) Q[i] = i, keys.push_back(i);
+	for(int t = 0; t < 50 && Q.size() > 1; t++){
+		size_t a = rand() % Q.size(), b = rand() % Q.size();
+		if(a > b) std::swap(a, b);
+		Q.erase(Q.begin() + a, Q.begin() + b);
+		keys.erase(keys.begin() + a, keys.begin() + b);
+		if(Q.size() != keys.size()) return 0;
+		for(int i = 0; i < 100; i++){
+			size_t k = rand() % keys.size();
+			if(Q.select(k) -> first != keys[k] || Q.rank(keys[k]) != k) return 0;
+		}
+	}
+	return 1;
+}
+
+bool check5(){ //copy and sorted construction carry the sizes
+	std::vector<sjtu::pair<int, int> > v;
+	for(int i = 0; i < 10000; i++) v.push_back(sjtu::pair<int, int>(i * 5, i));
+	rmap Q(sjtu::sorted_unique, v.begin(), v.end());
+	rmap P(Q);
+	for(int i = 0; i < 10000; i++){
+		if(P.select(i) -> second != i || Q.select(i) -> second != i) return 0;
+		if(P.count_range(i * 5, i * 5 + 5) != 1) return 0;
+	}
+	return 1;
+}
+
+int main(){
+	srand(time(NULL));
+	if(!check1()) cout << "Test 1 Failed......" << endl; else cout << "Test 1 Passed!" << endl;
+	if(!check2()) cout << "Test 2 Failed......" << endl; else cout << "Test 2 Passed!" << endl;
+	if(!check3()) cout << "Test 3 Failed......" << endl; else cout << "Test 3 Passed!" << endl;
+	if(!check4()) cout << "Test 4 Failed......" << endl; else cout << "Test 4 Passed!" << endl;
+	if(!check5()) cout << "Test 5 Failed......" << endl; else cout << "Test 5 Passed!" << endl;
+	return 0;
+}
@@ -0,0 +1,132 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<string>
+#include<algorithm>
+#include<iterator>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "map.hpp"
+
+using namespace std;
+
+typedef sjtu::map<int, int> smap;
+
+bool same(const smap &Q, const std::map<int, int> &stdQ){
+	if(Q.size() != stdQ.size()) return 0;
+	smap::const_iterator it = Q.cbegin();
+	for(std::map<int, int>::const_iterator stdit = stdQ.begin(); stdit != stdQ.end(); ++stdit, ++it)
+		if(it -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	return it == Q.cend();
+}
+
+void fill(smap &Q, std::map<int, int> &stdQ, int n, int range){
+	for(int i = 0; i < n; i++){ int a = rand() % range; Q[a] = a * 2 + 1; stdQ[a] = a * 2 + 1; }
+}
+
+struct sum{ //adds their value to ours
+	void operator()(const int &, int &mine, const int &theirs) const { mine += theirs; }
+};
+
+bool check1(){ //every operation against std::map, on sizes that take both the merge and the finger paths
+	int sizes[][2] = {{3000, 3000}, {20000, 30}, {30, 20000}, {0, 500}, {500, 0}};
+	for(int k = 0; k < 5; k++) for(int op = 0; op < 4; op++){
+		smap Q, R;
+		std::map<int, int> stdQ, stdR, res;
+		fill(Q, stdQ, sizes[k][0], 40000);
+		fill(R, stdR, sizes[k][1], 40000);
+		switch(op){
+		case 0:
+			Q.merge_union(R, sum());
+			res = stdQ;
+			for(std::map<int, int>::iterator it = stdR.begin(); it != stdR.end(); ++it)
+				if(res.count(it -> first)) res[it -> first] += it -> second; else res.insert(*it);
+			break;
+		case 1:
+			Q.intersection(R, sum());
+			for(std::map<int, int>::iterator it = stdQ.begin(); it != stdQ.end(); ++it)
+				if(stdR.count(it -> first)) res[it -> first] = it -> second + stdR[it -> first];
+			break;
+		case 2:
+			Q.difference(R);
+			for(std::map<int, int>::iterator it = stdQ.begin(); it != stdQ.end(); ++it)
+				if(!stdR.count(it -> first)) res.insert(*it);
+			break;
+		default:
+			Q.symmetric_difference(R);
+			std::set_symmetric_difference(stdQ.begin(), stdQ.end(), stdR.begin(), stdR.end(),
+			                               std::inserter(res, res.end()), stdQ.value_comp());
+		}
+		if(!same(Q, res) || !same(R, stdR)) return 0;
+	}
+	return 1;
+}
+
+bool check2(){ //with itself
+	smap Q;
+	std::map<int, int> stdQ;
+	fill(Q, stdQ, 5000, 20000);
+	Q.merge_union(Q);
+	if(!same(Q, stdQ)) return 0;
+	Q.intersection(Q);
+	if(!same(Q, stdQ)) return 0;
+	smap P(Q);
+	P.difference(P);
+	Q.symmetric_difference(Q);
+	return P.empty() && Q.empty();
+}
+
+int budget = -1; //copies left before one throws; -1 for never
+
+struct Value{
+	string s;
+	explicit Value(const string &_s) : s(_s) {}
+	Value(const Value &o) : s(o.s) {
+		if(budget == 0) throw std::runtime_error("copy");
+		if(budget > 0) budget--;
+	}
+	Value(Value &&o) noexcept : s(std::move(o.s)) {}
+};
+
+bool intact(const sjtu::map<int, Value> &Q, int n){ //keys 0, 2, ..., each with its own string
+	int k = 0;
+	for(sjtu::map<int, Value>::const_iterator it = Q.cbegin(); it != Q.cend(); ++it){
+		if(it -> first % 2 == 0){
+			if(it -> first != 2 * k || it -> second.s != to_string(it -> first) + "!") return 0;
+			k++;
+		}
+	}
+	return k == n;
+}
+
+bool check3(){ //a copy that throws loses nothing, on the merge path and on the finger path
+	int sizes[][2] = {{500, 500}, {50000, 20}};
+	for(int k = 0; k < 2; k++) for(int op = 0; op < 2; op++){
+		sjtu::map<int, Value> Q, R;
+		int n = sizes[k][0], m = sizes[k][1];
+		for(int i = 0; i < n; i++) Q.insert(sjtu::pair<const int, Value>(2 * i, Value(to_string(2 * i) + "!")));
+		for(int i = 0; i < m; i++) R.insert(sjtu::pair<const int, Value>(2 * (rand() % n) + 1, Value("odd")));
+		budget = m / 5;
+		try{
+			if(op == 0) Q.merge_union(R); else Q.symmetric_difference(R);
+			budget = -1;
+			return 0;
+		}catch(std::runtime_error &){}
+		budget = -1;
+		if(!intact(Q, n)) return 0;
+		if(k == 0 && Q.size() != size_t(n)) return 0;
+		for(int i = 0; i < n; i++) Q.erase(2 * i + 1); //what the finger path added before the throw
+		if(op == 0) Q.merge_union(R); else Q.symmetric_difference(R);
+		if(!intact(Q, n) || Q.size() != size_t(n) + R.size()) return 0;
+	}
+	return 1;
+}
+
+int main(){
+	srand(time(NULL));
+	if(!check1()) cout << "Test 1 Failed......" << endl; else cout << "Test 1 Passed!" << endl;
+	if(!check2()) cout << "Test 2 Failed......" << endl; else cout << "Test 2 Passed!" << endl;
+	if(!check3()) cout << "Test 3 Failed......" << endl; else cout << "Test 3 Passed!" << endl;
+	return 0;
+}
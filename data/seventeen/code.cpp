@@ -0,0 +1,95 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "map.hpp"
+
+using namespace std;
+
+typedef sjtu::map<int, int, std::less<int>, std::allocator<sjtu::pair<const int, int> >, false, false> umap;
+typedef sjtu::map<int, int, std::less<int>, std::allocator<sjtu::pair<const int, int> >, true, false> uranked;
+
+//both directions, --end() included, agree with std::map
+template<class M>
+bool same(M &Q, const std::map<int, int> &stdQ){
+	if(Q.size() != stdQ.size()) return 0;
+	typename M::iterator it = Q.begin();
+	for(std::map<int, int>::const_iterator stdit = stdQ.begin(); stdit != stdQ.end(); ++stdit, ++it)
+		if(it == Q.end() || it -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	if(it != Q.end()) return 0;
+	typename M::const_iterator cit = Q.cend();
+	for(std::map<int, int>::const_reverse_iterator stdit = stdQ.rbegin(); stdit != stdQ.rend(); ++stdit)
+		if((--cit) -> first != stdit -> first) return 0;
+	return cit == Q.cbegin();
+}
+
+bool check1(){ //an unchecked map is a single pointer and behaves like std::map
+	if(sizeof(umap::iterator) != sizeof(void *) || sizeof(umap::const_iterator) != sizeof(void *)) return 0;
+	umap Q;
+	std::map<int, int> stdQ;
+	for(int i = 0; i < 100000; i++){
+		int a = rand() % 20000, b = rand();
+		switch(rand() % 4){
+		case 0: Q[a] = b; stdQ[a] = b; break;
+		case 1: Q.insert(Q.lower_bound(a), sjtu::pair<const int, int>(a, b)); stdQ.insert(std::pair<int, int>(a, b)); break;
+		case 2: {
+			umap::iterator it = Q.find(a);
+			if(it != Q.end()) Q.erase(it);
+			stdQ.erase(a);
+			break;
+		}
+		default: {
+			umap::const_iterator cit = Q.find(a);
+			std::map<int, int>::iterator stdit = stdQ.find(a);
+			if((cit == Q.cend()) != (stdit == stdQ.end())) return 0;
+			if(cit != Q.cend() && cit -> second != stdit -> second) return 0;
+		}
+		}
+	}
+	if(!same(Q, stdQ)) return 0;
+	umap::iterator first = Q.lower_bound(5000), last = Q.lower_bound(15000);
+	Q.erase(first, last);
+	stdQ.erase(stdQ.lower_bound(5000), stdQ.lower_bound(15000));
+	return same(Q, stdQ);
+}
+
+bool check2(){ //unchecked ranked iterators still do arithmetic
+	uranked Q;
+	std::vector<int> keys;
+	for(int i = 0; i < 50000; i++){
+		Q[i * 2] = i;
+		keys.push_back(i * 2);
+	}
+	for(int i = 0; i < 1000; i++){
+		int k = rand() % 50000, d = rand() % 50000 - k;
+		uranked::iterator it = Q.begin() + k;
+		if(it -> first != keys[k] || Q.select(k) != it) return 0;
+		uranked::const_iterator jt = it + d;
+		if(jt - it != d || (d > 0) != (jt > it)) return 0;
+		if(jt != Q.cend() && jt -> first != keys[k + d]) return 0;
+	}
+	return Q.end() - Q.begin() == 50000 && (Q.end() - 1) -> first == keys.back();
+}
+
+bool check3(){ //the default policy is checked
+	sjtu::map<int, int> Q, R;
+	Q[1] = 1;
+	R[1] = 1;
+	int caught = 0;
+	try{ sjtu::map<int, int>::iterator it = Q.end(); ++it; }catch(sjtu::invalid_iterator){ caught++; }
+	try{ sjtu::map<int, int>::iterator it = Q.begin(); --it; }catch(sjtu::invalid_iterator){ caught++; }
+	try{ sjtu::map<int, int>::const_iterator it = Q.cend(); it++; }catch(sjtu::invalid_iterator){ caught++; }
+	try{ Q.erase(R.begin()); }catch(sjtu::invalid_iterator){ caught++; }
+	try{ Q.erase(Q.end()); }catch(sjtu::invalid_iterator){ caught++; }
+	return caught == 5 && Q.begin() != R.begin() && Q.size() == 1 && R.size() == 1;
+}
+
+int main(){
+	srand(time(NULL));
+	if(!check1()) cout << "Test 1 Failed......" << endl; else cout << "Test 1 Passed!" << endl;
+	if(!check2()) cout << "Test 2 Failed......" << endl; else cout << "Test 2 Passed!" << endl;
+	if(!check3()) cout << "Test 3 Failed......" << endl; else cout << "Test 3 Passed!" << endl;
+	return 0;
+}
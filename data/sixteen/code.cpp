@@ -0,0 +1,159 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<string>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "map.hpp"
+
+using namespace std;
+
+typedef sjtu::map<int, int> smap;
+
+//both directions, with the reverse iterators and --end(), agree with std::map
+bool same(smap &Q, const std::map<int, int> &stdQ){
+	if(Q.size() != stdQ.size()) return 0;
+	smap::iterator it = Q.begin();
+	for(std::map<int, int>::const_iterator stdit = stdQ.begin(); stdit != stdQ.end(); ++stdit, ++it)
+		if(it == Q.end() || it -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	if(it != Q.end()) return 0;
+	smap::reverse_iterator rit = Q.rbegin();
+	for(std::map<int, int>::const_reverse_iterator stdit = stdQ.rbegin(); stdit != stdQ.rend(); ++stdit, ++rit)
+		if(rit == Q.rend() || rit -> first != stdit -> first) return 0;
+	if(rit != Q.rend()) return 0;
+	smap::const_reverse_iterator crit = Q.crbegin();
+	for(std::map<int, int>::const_reverse_iterator stdit = stdQ.rbegin(); stdit != stdQ.rend(); ++stdit, ++crit)
+		if(crit -> first != stdit -> first) return 0;
+	if(!stdQ.empty()){
+		smap::iterator last = Q.end();
+		--last;
+		if(last -> first != stdQ.rbegin() -> first) return 0;
+	}
+	return 1;
+}
+
+bool check1(){ //pop_front and pop_back against std::map
+	smap Q;
+	std::map<int, int> stdQ;
+	for(int i = 0; i < 100000; i++){
+		int a = rand() % 30000, b = rand();
+		switch(rand() % 5){
+			case 0: if(!stdQ.empty()){ Q.pop_front(); stdQ.erase(stdQ.begin()); } break;
+			case 1: if(!stdQ.empty()){ Q.pop_back(); stdQ.erase(--stdQ.end()); } break;
+			case 2: Q.erase(a); stdQ.erase(a); break;
+			default: Q[a] = b; stdQ[a] = b;
+		}
+		if(!stdQ.empty() && (Q.begin() -> first != stdQ.begin() -> first || Q.rbegin() -> first != stdQ.rbegin() -> first)) return 0;
+	}
+	if(!same(Q, stdQ)) return 0;
+	while(!Q.empty()) Q.pop_back();
+	try{
+		Q.pop_front();
+		return 0;
+	}catch(sjtu::container_is_empty){}
+	try{
+		Q.pop_back();
+		return 0;
+	}catch(sjtu::container_is_empty){}
+	try{
+		--Q.end();
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	return Q.rbegin() == Q.rend() && Q.begin() == Q.end();
+}
+
+bool check2(){ //the ends survive range erase, split and join
+	smap Q;
+	std::map<int, int> stdQ;
+	for(int i = 0; i < 20000; i++){ Q[i] = i; stdQ[i] = i; }
+	Q.erase(Q.find(100), Q.find(15000));
+	stdQ.erase(stdQ.find(100), stdQ.find(15000));
+	Q.erase(Q.find(19000), Q.end());
+	stdQ.erase(stdQ.find(19000), stdQ.end());
+	if(!same(Q, stdQ)) return 0;
+
+	smap R = Q.split(17000);
+	std::map<int, int> stdR(stdQ.lower_bound(17000), stdQ.end());
+	stdQ.erase(stdQ.lower_bound(17000), stdQ.end());
+	if(!same(Q, stdQ) || !same(R, stdR)) return 0;
+	smap S = Q.split(50);
+	std::map<int, int> stdS(stdQ.lower_bound(50), stdQ.end());
+	stdQ.erase(stdQ.lower_bound(50), stdQ.end());
+	if(!same(Q, stdQ) || !same(S, stdS)) return 0;
+
+	Q.join(std::move(S));
+	stdQ.insert(stdS.begin(), stdS.end());
+	stdS.clear();
+	if(!same(Q, stdQ) || !same(S, stdS)) return 0;
+	R.join(std::move(Q));
+	stdR.insert(stdQ.begin(), stdQ.end());
+	stdQ.clear();
+	if(!same(R, stdR)) return 0;
+	smap T = R.split(-1);
+	return same(T, stdR) && R.empty() && R.rbegin() == R.rend();
+}
+
+bool check3(){ //the ends survive set operations, batches, copies and moves
+	smap Q, R;
+	std::map<int, int> stdQ, stdR;
+	for(int i = 0; i < 5000; i++){
+		int a = rand() % 8000, b = rand() % 8000;
+		Q[a] = a; stdQ[a] = a;
+		R[b] = b; stdR[b] = b;
+	}
+	R[-5] = -5; stdR[-5] = -5;
+	R[9000] = 9000; stdR[9000] = 9000;
+	smap U(Q);
+	U.merge_union(R);
+	std::map<int, int> stdU(stdQ);
+	stdU.insert(stdR.begin(), stdR.end());
+	if(!same(U, stdU)) return 0;
+	smap I(Q);
+	I.intersection(R);
+	std::map<int, int> stdI;
+	for(std::map<int, int>::iterator it = stdQ.begin(); it != stdQ.end(); ++it)
+		if(stdR.count(it -> first)) stdI.insert(*it);
+	if(!same(I, stdI)) return 0;
+	smap D(R);
+	D.difference(Q);
+	std::map<int, int> stdD;
+	for(std::map<int, int>::iterator it = stdR.begin(); it != stdR.end(); ++it)
+		if(!stdQ.count(it -> first)) stdD.insert(*it);
+	if(!same(D, stdD)) return 0;
+
+	std::vector<smap::batch_op> ops;
+	for(int i = 0; i < 3000; i++){
+		int a = rand() % 10000 - 1000;
+		if(rand() % 2){ ops.push_back(smap::batch_op(a, a)); stdQ[a] = a; }
+		else{ ops.push_back(smap::batch_op(a)); stdQ.erase(a); }
+	}
+	Q.apply_batch(ops.begin(), ops.end());
+	if(!same(Q, stdQ)) return 0;
+
+	smap M(std::move(Q));
+	if(!same(M, stdQ)) return 0;
+	Q = M;
+	M.clear();
+	if(!same(Q, stdQ) || M.rbegin() != M.rend()) return 0;
+	M[1] = 1;
+	std::map<int, int> stdM;
+	stdM[1] = 1;
+	if(!same(M, stdM)) return 0;
+	std::vector<sjtu::pair<const int, int> > v;
+	for(int i = 0; i < 1000; i++) v.push_back(sjtu::pair<const int, int>(i * 3, i));
+	smap B(sjtu::sorted_unique, v.begin(), v.end());
+	std::map<int, int> stdB;
+	for(int i = 0; i < 1000; i++) stdB[i * 3] = i;
+	if(!same(B, stdB)) return 0;
+	B.swap(M);
+	return same(B, stdM) && same(M, stdB);
+}
+
+int main(){
+	srand(time(NULL));
+	if(!check1()) cout << "Test 1 Failed......" << endl; else cout << "Test 1 Passed!" << endl;
+	if(!check2()) cout << "Test 2 Failed......" << endl; else cout << "Test 2 Passed!" << endl;
+	if(!check3()) cout << "Test 3 Failed......" << endl; else cout << "Test 3 Passed!" << endl;
+	return 0;
+}
@@ -0,0 +1,280 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<string>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "btree_map.hpp"
+
+using namespace std;
+
+typedef sjtu::btree_map<int, int> bmap;
+
+template<class A, class B>
+bool same(const A &Q, const B &stdQ){
+	if(Q.size() != stdQ.size()) return 0;
+	typename A::const_iterator it = Q.cbegin();
+	for(typename B::const_iterator stdit = stdQ.begin(); stdit != stdQ.end(); ++stdit, ++it)
+		if(it == Q.cend() || it -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	return it == Q.cend();
+}
+
+bool check1(){ //random inserts and erases against std::map
+	bmap Q;
+	std::map<int, int> stdQ;
+	for(int i = 1; i <= 200000; i++){
+		int a = rand() % 20000, b = rand();
+		if(rand() % 3){
+			Q[a] = b; stdQ[a] = b;
+		}
+		else if(Q.erase(a) != stdQ.erase(a)) return 0;
+	}
+	if(!same(Q, stdQ)) return 0;
+	while(!stdQ.empty()){
+		int a = stdQ.begin() -> first;
+		Q.erase(Q.begin());
+		stdQ.erase(stdQ.begin());
+		if(Q.count(a)) return 0;
+	}
+	return Q.empty() && Q.begin() == Q.end();
+}
+
+bool check2(){ //bounds and walking backwards
+	bmap Q;
+	std::map<int, int> stdQ;
+	for(int i = 1; i <= 50000; i++){
+		int a = rand() % 100000 * 2, b = rand();
+		Q.insert(sjtu::pair<int, int>(a, b)); stdQ.insert(std::make_pair(a, b));
+	}
+	for(int i = 1; i <= 50000; i++){
+		int a = rand() % 200010 - 5;
+		bmap::iterator it = Q.lower_bound(a);
+		std::map<int, int>::iterator stdit = stdQ.lower_bound(a);
+		if((it == Q.end()) != (stdit == stdQ.end())) return 0;
+		if(stdit != stdQ.end() && it -> first != stdit -> first) return 0;
+		it = Q.upper_bound(a);
+		stdit = stdQ.upper_bound(a);
+		if((it == Q.end()) != (stdit == stdQ.end())) return 0;
+		if(stdit != stdQ.end() && it -> first != stdit -> first) return 0;
+	}
+	bmap::iterator it = Q.end();
+	for(std::map<int, int>::reverse_iterator stdit = stdQ.rbegin(); stdit != stdQ.rend(); ++stdit)
+		if((--it) -> first != stdit -> first) return 0;
+	if(it != Q.begin()) return 0;
+	try{
+		--it;
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	try{
+		Q.end()++;
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	return 1;
+}
+
+bool check3(){ //copy, assignment, swap and sorted construction
+	std::vector<sjtu::pair<int, int> > v;
+	for(int i = 0; i < 30000; i++) v.push_back(sjtu::pair<int, int>(i * 3, i));
+	bmap Q(sjtu::sorted_unique, v.begin(), v.end());
+	bmap P(Q), R;
+	R = P;
+	for(int i = 0; i < 30000; i += 2) P.erase(i * 3);
+	if(Q.size() != 30000 || R.size() != 30000 || P.size() != 15000) return 0;
+	for(int i = 0; i < 30000; i++){
+		if(Q.at(i * 3) != i || R.find(i * 3) == R.end()) return 0;
+		if(P.count(i * 3) != (size_t)(i % 2)) return 0;
+	}
+	P.swap(R);
+	if(P.size() != 30000 || R.size() != 15000) return 0;
+	bmap S(std::move(P));
+	if(S.size() != 30000 || !P.empty()) return 0;
+	try{
+		S.at(1);
+		return 0;
+	}catch(sjtu::index_out_of_bound){}
+	return 1;
+}
+
+bool check4(){ //range erase and keys that are not trivially copyable
+	sjtu::btree_map<string, int> Q;
+	std::map<string, int> stdQ;
+	for(int i = 0; i < 20000; i++){
+		char s[16];
+		sprintf(s, "k%07d", rand() % 100000);
+		Q[s] = i; stdQ[s] = i;
+	}
+	for(int i = 0; i < 50; i++){
+		char s[16], t[16];
+		int a = rand() % 100000;
+		sprintf(s, "k%07d", a);
+		sprintf(t, "k%07d", a + rand() % 3000);
+		Q.erase(Q.lower_bound(s), Q.lower_bound(t));
+		stdQ.erase(stdQ.lower_bound(s), stdQ.lower_bound(t));
+	}
+	if(!same(Q, stdQ)) return 0;
+	try{
+		Q.erase(Q.end());
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	sjtu::btree_map<string, int> P;
+	try{
+		P.erase(Q.begin());
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	Q.erase(Q.begin(), Q.end());
+	return Q.empty();
+}
+
+bool check5(){ //try_emplace, insert_or_assign and emplace
+	bmap Q;
+	for(int i = 0; i < 10000; i++){
+		if(!Q.try_emplace(i, i).second) return 0;
+		if(Q.try_emplace(i, -1).second) return 0;
+		if(Q.insert_or_assign(i, i * 2).second) return 0;
+		if(Q.emplace(i, 0).second) return 0;
+	}
+	for(int i = 0; i < 10000; i++)
+		if(Q[i] != i * 2) return 0;
+	return Q.emplace(-1, 7).first == Q.begin() && Q.size() == 10001;
+}
+
+bool check6(){ //erase returns where to go on, through every borrow and merge
+	bmap Q;
+	std::map<int, int> stdQ;
+	for(int i = 0; i < 30000; i++){ int a = rand() % 50000; Q[a] = i; stdQ[a] = i; }
+	bmap::iterator it = Q.begin();
+	std::map<int, int>::iterator stdit = stdQ.begin();
+	while(stdit != stdQ.end()){
+		if(it == Q.end() || it -> first != stdit -> first) return 0;
+		if(rand() % 3){ it = Q.erase(it); stdit = stdQ.erase(stdit); }
+		else{ ++it; ++stdit; }
+	}
+	if(it != Q.end() || !same(Q, stdQ)) return 0;
+	for(int i = 0; i < 100; i++){
+		int a = rand() % 50000, b = a + rand() % 2000;
+		bmap::iterator r = Q.erase(Q.lower_bound(a), Q.lower_bound(b));
+		std::map<int, int>::iterator stdr = stdQ.erase(stdQ.lower_bound(a), stdQ.lower_bound(b));
+		if((r == Q.end()) != (stdr == stdQ.end()) || (r != Q.end() && r -> first != stdr -> first)) return 0;
+	}
+	for(it = Q.begin(); it != Q.end();) it = Q.erase(it);
+	return same(Q, stdQ = std::map<int, int>()) && Q.empty();
+}
+
+//a key that counts its copies and moves
+struct Tag{
+	static long long copies, moves;
+	int v;
+	Tag(int x = 0) : v(x) {}
+	Tag(const Tag &o) : v(o.v) { copies++; }
+	Tag(Tag &&o) : v(o.v) { moves++; }
+	bool operator<(const Tag &o) const { return v < o.v; }
+};
+long long Tag::copies = 0, Tag::moves = 0;
+
+bool check7(){ //shifts, splits, borrows and merges move keys; only separators are copies
+	sjtu::btree_map<Tag, int> Q;
+	std::map<int, int> stdQ;
+	for(int i = 1000; i > 0; i--){ Q.try_emplace(Tag(i), i); stdQ[i] = i; }
+	long long inserted = Tag::copies;
+	if(inserted > 1000 / 4) return 0;
+	for(int i = 0; i < 2000; i++){
+		int a = rand() % 1000 + 1;
+		Q.erase(Tag(a)); stdQ.erase(a);
+	}
+	if(Tag::copies - inserted > 1000 / 2) return 0;
+	if(Q.size() != stdQ.size()) return 0;
+	std::map<int, int>::iterator stdit = stdQ.begin();
+	for(sjtu::btree_map<Tag, int>::iterator it = Q.begin(); it != Q.end(); ++it, ++stdit)
+		if(it -> first.v != stdit -> first || it -> second != stdit -> second) return 0;
+	return 1;
+}
+
+long long compared = 0;
+struct counting_less{
+	bool operator()(int a, int b) const { compared++; return a < b; }
+};
+
+bool check8(){ //hints and emplace
+	typedef sjtu::btree_map<int, int, counting_less> cmap;
+	cmap Q;
+	compared = 0;
+	for(int i = 0; i < 100000; i++) Q.insert(Q.cend(), sjtu::pair<const int, int>(i, i));
+	if(compared != 100000 - 1 || Q.size() != 100000) return 0;
+	compared = 0;
+	for(int i = 100000; i < 200000; i++) Q.emplace_hint(Q.end(), i, i);
+	if(compared != 100000 || Q.size() != 200000) return 0;
+	//a hint at the right place inside a leaf, a wrong one, and one on the key itself
+	cmap R;
+	std::map<int, int> stdR;
+	for(int i = 0; i < 3000; i++){ R[i * 4] = i; stdR[i * 4] = i; }
+	for(int i = 0; i < 3000; i++){
+		int a = rand() % 12000;
+		cmap::iterator hint = R.lower_bound(rand() % 3 == 0 ? rand() % 12000 : a);
+		cmap::iterator it = R.insert(hint, sjtu::pair<const int, int>(a, -a));
+		stdR.insert(std::make_pair(a, -a));
+		if(it -> first != a || it -> second != stdR[a]) return 0;
+	}
+	if(R.size() != stdR.size()) return 0;
+	std::map<int, int>::iterator stdit = stdR.begin();
+	for(cmap::iterator it = R.begin(); it != R.end(); ++it, ++stdit)
+		if(it -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	//emplace with a key builds nothing when the key is there
+	sjtu::btree_map<int, std::string> S;
+	S.emplace(1, "one");
+	std::string keep("kept");
+	if(S.emplace(1, std::move(keep)).second || keep != "kept" || S.at(1) != "one") return 0;
+	if(!S.emplace(sjtu::pair<const int, std::string>(2, "two")).second || S.at(2) != "two") return 0;
+	try{
+		sjtu::btree_map<int, std::string> other;
+		S.emplace_hint(other.cend(), 3, "three");
+		return 0;
+	}catch(...){}
+	return S.size() == 2;
+}
+
+//orders int keys against a decade, which stands for all ten keys from 10 * d on
+struct decade{
+	int d;
+};
+struct by_decade{
+	typedef void is_transparent;
+	bool operator()(int a, int b) const { return a < b; }
+	bool operator()(int a, decade b) const { return a < 10 * b.d; }
+	bool operator()(decade a, int b) const { return 10 * a.d + 9 < b; }
+};
+
+bool check9(){ //a transparent probe that matches a run of keys, across leaves
+	sjtu::btree_map<int, int, by_decade> Q;
+	std::map<int, int> stdQ;
+	for(int i = 0; i < 3000; i++){
+		int a = rand() % 1000;
+		Q[a] = i; stdQ[a] = i;
+	}
+	for(int d = -2; d <= 101; d++){
+		decade p = {d};
+		std::map<int, int>::iterator first = stdQ.lower_bound(10 * d), last = stdQ.lower_bound(10 * d + 10);
+		size_t n = std::distance(first, last);
+		sjtu::pair<sjtu::btree_map<int, int, by_decade>::iterator, sjtu::btree_map<int, int, by_decade>::iterator> r = Q.equal_range(p);
+		if((first == stdQ.end()) != (r.first == Q.end()) || (last == stdQ.end()) != (r.second == Q.end())) return 0;
+		size_t k = 0;
+		for(sjtu::btree_map<int, int, by_decade>::iterator it = r.first; it != r.second; ++it, ++first, k++)
+			if(it -> first != first -> first || it -> second != first -> second) return 0;
+		if(k != n || Q.count(p) != n) return 0;
+	}
+	return 1;
+}
+
+int main(){
+	srand(time(NULL));
+	if(!check1()) cout << "Test 1 Failed......" << endl; else cout << "Test 1 Passed!" << endl;
+	if(!check2()) cout << "Test 2 Failed......" << endl; else cout << "Test 2 Passed!" << endl;
+	if(!check3()) cout << "Test 3 Failed......" << endl; else cout << "Test 3 Passed!" << endl;
+	if(!check4()) cout << "Test 4 Failed......" << endl; else cout << "Test 4 Passed!" << endl;
+	if(!check5()) cout << "Test 5 Failed......" << endl; else cout << "Test 5 Passed!" << endl;
+	if(!check6()) cout << "Test 6 Failed......" << endl; else cout << "Test 6 Passed!" << endl;
+	if(!check7()) cout << "Test 7 Failed......" << endl; else cout << "Test 7 Passed!" << endl;
+	if(!check8()) cout << "Test 8 Failed......" << endl; else cout << "Test 8 Passed!" << endl;
+	if(!check9()) cout << "Test 9 Failed......" << endl; else cout << "Test 9 Passed!" << endl;
+	return 0;
+}
@@ -0,0 +1,107 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<string>
+#include<thread>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "concurrent_map.hpp"
+
+using namespace std;
+
+typedef sjtu::concurrent_map<int, long long> cmap;
+
+bool check1(){ //threads on disjoint keys, then an ordered snapshot
+	cmap Q(8);
+	vector<thread> th;
+	for(int t = 0; t < 4; t++)
+		th.push_back(thread([&Q, t](){
+			for(int i = t; i < 40000; i += 4) Q.insert(sjtu::pair<const int, long long>(i, i));
+			for(int i = t; i < 40000; i += 8) Q.erase(i);
+		}));
+	for(size_t i = 0; i < th.size(); i++) th[i].join();
+	cmap::map_type S = Q.snapshot();
+	if(S.size() != Q.size()) return 0;
+	int expect = 0;
+	for(cmap::const_iterator it = S.cbegin(); it != S.cend(); ++it){
+		while(expect % 8 < 4) expect++;
+		if(it -> first != expect || it -> second != expect) return 0;
+		expect++;
+	}
+	while(expect % 8 < 4) expect++;
+	return expect == 40000 + 4;
+}
+
+bool check2(){ //read-modify-write on shared keys from many threads
+	cmap Q;
+	for(int i = 0; i < 100; i++) Q.try_emplace(i, 0);
+	vector<thread> th;
+	for(int t = 0; t < 4; t++)
+		th.push_back(thread([&Q](){
+			for(int r = 0; r < 2000; r++)
+				for(int i = 0; i < 100; i += 7) Q.update(i, [](long long &v){ v++; });
+		}));
+	for(size_t i = 0; i < th.size(); i++) th[i].join();
+	for(int i = 0; i < 100; i++){
+		long long seen = -1;
+		if(!Q.visit(i, [&seen](const sjtu::pair<const int, long long> &v){ seen = v.second; })) return 0;
+		if(seen != (i % 7 ? 0 : 8000)) return 0;
+	}
+	return !Q.update(1000, [](long long &v){ v++; });
+}
+
+bool check3(){ //the point operations against std::map
+	cmap Q(5);
+	std::map<int, long long> stdQ;
+	for(int i = 0; i < 20000; i++){
+		int a = rand() % 3000, b = rand();
+		switch(rand() % 3){
+			case 0: if(Q.insert_or_assign(a, b) != (stdQ.count(a) == 0)) return 0; stdQ[a] = b; break;
+			case 1: if(Q.erase(a) != stdQ.erase(a)) return 0; break;
+			default: if(Q.count(a) != stdQ.count(a)) return 0;
+		}
+	}
+	for(std::map<int, long long>::iterator it = stdQ.begin(); it != stdQ.end(); ++it)
+		if(Q.at(it -> first) != it -> second) return 0;
+	try{
+		Q.at(-1);
+		return 0;
+	}catch(sjtu::index_out_of_bound){}
+	cmap::map_type S = Q.snapshot();
+	cmap::const_iterator it = S.cend();
+	for(std::map<int, long long>::reverse_iterator stdit = stdQ.rbegin(); stdit != stdQ.rend(); ++stdit)
+		if((--it) -> first != stdit -> first) return 0;
+	Q.clear();
+	return Q.empty() && S.size() == stdQ.size();
+}
+
+bool check4(){ //snapshots taken while writers run stay sorted and unique
+	cmap Q;
+	thread w([&Q](){
+		for(int i = 0; i < 200000; i++){
+			Q.insert_or_assign(rand() % 50000, i);
+			if(i % 3 == 0) Q.erase(rand() % 50000);
+		}
+	});
+	bool ok = true;
+	for(int r = 0; r < 5; r++){
+		cmap::map_type S = Q.snapshot();
+		int last = -1;
+		for(cmap::const_iterator it = S.cbegin(); it != S.cend(); ++it){
+			if(it -> first <= last) ok = false;
+			last = it -> first;
+		}
+	}
+	w.join();
+	return ok;
+}
+
+int main(){
+	srand(time(NULL));
+	if(!check1()) cout << "Test 1 Failed......" << endl; else cout << "Test 1 Passed!" << endl;
+	if(!check2()) cout << "Test 2 Failed......" << endl; else cout << "Test 2 Passed!" << endl;
+	if(!check3()) cout << "Test 3 Failed......" << endl; else cout << "Test 3 Passed!" << endl;
+	if(!check4()) cout << "Test 4 Failed......" << endl; else cout << "Test 4 Passed!" << endl;
+	return 0;
+}
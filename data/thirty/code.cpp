@@ -0,0 +1,179 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<memory>
+#include<utility>
+#include<type_traits>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "map.hpp"
+
+using namespace std;
+
+//counts how often a value is copied or moved, and how many are alive
+class Counted {
+public:
+	static int alive, copied, moved;
+	int data;
+	Counted(int value = 0) : data(value) { ++alive; }
+	Counted(const Counted &other) : data(other.data) { ++alive; ++copied; }
+	Counted(Counted &&other) : data(other.data) { ++alive; ++moved; }
+	Counted &operator=(const Counted &other) { data = other.data; ++copied; return *this; }
+	Counted &operator=(Counted &&other) { data = other.data; ++moved; return *this; }
+	~Counted() { --alive; }
+};
+int Counted::alive = 0, Counted::copied = 0, Counted::moved = 0;
+
+//std::allocator under an id: those of different id compare unequal and never propagate
+template<class U>
+struct tagged {
+	typedef U value_type;
+	int id;
+	tagged(int i = 0) : id(i) {}
+	template<class V> tagged(const tagged<V> &o) : id(o.id) {}
+	U *allocate(size_t n){ return std::allocator<U>().allocate(n); }
+	void deallocate(U *p, size_t n){ std::allocator<U>().deallocate(p, n); }
+	template<class V> bool operator==(const tagged<V> &o) const { return id == o.id; }
+	template<class V> bool operator!=(const tagged<V> &o) const { return id != o.id; }
+};
+
+typedef sjtu::map<int, Counted> smap;
+typedef sjtu::map<int, Counted, std::less<int>, std::allocator<sjtu::pair<const int, Counted> >, true> rmap;
+typedef sjtu::map<int, Counted, std::less<int>, tagged<sjtu::pair<const int, Counted> > > tmap;
+
+template<class M>
+bool same(const M &Q, const std::map<int, int> &stdQ){
+	if(Q.size() != stdQ.size()) return 0;
+	typename M::const_iterator it = Q.cbegin();
+	for(std::map<int, int>::const_iterator stdit = stdQ.begin(); stdit != stdQ.end(); ++stdit, ++it)
+		if(it -> first != stdit -> first || it -> second.data != stdit -> second) return 0;
+	if(it != Q.cend()) return 0;
+	for(std::map<int, int>::const_reverse_iterator stdit = stdQ.rbegin(); stdit != stdQ.rend(); ++stdit)
+		if((--it) -> first != stdit -> first) return 0;
+	return true;
+}
+
+template<class M>
+void fill(M &Q, std::map<int, int> &stdQ, int n){
+	for(int i = 0; i < n; i++){ int a = rand() % (4 * n); Q.insert_or_assign(a, Counted(i)); stdQ[a] = i; }
+}
+
+//a moved-from map is empty and works like a new one
+template<class M>
+bool reusable(M &Q){
+	if(!Q.empty() || Q.size() != 0 || Q.begin() != Q.end() || Q.find(1) != Q.end() || Q.count(1) != 0) return 0;
+	std::map<int, int> stdQ;
+	fill(Q, stdQ, 500);
+	if(!same(Q, stdQ)) return 0;
+	for(int i = 0; i < 2000; i++){ Q.erase(i); stdQ.erase(i); }
+	if(!same(Q, stdQ)) return 0;
+	M R(Q);
+	Q.clear();
+	return Q.empty() && same(R, stdQ);
+}
+
+template<class M>
+bool moves(){ //moving hands the nodes over in O(1), and the source can be used again
+	M A;
+	std::map<int, int> stdA;
+	fill(A, stdA, 2000);
+	const sjtu::pair<const int, Counted> *first = &*A.begin();
+	int copied = Counted::copied, moved = Counted::moved;
+	M B(std::move(A));
+	if(Counted::copied != copied || Counted::moved != moved || &*B.begin() != first || !same(B, stdA)) return 0;
+	if(!reusable(A)) return 0;
+	M C;
+	std::map<int, int> stdC;
+	fill(C, stdC, 300);
+	copied = Counted::copied, moved = Counted::moved;
+	C = std::move(B);
+	if(Counted::copied != copied || Counted::moved != moved || &*C.begin() != first || !same(C, stdA)) return 0;
+	if(!reusable(B)) return 0;
+	C = std::move(C); //moving into itself changes nothing
+	if(!same(C, stdA)) return 0;
+	M D;
+	std::map<int, int> stdD;
+	fill(D, stdD, 100);
+	copied = Counted::copied, moved = Counted::moved;
+	D = std::move(A); //from a map that was moved from and reused
+	if(Counted::copied != copied || Counted::moved != moved || D.size() != 0) return 0;
+	return reusable(A);
+}
+
+template<class M>
+bool swaps(){ //swap exchanges the trees in O(1)
+	M A, B;
+	std::map<int, int> stdA, stdB;
+	fill(A, stdA, 1000), fill(B, stdB, 10);
+	const sjtu::pair<const int, Counted> *a = &*A.begin(), *b = &*B.begin();
+	int copied = Counted::copied, moved = Counted::moved;
+	A.swap(B);
+	if(!same(A, stdB) || !same(B, stdA) || &*A.begin() != b || &*B.begin() != a) return 0;
+	swap(A, B);
+	if(!same(A, stdA) || !same(B, stdB)) return 0;
+	M E;
+	E.swap(A); //with an empty map, and back through one that was moved from
+	if(!A.empty() || !same(E, stdA)) return 0;
+	M F(std::move(E));
+	E.swap(F);
+	if(!F.empty() || !same(E, stdA)) return 0;
+	return Counted::copied == copied && Counted::moved == moved && reusable(F);
+}
+
+template<class M>
+bool grows(){ //a std::vector of maps moves them when it grows: no element is copied or moved
+	std::vector<M> v;
+	std::vector<std::map<int, int> > stdv;
+	int copied = Counted::copied, moved = Counted::moved;
+	for(int i = 0; i < 100; i++){
+		v.push_back(M());
+		stdv.push_back(std::map<int, int>());
+		for(int k = 0; k < 50; k++){ v.back().try_emplace(k * 7 + i, k); stdv.back()[k * 7 + i] = k; }
+	}
+	if(Counted::copied != copied || Counted::moved != moved) return 0;
+	for(int i = 0; i < 100; i++) if(!same(v[i], stdv[i])) return 0;
+	v.erase(v.begin() + 10); //move assignment shifts the rest down
+	stdv.erase(stdv.begin() + 10);
+	if(Counted::copied != copied || Counted::moved != moved) return 0;
+	for(int i = 0; i < 99; i++) if(!same(v[i], stdv[i])) return 0;
+	return 1;
+}
+
+bool check1(){ //move construction and assignment
+	return moves<smap>() && moves<rmap>() && Counted::alive == 0;
+}
+
+bool check2(){ //swap
+	return swaps<smap>() && swaps<rmap>() && Counted::alive == 0;
+}
+
+bool check3(){ //vector growth
+	return std::is_nothrow_move_constructible<smap>::value && std::is_nothrow_move_constructible<rmap>::value &&
+		grows<smap>() && grows<rmap>() && Counted::alive == 0;
+}
+
+bool check4(){ //move assignment between unequal allocators that do not propagate moves every value once
+	{
+		tmap A(tmap::allocator_type(1)), B(tmap::allocator_type(2));
+		std::map<int, int> stdA, stdB;
+		fill(A, stdA, 1000), fill(B, stdB, 300);
+		const sjtu::pair<const int, Counted> *first = &*A.begin();
+		int copied = Counted::copied, moved = Counted::moved;
+		B = std::move(A);
+		if(B.get_allocator().id != 2 || A.get_allocator().id != 1 || &*B.begin() == first) return 0;
+		if(Counted::copied != copied || Counted::moved != moved + (int)stdA.size()) return 0;
+		if(!same(B, stdA) || !reusable(A)) return 0;
+	}
+	return Counted::alive == 0;
+}
+
+int main(){
+	srand(time(0));
+	bool (*checks[])() = {check1, check2, check3, check4};
+	for(int i = 0; i < 4; i++){
+		if(checks[i]()) printf("Test %d Passed!\n", i + 1);
+		else printf("Test %d Failed!\n", i + 1);
+	}
+	return 0;
+}
@@ -0,0 +1,137 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include<cassert>
+#include "persistent_map.hpp"
+
+using namespace std;
+
+typedef sjtu::persistent_map<int, int> pmap;
+
+class Integer {
+public:
+	static int counter;
+	int val;
+	Integer(int val) : val(val) { counter++; }
+	Integer(const Integer &rhs) : val(rhs.val) { counter++; }
+	Integer& operator = (const Integer &rhs) { assert(false); return *this; }
+	~Integer() { counter--; }
+};
+int Integer::counter = 0;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+
+template<class A, class B>
+bool same(const A &Q, const B &stdQ){
+	if(Q.size() != stdQ.size()) return 0;
+	typename A::const_iterator it = Q.cbegin();
+	for(typename B::const_iterator stdit = stdQ.begin(); stdit != stdQ.end(); ++stdit, ++it)
+		if(it == Q.cend() || it -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	return it == Q.cend();
+}
+
+bool check1(){ //random inserts and erases against std::map
+	pmap Q;
+	std::map<int, int> stdQ;
+	for(int i = 1; i <= 100000; i++){
+		int a = rand() % 10000, b = rand();
+		if(rand() % 3){
+			Q[a] = b; stdQ[a] = b;
+		}
+		else if(Q.erase(a) != stdQ.erase(a)) return 0;
+	}
+	return same(Q, stdQ);
+}
+
+bool check2(){ //snapshots keep their content while the original changes
+	pmap Q;
+	std::map<int, int> stdQ;
+	std::vector<pmap> snaps;
+	std::vector<std::map<int, int> > stdsnaps;
+	for(int r = 0; r < 50; r++){
+		for(int i = 0; i < 500; i++){
+			int a = rand() % 3000, b = rand();
+			if(rand() % 4){
+				Q.insert_or_assign(a, b); stdQ[a] = b;
+			}
+			else{
+				Q.erase(a); stdQ.erase(a);
+			}
+		}
+		snaps.push_back(Q);
+		stdsnaps.push_back(stdQ);
+	}
+	for(int r = 0; r < 50; r++){
+		if(!same(snaps[r], stdsnaps[r])) return 0;
+		snaps[r].at(snaps[r].begin() -> first) = -r;
+		stdsnaps[r][stdsnaps[r].begin() -> first] = -r;
+	}
+	for(int r = 0; r < 50; r++)
+		if(!same(snaps[r], stdsnaps[r])) return 0;
+	return same(Q, stdQ);
+}
+
+bool check3(){ //bounds, walking backwards and the iterator checks
+	std::vector<sjtu::pair<int, int> > v;
+	for(int i = 0; i < 20000; i++) v.push_back(sjtu::pair<int, int>(i * 2, i));
+	pmap Q(sjtu::sorted_unique, v.begin(), v.end());
+	for(int i = -3; i < 40003; i++){
+		pmap::const_iterator lo = Q.lower_bound(i), hi = Q.upper_bound(i);
+		if(i < 0){ if(lo != Q.begin() || hi != Q.begin()) return 0; continue; }
+		if(i >= 39999){ if(lo != Q.end() || hi != Q.end()) return 0; continue; }
+		if(lo -> first != (i + 1) / 2 * 2) return 0;
+		if(i == 39998 ? hi != Q.end() : hi -> first != i / 2 * 2 + 2) return 0;
+	}
+	pmap::const_iterator it = Q.end();
+	for(int i = 19999; i >= 0; i--)
+		if((--it) -> second != i) return 0;
+	try{
+		--it;
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	try{
+		Q.end()++;
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	pmap P(Q);
+	try{
+		P.erase(Q.begin());
+		return 0;
+	}catch(sjtu::invalid_iterator){}
+	P.erase(P.find(100));
+	return P.size() == 19999 && Q.count(100) && !P.count(100);
+}
+
+bool check4(){ //no value is assigned, copied needlessly or leaked
+	{
+	sjtu::persistent_map<Integer, Integer, Compare> Q;
+	for(int i = 0; i < 1000; i++) Q.insert(sjtu::pair<const Integer, Integer>(Integer(i), Integer(i)));
+	int before = Integer::counter;
+	sjtu::persistent_map<Integer, Integer, Compare> P(Q), R;
+	R = P;
+	if(Integer::counter != before) return 0;
+	P.erase(Integer(500));
+	if(Integer::counter - before > 2 * 2 * 15) return 0;
+	R.clear();
+	Q = R;
+	if(P.size() != 999 || Q.size() != 0) return 0;
+	}
+	return Integer::counter == 0;
+}
+
+int main(){
+	srand(time(NULL));
+	if(!check1()) cout << "Test 1 Failed......" << endl; else cout << "Test 1 Passed!" << endl;
+	if(!check2()) cout << "Test 2 Failed......" << endl; else cout << "Test 2 Passed!" << endl;
+	if(!check3()) cout << "Test 3 Failed......" << endl; else cout << "Test 3 Passed!" << endl;
+	if(!check4()) cout << "Test 4 Failed......" << endl; else cout << "Test 4 Passed!" << endl;
+	return 0;
+}
@@ -0,0 +1,140 @@
+#include<iostream>
+#include<map>
+#include<string>
+#include<stdexcept>
+#include<thread>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "map.hpp"
+
+using namespace std;
+
+const int N = 1 << 17; //over the size at which parallel_copy may use two threads
+
+//counts its copies in a plain static, as class-integer.hpp does, and notes copies made off the main thread
+class Counted {
+public:
+	static int counter;
+	static std::thread::id owner;
+	static bool elsewhere;
+	int data;
+	Counted(int value) : data(value) { ++counter; }
+	Counted(const Counted &other) : data(other.data) {
+		++counter;
+		if(std::this_thread::get_id() != owner) elsewhere = true;
+	}
+	~Counted() { --counter; }
+};
+int Counted::counter = 0;
+std::thread::id Counted::owner;
+bool Counted::elsewhere = false;
+
+template<class M>
+bool same(const M &Q, const std::map<int, std::string> &stdQ){
+	if(Q.size() != stdQ.size()) return 0;
+	typename M::const_iterator it = Q.cbegin();
+	for(std::map<int, std::string>::const_iterator stdit = stdQ.begin(); stdit != stdQ.end(); ++stdit, ++it)
+		if(it -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	return it == Q.cend();
+}
+
+bool check1(){ //the plain copy constructor and assignment copy on the calling thread only
+	Counted::owner = std::this_thread::get_id();
+	Counted::elsewhere = false;
+	{
+		sjtu::map<int, Counted> Q;
+		for(int i = 0; i < N; i++) Q.insert(sjtu::pair<const int, Counted>(i, Counted(i * 3)));
+		int before = Counted::counter;
+		sjtu::map<int, Counted> R(Q);
+		if(Counted::counter != 2 * before) return 0;
+		sjtu::map<int, Counted> S;
+		S = R;
+		if(Counted::counter != 3 * before || Counted::elsewhere) return 0;
+		sjtu::map<int, Counted>::const_iterator it = S.cbegin();
+		for(int i = 0; i < N; i++, ++it)
+			if(it -> first != i || it -> second.data != i * 3) return 0;
+		if(it != S.cend()) return 0;
+	}
+	return Counted::counter == 0;
+}
+
+template<class M>
+bool copies(int n){
+	M Q;
+	std::map<int, std::string> stdQ;
+	for(int i = 0; i < n; i++){
+		int a = rand() % (4 * n + 1);
+		char buf[16];
+		sprintf(buf, "v%d", a);
+		Q[a] = buf; stdQ[a] = buf;
+	}
+	M R(sjtu::parallel_copy, Q);
+	if(!same(R, stdQ) || !same(Q, stdQ)) return 0;
+	if(n > 0) R.erase(R.begin());
+	R[-1] = "new";
+	return same(Q, stdQ) && R.size() == Q.size() + (n == 0) && R.begin() -> second == "new";
+}
+
+bool check2(){ //parallel_copy copies maps of every size into independent trees
+	typedef sjtu::map<int, std::string, std::less<int>, std::allocator<sjtu::pair<const int, std::string> >, true> ranked;
+	int sizes[] = {0, 1, 2, 1000, N, N + 12345};
+	for(int k = 0; k < 6; k++)
+		if(!copies<sjtu::map<int, std::string> >(sizes[k]) || !copies<ranked>(sizes[k])) return 0;
+	ranked Q;
+	for(int i = 0; i < N; i++) Q[i] = "x";
+	ranked R(sjtu::parallel_copy, Q);
+	for(int i = 0; i < N; i += 997)
+		if(R.find(i) - R.begin() != i || R.find(i) -> first != i) return 0;
+	return true;
+}
+
+//its copies throw once the budget runs out; only copied by the plain copy constructor, on one thread
+class Fragile {
+public:
+	static int budget;
+	static int alive;
+	int data;
+	Fragile(int value) : data(value) { ++alive; }
+	Fragile(const Fragile &other) : data(other.data) {
+		if(budget-- <= 0) throw std::runtime_error("copy");
+		++alive;
+	}
+	~Fragile() { --alive; }
+};
+int Fragile::budget = 0;
+int Fragile::alive = 0;
+
+bool check3(){ //a throwing copy leaves the source intact and frees what was built
+	{
+		sjtu::map<int, Fragile> Q;
+		Fragile::budget = 4 * N;
+		for(int i = 0; i < N; i++) Q.insert(sjtu::pair<const int, Fragile>(i, Fragile(i)));
+		int cuts[] = {0, N / 4, N / 2, N - 1};
+		for(int k = 0; k < 4; k++){
+			Fragile::budget = cuts[k];
+			bool thrown = false;
+			try {
+				sjtu::map<int, Fragile> R(Q);
+			} catch (std::runtime_error &) { thrown = true; }
+			if(!thrown || Fragile::alive != N) return 0;
+		}
+		Fragile::budget = N;
+		sjtu::map<int, Fragile> R(Q);
+		if(R.size() != (size_t)N || Fragile::alive != 2 * N) return 0;
+		sjtu::map<int, Fragile>::const_iterator it = R.cbegin();
+		for(int i = 0; i < N; i++, ++it)
+			if(it -> first != i || it -> second.data != i) return 0;
+	}
+	return Fragile::alive == 0;
+}
+
+int main(){
+	srand(time(0));
+	bool (*checks[])() = {check1, check2, check3};
+	for(int i = 0; i < 3; i++){
+		if(checks[i]()) printf("Test %d Passed!\n", i + 1);
+		else printf("Test %d Failed!\n", i + 1);
+	}
+	return 0;
+}
@@ -0,0 +1,198 @@
+#include<iostream>
+#include<map>
+#include<memory>
+#include<type_traits>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "map.hpp"
+
+using namespace std;
+
+long long live[32]; //bytes handed out by the allocators of each id and not yet given back
+
+//a stateful allocator: those of different id compare unequal, and each propagates as its flags say
+template<class U, bool Copy, bool Move, bool Swap>
+struct tracking {
+	typedef U value_type;
+	typedef std::integral_constant<bool, Copy> propagate_on_container_copy_assignment;
+	typedef std::integral_constant<bool, Move> propagate_on_container_move_assignment;
+	typedef std::integral_constant<bool, Swap> propagate_on_container_swap;
+	template<class V> struct rebind { typedef tracking<V, Copy, Move, Swap> other; };
+	int id;
+	tracking(int i = 0) : id(i) {}
+	template<class V> tracking(const tracking<V, Copy, Move, Swap> &o) : id(o.id) {}
+	//a copied map gets an allocator of its own, so it is easy to tell apart
+	tracking select_on_container_copy_construction() const { return tracking(id + 16); }
+	U *allocate(size_t n){ live[id] += n * sizeof(U); return std::allocator<U>().allocate(n); }
+	void deallocate(U *p, size_t n){ live[id] -= n * sizeof(U); std::allocator<U>().deallocate(p, n); }
+	template<class V> bool operator==(const tracking<V, Copy, Move, Swap> &o) const { return id == o.id; }
+	template<class V> bool operator!=(const tracking<V, Copy, Move, Swap> &o) const { return id != o.id; }
+};
+
+template<bool Copy, bool Move, bool Swap>
+struct with{ //a map over tracking allocators with these flags
+	typedef sjtu::map<int, int, std::less<int>, tracking<sjtu::pair<const int, int>, Copy, Move, Swap> > type;
+};
+
+template<class M>
+bool same(const M &Q, const std::map<int, int> &stdQ){
+	if(Q.size() != stdQ.size()) return 0;
+	typename M::const_iterator it = Q.cbegin();
+	for(std::map<int, int>::const_iterator stdit = stdQ.begin(); stdit != stdQ.end(); ++stdit, ++it)
+		if(it -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	return it == Q.cend();
+}
+
+template<class M>
+void fill(M &Q, std::map<int, int> &stdQ, int n){
+	for(int i = 0; i < n; i++){ int a = rand() % (4 * n); Q[a] = i; stdQ[a] = i; }
+}
+
+bool quiet(){ //no allocator holds memory any more
+	for(int i = 0; i < 32; i++) if(live[i] != 0) return 0;
+	return 1;
+}
+
+bool check1(){ //copying asks select_on_container_copy_construction; copy assignment propagates only when told to
+	{
+		typedef with<true, false, false>::type M;
+		M A(M::allocator_type(1)), B(M::allocator_type(2));
+		std::map<int, int> stdA, stdB;
+		fill(A, stdA, 1000), fill(B, stdB, 300);
+		M C(A);
+		if(C.get_allocator().id != 17 || live[17] == 0 || !same(C, stdA)) return 0;
+		B = A; //propagates: B now allocates with 1 and gives back all it took from 2
+		if(B.get_allocator().id != 1 || live[2] != 0 || !same(B, stdA)) return 0;
+		B[-1] = 1, stdA[-1] = 1;
+		if(!same(B, stdA) || A.count(-1)) return 0;
+	}
+	if(!quiet()) return 0;
+	{
+		typedef with<false, false, false>::type M;
+		M A(M::allocator_type(1)), B(M::allocator_type(2));
+		std::map<int, int> stdA, stdB;
+		fill(A, stdA, 1000), fill(B, stdB, 300);
+		long long a = live[1];
+		B = A; //stays with 2: A's nodes are copied into memory of 2
+		if(B.get_allocator().id != 2 || live[1] != a || live[2] == 0 || !same(B, stdA)) return 0;
+	}
+	return quiet();
+}
+
+bool check2(){ //move assignment takes the nodes when it may, and moves the elements one by one when it may not
+	{
+		typedef with<false, true, false>::type M;
+		M A(M::allocator_type(1)), B(M::allocator_type(2));
+		std::map<int, int> stdA, stdB;
+		fill(A, stdA, 1000), fill(B, stdB, 300);
+		const sjtu::pair<const int, int> *first = &*A.begin();
+		B = std::move(A); //propagates: the nodes change hands with the allocator
+		if(B.get_allocator().id != 1 || live[2] != 0 || &*B.begin() != first || !same(B, stdA)) return 0;
+		if(!A.empty()) return 0;
+		A[5] = 5; //a moved-from map takes new elements
+		if(A.size() != 1 || A.at(5) != 5) return 0;
+	}
+	if(!quiet()) return 0;
+	{
+		typedef with<false, false, false>::type M;
+		M A(M::allocator_type(3)), B(M::allocator_type(3));
+		std::map<int, int> stdA, stdB;
+		fill(A, stdA, 1000), fill(B, stdB, 300);
+		const sjtu::pair<const int, int> *first = &*A.begin();
+		B = std::move(A); //equal allocators: the nodes change hands, the allocators stay
+		if(B.get_allocator().id != 3 || &*B.begin() != first || !same(B, stdA) || !A.empty()) return 0;
+	}
+	if(!quiet()) return 0;
+	{
+		typedef with<false, false, false>::type M;
+		M A(M::allocator_type(1)), B(M::allocator_type(2));
+		std::map<int, int> stdA, stdB;
+		fill(A, stdA, 1000), fill(B, stdB, 300);
+		const sjtu::pair<const int, int> *first = &*A.begin();
+		B = std::move(A); //unequal and not propagating: new nodes from 2, and A gives its own back
+		if(B.get_allocator().id != 2 || A.get_allocator().id != 1 || &*B.begin() == first) return 0;
+		if(!same(B, stdA) || !A.empty()) return 0;
+		A[5] = 5;
+		if(A.size() != 1 || A.at(5) != 5) return 0;
+	}
+	return quiet();
+}
+
+bool check3(){ //swap exchanges the allocators only when they propagate
+	{
+		typedef with<false, false, true>::type M;
+		M A(M::allocator_type(1)), B(M::allocator_type(2));
+		std::map<int, int> stdA, stdB;
+		fill(A, stdA, 1000), fill(B, stdB, 300);
+		long long a = live[1], b = live[2];
+		A.swap(B);
+		if(A.get_allocator().id != 2 || B.get_allocator().id != 1 || !same(A, stdB) || !same(B, stdA)) return 0;
+		if(live[1] != a || live[2] != b) return 0;
+		A[-1] = -1, stdB[-1] = -1;
+		B.erase(B.begin()), stdA.erase(stdA.begin());
+		if(!same(A, stdB) || !same(B, stdA)) return 0;
+	}
+	if(!quiet()) return 0;
+	{
+		typedef with<false, false, false>::type M;
+		M A(M::allocator_type(4)), B(M::allocator_type(4));
+		std::map<int, int> stdA, stdB;
+		fill(A, stdA, 1000), fill(B, stdB, 300);
+		swap(A, B);
+		if(A.get_allocator().id != 4 || B.get_allocator().id != 4 || !same(A, stdB) || !same(B, stdA)) return 0;
+	}
+	return quiet();
+}
+
+#ifdef SJTU_MAP_HAS_PMR
+//a memory_resource that counts what it hands out
+class counted_resource : public std::pmr::memory_resource {
+public:
+	long long live = 0;
+private:
+	void *do_allocate(size_t n, size_t a) override { live += n; return std::pmr::new_delete_resource() -> allocate(n, a); }
+	void do_deallocate(void *p, size_t n, size_t a) override { live -= n; std::pmr::new_delete_resource() -> deallocate(p, n, a); }
+	bool do_is_equal(const std::pmr::memory_resource &o) const noexcept override { return this == &o; }
+};
+
+bool check4(){ //sjtu::pmr::map draws on its resource; copies go to the default one, as polymorphic_allocator asks
+	counted_resource r1, r2;
+	{
+		sjtu::pmr::map<int, int> A(&r1), B(&r2);
+		std::map<int, int> stdA, stdB;
+		fill(A, stdA, 1000), fill(B, stdB, 300);
+		if(r1.live == 0 || A.get_allocator().resource() != &r1) return 0;
+		sjtu::pmr::map<int, int> C(A);
+		if(C.get_allocator().resource() != std::pmr::get_default_resource() || !same(C, stdA)) return 0;
+		sjtu::pmr::map<int, int> D(A, &r2);
+		if(D.get_allocator().resource() != &r2 || !same(D, stdA)) return 0;
+		B = std::move(A); //polymorphic_allocator never propagates: elements move into r2
+		if(B.get_allocator().resource() != &r2 || !same(B, stdA) || !A.empty()) return 0;
+		A[1] = 1;
+		if(A.size() != 1) return 0;
+	}
+	std::pmr::monotonic_buffer_resource arena;
+	{
+		sjtu::pmr::map<int, int> A(&arena);
+		std::map<int, int> stdA;
+		fill(A, stdA, 1000);
+		if(!same(A, stdA)) return 0;
+	}
+	return r1.live == 0 && r2.live == 0;
+}
+#else
+bool check4(){ //no <memory_resource> before C++17
+	return 1;
+}
+#endif
+
+int main(){
+	srand(time(0));
+	bool (*checks[])() = {check1, check2, check3, check4};
+	for(int i = 0; i < 4; i++){
+		if(checks[i]()) printf("Test %d Passed!\n", i + 1);
+		else printf("Test %d Failed!\n", i + 1);
+	}
+	return 0;
+}
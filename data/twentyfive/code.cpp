@@ -0,0 +1,135 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<string>
+#include<algorithm>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "map.hpp"
+
+using namespace std;
+
+long calls = 0;
+
+struct Less{ //counts its calls
+	bool operator()(int a, int b) const { calls++; return a < b; }
+};
+
+typedef sjtu::map<int, std::string, Less> smap;
+typedef sjtu::map<int, std::string, Less, std::allocator<sjtu::pair<const int, std::string> >, true> rmap;
+
+template<class M>
+bool same(const M &Q, const std::map<int, std::string> &stdQ){
+	if(Q.size() != stdQ.size()) return 0;
+	typename M::const_iterator it = Q.cbegin();
+	for(std::map<int, std::string>::const_iterator stdit = stdQ.begin(); stdit != stdQ.end(); ++stdit, ++it)
+		if(it -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	if(it != Q.cend()) return 0;
+	for(std::map<int, std::string>::const_reverse_iterator stdit = stdQ.rbegin(); stdit != stdQ.rend(); ++stdit)
+		if((--it) -> first != stdit -> first) return 0;
+	return true;
+}
+
+std::string name(int a){
+	char buf[16];
+	sprintf(buf, "v%d", a);
+	return buf;
+}
+
+//one op after the other, as the batch must behave
+template<class Op>
+typename Op::result_type reference(std::map<int, std::string> &stdQ, const Op &op){
+	bool in = stdQ.count(op.key);
+	if(op.type == Op::erase){
+		stdQ.erase(op.key);
+		return in ? Op::erased : Op::missing;
+	}
+	stdQ[op.key] = op.value;
+	return in ? Op::updated : Op::inserted;
+}
+
+template<class M>
+bool batches(){ //batches of every size, sorted or not, with keys repeated, against the ops done one by one
+	typedef typename M::batch_op op;
+	int sizes[][2] = {{0, 0}, {0, 300}, {300, 0}, {5000, 30}, {30, 5000}, {3000, 3000}};
+	for(int k = 0; k < 6; k++) for(int sorted = 0; sorted < 2; sorted++){
+		M Q;
+		std::map<int, std::string> stdQ;
+		int range = 2 * (sizes[k][0] + sizes[k][1]) + 10;
+		for(int i = 0; i < sizes[k][0]; i++){ int a = rand() % range; Q[a] = name(a); stdQ[a] = name(a); }
+		std::vector<op> ops;
+		for(int i = 0; i < sizes[k][1]; i++){
+			int a = rand() % range;
+			if(rand() % 3) ops.push_back(op(a, name(-i)));
+			else ops.push_back(op(a));
+			if(rand() % 4 == 0) ops.push_back(rand() % 2 ? op(a) : op(a, name(i)));
+		}
+		if(sorted){
+			std::stable_sort(ops.begin(), ops.end(), [](const op &a, const op &b){ return a.key < b.key; });
+		}
+		std::vector<typename op::result_type> expect;
+		for(size_t i = 0; i < ops.size(); i++) expect.push_back(reference(stdQ, ops[i]));
+		Q.apply_batch(ops.begin(), ops.end());
+		for(size_t i = 0; i < ops.size(); i++)
+			if(ops[i].result != expect[i]) return 0;
+		if(!same(Q, stdQ)) return 0;
+		//the tree takes insertions and erasures after the batch
+		for(int i = 0; i < 500; i++){
+			int a = rand() % range;
+			if(rand() % 2){ Q[a] = name(a); stdQ[a] = name(a); }
+			else if(Q.count(a)){ Q.erase(Q.find(a)); stdQ.erase(a); }
+		}
+		if(!same(Q, stdQ)) return 0;
+	}
+	return true;
+}
+
+bool check1(){ //a plain and a ranked map, whose ranks must follow
+	if(!batches<smap>() || !batches<rmap>()) return 0;
+	rmap Q;
+	std::vector<rmap::batch_op> ops;
+	for(int i = 0; i < 4000; i++) ops.push_back(rmap::batch_op(i * 7 % 4000, ""));
+	for(int i = 0; i < 4000; i += 2) ops.push_back(rmap::batch_op(i));
+	Q.apply_batch(ops.begin(), ops.end());
+	for(int i = 1; i < 4000; i += 2)
+		if(Q.find(i) - Q.begin() != i / 2) return 0;
+	return Q.size() == 2000;
+}
+
+bool check2(){ //a sorted batch of m ops costs O(m log(n / m + 1)) comparisons, down to a few per op for m = n
+	const int n = 100000;
+	smap Q;
+	for(int i = 0; i < n; i++) Q.insert(Q.end(), sjtu::pair<const int, std::string>(2 * i, ""));
+	int ms[] = {10, 100, 1000, 10000, 100000};
+	for(int k = 0; k < 5; k++){
+		int m = ms[k], step = 2 * n / m;
+		std::vector<smap::batch_op> ops;
+		for(int i = 0; i < m; i++){
+			if(i % 2) ops.push_back(smap::batch_op(i * step));
+			else ops.push_back(smap::batch_op(i * step + 1, "x"));
+		}
+		double lg = 0;
+		for(int r = n / m + 1; r > 1; r >>= 1) lg++;
+		calls = 0;
+		Q.apply_batch(ops.begin(), ops.end());
+		if(calls > m * (3 * lg + 8)) return 0;
+		for(int i = 0; i < m; i++){
+			if(ops[i].result != (i % 2 ? smap::batch_op::erased : smap::batch_op::inserted)) return 0;
+			if(i % 2) Q[i * step];
+			else Q.erase(Q.find(i * step + 1));
+		}
+		if(Q.size() != (size_t)n) return 0;
+	}
+	return true;
+}
+
+int main(){
+	srand(time(0));
+	bool (*checks[])() = {check1, check2};
+	for(int i = 0; i < 2; i++){
+		if(checks[i]()) printf("Test %d Passed!\n", i + 1);
+		else printf("Test %d Failed!\n", i + 1);
+	}
+	return 0;
+}
@@ -0,0 +1,166 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<forward_list>
+#include<string>
+#include<stdexcept>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "map.hpp"
+
+using namespace std;
+
+typedef sjtu::pair<const int, std::string> value;
+typedef sjtu::map<int, std::string> smap;
+typedef sjtu::map<int, std::string, std::less<int>, std::allocator<value>, true> rmap;
+
+template<class M>
+bool same(const M &Q, const std::map<int, std::string> &stdQ){
+	if(Q.size() != stdQ.size()) return 0;
+	typename M::const_iterator it = Q.cbegin();
+	for(std::map<int, std::string>::const_iterator stdit = stdQ.begin(); stdit != stdQ.end(); ++stdit, ++it)
+		if(it -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	if(it != Q.cend()) return 0;
+	for(std::map<int, std::string>::const_reverse_iterator stdit = stdQ.rbegin(); stdit != stdQ.rend(); ++stdit)
+		if((--it) -> first != stdit -> first) return 0;
+	return true;
+}
+
+std::string name(int a){
+	char buf[16];
+	sprintf(buf, "v%d", a);
+	return buf;
+}
+
+std::map<int, std::string> keys(int n){
+	std::map<int, std::string> res;
+	while((int)res.size() < n){ int a = rand() % (4 * n + 10) - n; res[a] = name(a); }
+	return res;
+}
+
+//the tree takes insertions and erasures like any other
+template<class M>
+bool lives(M &Q, std::map<int, std::string> &stdQ, int n){
+	for(int i = 0; i < 2 * n + 20; i++){
+		int a = rand() % (4 * n + 10) - n;
+		if(rand() % 2){ Q[a] = name(-a); stdQ[a] = name(-a); }
+		else if(Q.count(a)){ Q.erase(Q.find(a)); stdQ.erase(a); }
+	}
+	return same(Q, stdQ);
+}
+
+//the nodes lie one after another in key order
+template<class M>
+bool contiguous(const M &Q){
+	if(Q.size() < 2) return true;
+	typename M::const_iterator it = Q.cbegin(), nx = it;
+	++nx;
+	long step = (const char *)&*nx - (const char *)&*it;
+	if(step <= 0) return 0;
+	for(; nx != Q.cend(); ++it, ++nx)
+		if((const char *)&*nx - (const char *)&*it != step) return 0;
+	return true;
+}
+
+template<class M>
+bool builds(){ //sizes on and around full trees, from random access and forward iterators
+	int sizes[] = {0, 1, 2, 3, 6, 7, 8, 15, 16, 17, 1000, 4095, 4096};
+	for(int k = 0; k < 13; k++){
+		int n = sizes[k];
+		std::map<int, std::string> stdQ = keys(n);
+		std::vector<value> v;
+		std::forward_list<value> f;
+		for(std::map<int, std::string>::reverse_iterator it = stdQ.rbegin(); it != stdQ.rend(); ++it) f.push_front(value(it -> first, it -> second));
+		for(std::map<int, std::string>::iterator it = stdQ.begin(); it != stdQ.end(); ++it) v.push_back(value(it -> first, it -> second));
+		M Q(sjtu::sorted_unique, v.begin(), v.end()), R(sjtu::sorted_unique, f.begin(), f.end());
+		if(!same(Q, stdQ) || !same(R, stdQ) || !contiguous(Q) || !contiguous(R)) return 0;
+		std::map<int, std::string> stdR = stdQ;
+		if(!lives(Q, stdQ, n) || !lives(R, stdR, n)) return 0;
+	}
+	return true;
+}
+
+bool check1(){ //the sorted_unique constructor, for a plain and a ranked map
+	if(!builds<smap>() || !builds<rmap>()) return 0;
+	std::map<int, std::string> stdQ = keys(3000);
+	std::vector<value> v;
+	for(std::map<int, std::string>::iterator it = stdQ.begin(); it != stdQ.end(); ++it) v.push_back(value(it -> first, it -> second));
+	rmap Q(sjtu::sorted_unique, v.begin(), v.end());
+	int i = 0;
+	for(std::map<int, std::string>::iterator it = stdQ.begin(); it != stdQ.end(); ++it, ++i)
+		if(Q.find(it -> first) - Q.begin() != i || Q.end() - Q.find(it -> first) != (int)stdQ.size() - i) return 0;
+	return true;
+}
+
+bool check2(){ //assign replaces any content, also with nothing
+	smap Q;
+	std::map<int, std::string> stdQ;
+	for(int round = 0; round < 20; round++){
+		int n = round % 5 == 4 ? 0 : rand() % 3000;
+		stdQ = keys(n);
+		std::vector<value> v;
+		for(std::map<int, std::string>::iterator it = stdQ.begin(); it != stdQ.end(); ++it) v.push_back(value(it -> first, it -> second));
+		Q.assign(sjtu::sorted_unique, v.begin(), v.end());
+		if(!same(Q, stdQ) || !contiguous(Q) || !lives(Q, stdQ, n)) return 0;
+	}
+	smap R(Q);
+	Q.assign(sjtu::sorted_unique, R.cbegin(), R.cend());
+	return same(Q, stdQ) && same(R, stdQ);
+}
+
+//its copies throw once the budget runs out
+class Fragile {
+public:
+	static int budget;
+	static int alive;
+	int data;
+	Fragile(int value) : data(value) { ++alive; }
+	Fragile(const Fragile &other) : data(other.data) {
+		if(budget-- <= 0) throw std::runtime_error("copy");
+		++alive;
+	}
+	~Fragile() { --alive; }
+};
+int Fragile::budget = 0;
+int Fragile::alive = 0;
+
+bool check3(){ //a throwing copy frees every node built so far
+	typedef sjtu::pair<const int, Fragile> fvalue;
+	{
+		std::vector<fvalue> v;
+		Fragile::budget = 1 << 30;
+		for(int i = 0; i < 1000; i++) v.push_back(fvalue(i, Fragile(i)));
+		int before = Fragile::alive;
+		for(int cut = 0; cut < 1000; cut += 111){
+			Fragile::budget = cut;
+			try {
+				sjtu::map<int, Fragile> Q(sjtu::sorted_unique, v.begin(), v.end());
+				return 0;
+			} catch (std::runtime_error &) {}
+			if(Fragile::alive != before) return 0;
+			Fragile::budget = 1 << 30;
+			sjtu::map<int, Fragile> R(sjtu::sorted_unique, v.begin(), v.begin() + 10);
+			Fragile::budget = cut;
+			try {
+				R.assign(sjtu::sorted_unique, v.begin(), v.end());
+				return 0;
+			} catch (std::runtime_error &) {}
+			if(Fragile::alive != before || R.size() != 0 || R.begin() != R.end()) return 0;
+			Fragile::budget = 1 << 30;
+			R.insert(fvalue(5, Fragile(5)));
+			if(R.size() != 1) return 0;
+		}
+	}
+	return Fragile::alive == 0;
+}
+
+int main(){
+	srand(time(0));
+	bool (*checks[])() = {check1, check2, check3};
+	for(int i = 0; i < 3; i++){
+		if(checks[i]()) printf("Test %d Passed!\n", i + 1);
+		else printf("Test %d Failed!\n", i + 1);
+	}
+	return 0;
+}
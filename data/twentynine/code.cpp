@@ -0,0 +1,109 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "map.hpp"
+
+using namespace std;
+
+//counts how often a value is copied or moved, and how many are alive
+class Counted {
+public:
+	static int alive, copied, moved;
+	int data;
+	Counted(int value = 0) : data(value) { ++alive; }
+	Counted(const Counted &other) : data(other.data) { ++alive; ++copied; }
+	Counted(Counted &&other) : data(other.data) { ++alive; ++moved; }
+	Counted &operator=(const Counted &other) { data = other.data; ++copied; return *this; }
+	Counted &operator=(Counted &&other) { data = other.data; ++moved; return *this; }
+	~Counted() { --alive; }
+};
+int Counted::alive = 0, Counted::copied = 0, Counted::moved = 0;
+
+typedef sjtu::map<int, Counted> smap;
+typedef sjtu::map<int, Counted, std::less<int>, std::allocator<sjtu::pair<const int, Counted> >, true> rmap;
+
+//every element left still sits where it was built, and is reached by the iterator taken then
+template<class M>
+bool unmoved(M &Q, std::map<int, typename M::iterator> &its, std::map<int, const sjtu::pair<const int, Counted> *> &at){
+	if(Q.size() != its.size()) return 0;
+	typename M::iterator it = Q.begin();
+	for(typename std::map<int, typename M::iterator>::iterator i = its.begin(); i != its.end(); ++i, ++it){
+		if(i -> second != it || &*it != at[i -> first]) return 0;
+		if(i -> second -> first != i -> first || i -> second -> second.data != i -> first * 3) return 0;
+	}
+	return it == Q.end();
+}
+
+template<class M>
+bool relinks(){ //erase relinks nodes: nothing is copied or moved, and no other iterator goes stale
+	{ //a root with two children: its successor takes its place
+		M Q;
+		Q.try_emplace(2, 6), Q.try_emplace(1, 3), Q.try_emplace(3, 9);
+		typename M::iterator one = Q.find(1), three = Q.find(3);
+		const sjtu::pair<const int, Counted> *p = &*three;
+		int copied = Counted::copied, moved = Counted::moved;
+		Q.erase(Q.find(2));
+		if(Counted::copied != copied || Counted::moved != moved) return 0;
+		if(one -> first != 1 || &*three != p || three -> second.data != 9) return 0;
+		if(++one != three || ++three != Q.end() || Q.size() != 2) return 0;
+	}
+	for(int round = 0; round < 4; round++){
+		int n = 1 << (8 + round);
+		M Q;
+		std::map<int, typename M::iterator> its;
+		std::map<int, const sjtu::pair<const int, Counted> *> at;
+		//ascending keys leave most inner nodes with two children
+		for(int i = 0; i < n; i++){
+			typename M::iterator it = Q.try_emplace(i, i * 3).first;
+			its[i] = it, at[i] = &*it;
+		}
+		int copied = Counted::copied, moved = Counted::moved;
+		for(int k = 0; k < n / 2; k++){
+			int a = (long long)k * 7919 % n;
+			if(!its.count(a)){
+				if(Q.erase(a) != 0) return 0;
+				continue;
+			}
+			if(k % 2 == 0) Q.erase(its[a]);
+			else if(Q.erase(a) != 1) return 0;
+			its.erase(a), at.erase(a);
+			if(Counted::copied != copied || Counted::moved != moved) return 0;
+			if(k % 37 == 0 && !unmoved(Q, its, at)) return 0;
+		}
+		if(!unmoved(Q, its, at) || Counted::alive != (int)its.size()) return 0;
+		//the tree is still whole: insert and erase go on working
+		for(int i = n; i < n + 100; i++) Q.try_emplace(i, i * 3);
+		while(!Q.empty()) Q.erase(Q.begin());
+		if(Counted::alive != 0 || Counted::copied != copied || Counted::moved != moved) return 0;
+	}
+	return 1;
+}
+
+bool check1(){ //a plain map
+	return relinks<smap>();
+}
+
+bool check2(){ //a ranked map, whose ranks must follow
+	if(!relinks<rmap>()) return 0;
+	rmap Q;
+	std::vector<int> keys;
+	for(int i = 0; i < 1000; i++) Q.try_emplace(i, i * 3);
+	for(int i = 0; i < 1000; i += 3) Q.erase(i);
+	for(int i = 0; i < 1000; i++) if(i % 3 != 0) keys.push_back(i);
+	for(size_t i = 0; i < keys.size(); i++)
+		if(Q.rank(keys[i]) != i || Q.select(i) -> first != keys[i]) return 0;
+	return 1;
+}
+
+int main(){
+	srand(time(0));
+	bool (*checks[])() = {check1, check2};
+	for(int i = 0; i < 2; i++){
+		if(checks[i]()) printf("Test %d Passed!\n", i + 1);
+		else printf("Test %d Failed!\n", i + 1);
+	}
+	return 0;
+}
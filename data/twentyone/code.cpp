@@ -0,0 +1,167 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<memory>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "map.hpp"
+
+using namespace std;
+
+long long live = 0; //bytes handed out by counting allocators and not yet given back
+
+//std::allocator that keeps live up to date; those of different id compare unequal
+template<class U>
+struct counting {
+	typedef U value_type;
+	int id;
+	counting(int i = 0) : id(i) {}
+	template<class V> counting(const counting<V> &o) : id(o.id) {}
+	U *allocate(size_t n){ live += n * sizeof(U); return std::allocator<U>().allocate(n); }
+	void deallocate(U *p, size_t n){ live -= n * sizeof(U); std::allocator<U>().deallocate(p, n); }
+	template<class V> bool operator==(const counting<V> &o) const { return id == o.id; }
+	template<class V> bool operator!=(const counting<V> &o) const { return id != o.id; }
+};
+
+typedef sjtu::map<int, int, std::less<int>, counting<sjtu::pair<const int, int> > > smap;
+typedef sjtu::map<int, int, std::less<int>, counting<sjtu::pair<const int, int> >, true> rmap;
+
+template<class M>
+bool same(const M &Q, const std::map<int, int> &stdQ){
+	if(Q.size() != stdQ.size()) return 0;
+	typename M::const_iterator it = Q.cbegin();
+	for(std::map<int, int>::const_iterator stdit = stdQ.begin(); stdit != stdQ.end(); ++stdit, ++it)
+		if(it -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	if(it != Q.cend()) return 0;
+	for(std::map<int, int>::const_reverse_iterator stdit = stdQ.rbegin(); stdit != stdQ.rend(); ++stdit)
+		if((--it) -> first != stdit -> first) return 0;
+	return true;
+}
+
+template<class M>
+void fill(M &Q, std::map<int, int> &stdQ, int n, int range){
+	for(int i = 0; i < n; i++){ int a = rand() % range; Q[a] = a + 7; stdQ[a] = a + 7; }
+}
+
+//the part of stdQ not less than key, moved out of stdQ
+std::map<int, int> cut(std::map<int, int> &stdQ, int key){
+	std::map<int, int> res(stdQ.lower_bound(key), stdQ.end());
+	stdQ.erase(stdQ.lower_bound(key), stdQ.end());
+	return res;
+}
+
+template<class M>
+bool splits(){ //split at every kind of key leaves both parts whole
+	int keys[] = {-5, 0, 1, 37, 2500, 4999, 5000, 9998, 12000};
+	for(int k = 0; k < 9; k++){
+		M Q;
+		std::map<int, int> stdQ;
+		fill(Q, stdQ, 3000, 10000);
+		M R = Q.split(keys[k]);
+		std::map<int, int> stdR = cut(stdQ, keys[k]);
+		if(!same(Q, stdQ) || !same(R, stdR)) return 0;
+		//both parts go on living on their own
+		fill(Q, stdQ, 500, keys[k] > 0 ? keys[k] : 1);
+		for(int i = 0; i < 300 && !stdR.empty(); i++){ R.erase(R.begin()); stdR.erase(stdR.begin()); }
+		if(!same(Q, stdQ) || !same(R, stdR)) return 0;
+		M S = R.split(keys[k] + 1000);
+		std::map<int, int> stdS = cut(stdR, keys[k] + 1000);
+		if(!same(R, stdR) || !same(S, stdS)) return 0;
+	}
+	return true;
+}
+
+bool check1(){ //split, with the smaller part on either side, for plain and ranked maps
+	return splits<smap>() && splits<rmap>();
+}
+
+template<class M>
+bool joins(int allocator){ //join from either side, into maps of every size
+	int sizes[][2] = {{0, 0}, {0, 400}, {400, 0}, {3000, 20}, {20, 3000}, {2000, 2000}};
+	for(int k = 0; k < 6; k++) for(int after = 0; after < 2; after++){
+		M Q, R(allocator);
+		std::map<int, int> stdQ, stdR;
+		fill(Q, stdQ, sizes[k][0], 10000);
+		for(int i = 0; i < sizes[k][1]; i++){ int a = 10000 + rand() % 10000; R[a] = a; stdR[a] = a; }
+		if(after){
+			Q.join(std::move(R));
+			stdQ.insert(stdR.begin(), stdR.end());
+			if(!same(Q, stdQ) || R.size() != 0 || R.begin() != R.end()) return 0;
+		} else {
+			R.join(std::move(Q));
+			stdR.insert(stdQ.begin(), stdQ.end());
+			if(!same(R, stdR) || Q.size() != 0 || Q.begin() != Q.end()) return 0;
+		}
+		//the emptied map is usable again
+		M &E = after ? R : Q;
+		E[1] = 2;
+		if(E.size() != 1 || E.begin() -> second != 2) return 0;
+	}
+	//overlapping keys are refused and leave both maps alone
+	M Q, R(allocator);
+	std::map<int, int> stdQ, stdR;
+	fill(Q, stdQ, 100, 1000);
+	fill(R, stdR, 100, 1000);
+	try {
+		Q.join(std::move(R));
+		return 0;
+	} catch (sjtu::runtime_error &) {}
+	return same(Q, stdQ) && same(R, stdR);
+}
+
+bool check2(){ //join with equal and with unequal allocators
+	return joins<smap>(0) && joins<smap>(1) && joins<rmap>(0) && joins<rmap>(1);
+}
+
+bool check3(){ //split and join back and forth, with erase and insert in between
+	smap Q;
+	std::map<int, int> stdQ;
+	fill(Q, stdQ, 5000, 20000);
+	for(int round = 0; round < 200; round++){
+		int k = rand() % 20000;
+		smap R = Q.split(k);
+		std::map<int, int> stdR = cut(stdQ, k);
+		int a = rand() % 20000;
+		if(a < k){ Q[a] = round; stdQ[a] = round; }
+		else { R[a] = round; stdR[a] = round; }
+		if(!stdR.empty() && rand() % 2){ R.erase(R.begin()); stdR.erase(stdR.begin()); }
+		if(round % 2) Q.join(std::move(R));
+		else { R.join(std::move(Q)); Q = std::move(R); }
+		stdQ.insert(stdR.begin(), stdR.end());
+		if(!same(Q, stdQ)) return 0;
+	}
+	return true;
+}
+
+bool check4(){ //parts split off and dropped do not make the map that stays grow
+	long long base = live;
+	{
+		smap Q;
+		for(int i = 0; i < 20000; i++) Q[i] = i;
+		long long peak = live - base;
+		for(int round = 0; round < 100; round++){
+			{
+				smap R = Q.split(10000);
+				if(R.size() != 10000) return 0;
+			}
+			for(int i = 10000; i < 20000; i++) Q[i] = round;
+			if(live - base > 2 * peak) return 0;
+		}
+		smap R = Q.split(5000);
+		Q.clear();
+		for(int i = 0; i < 5000; i++) R[i] = i;
+		if(live - base > 2 * peak || R.size() != 20000) return 0;
+	}
+	return live == base;
+}
+
+int main(){
+	srand(time(0));
+	bool (*checks[])() = {check1, check2, check3, check4};
+	for(int i = 0; i < 4; i++){
+		if(checks[i]()) printf("Test %d Passed!\n", i + 1);
+		else printf("Test %d Failed!\n", i + 1);
+	}
+	return 0;
+}
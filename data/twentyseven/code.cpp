@@ -0,0 +1,111 @@
+#include<iostream>
+#include<string>
+#include<cstdio>
+#include "map.hpp"
+#include "btree_map.hpp"
+#include "flat_map.hpp"
+#include "persistent_map.hpp"
+#include "skiplist_map.hpp"
+
+using namespace std;
+
+//can be neither copied nor moved, so it must be built where it stays
+class Pinned {
+public:
+	int a;
+	std::string b;
+	Pinned() : a(-1), b("default") {}
+	Pinned(int x, const std::string &y) : a(x), b(y) {}
+	Pinned(const Pinned &) = delete;
+	Pinned(Pinned &&) = delete;
+};
+
+//counts how it was made
+class Tracked {
+public:
+	static int built, copied, moved;
+	int data;
+	bool was_moved;
+	Tracked() : data(0), was_moved(false) { built++; }
+	explicit Tracked(int value) : data(value), was_moved(false) { built++; }
+	Tracked(const Tracked &other) : data(other.data), was_moved(true) { copied++; }
+	Tracked(Tracked &&other) noexcept : data(other.data), was_moved(true) { moved++; }
+};
+int Tracked::built = 0, Tracked::copied = 0, Tracked::moved = 0;
+
+template<class M>
+bool pinned(){ //try_emplace and operator[] build a value that cannot move
+	M Q;
+	for(int i = 0; i < 1000; i++){
+		int k = i * 7 % 1000;
+		if(!Q.try_emplace(k, k, "v").second || Q.try_emplace(k, -k, "w").second) return 0;
+	}
+	for(int i = 1000; i < 1100; i++)
+		if(Q[i].a != -1 || Q[i].b != "default") return 0;
+	for(int i = 0; i < 1000; i += 2) Q.erase(Q.find(i));
+	if(Q.size() != 600) return 0;
+	int n = 0;
+	for(typename M::iterator it = Q.begin(); it != Q.end(); ++it, ++n){
+		int k = n < 500 ? 2 * n + 1 : 1000 + n - 500;
+		if(it -> first != k || it -> second.a != (k < 1000 ? k : -1)) return 0;
+	}
+	return n == 600;
+}
+
+bool check1(){ //a map of values that cannot be copied or moved
+	typedef sjtu::map<int, Pinned, std::less<int>, std::allocator<sjtu::pair<const int, Pinned> >, true> rmap;
+	if(!pinned<sjtu::map<int, Pinned> >() || !pinned<rmap>()) return 0;
+	sjtu::map<std::string, Pinned> Q;
+	std::string k = "key";
+	if(!Q.try_emplace(std::move(k), 1, "one").second || Q["key"].a != 1) return 0;
+	std::string again = "key";
+	if(Q.try_emplace(std::move(again), 2, "two").second || again != "key") return 0;
+	sjtu::skiplist_map<int, Pinned> S;
+	for(int i = 0; i < 100; i++) S.try_emplace(i, i, "v");
+	if(S.size() != 100 || S[50].a != 50 || S.try_emplace(50, 0, "").second) return 0;
+	return true;
+}
+
+//try_emplace of M builds its value once from the arguments, without copying or moving it
+template<class M>
+bool built_in_place(bool nodes){
+	M Q;
+	for(int i = 0; i < 200; i++){
+		int built = Tracked::built, copied = Tracked::copied, moved = Tracked::moved;
+		sjtu::pair<typename M::iterator, bool> res = Q.try_emplace(i * 37 % 200, i);
+		if(!res.second || Tracked::built != built + 1 || res.first -> second.data != i) return 0;
+		//nodes never move; arrays shift what is there but build the new value in its place
+		if(nodes && (Tracked::copied != copied || Tracked::moved != moved || res.first -> second.was_moved)) return 0;
+		if(i == 0 && (Tracked::copied != copied || Tracked::moved != moved)) return 0;
+		built = Tracked::built;
+		if(Q.try_emplace(i * 37 % 200, -1).second || Tracked::built != built) return 0;
+	}
+	int built = Tracked::built, copied = Tracked::copied, moved = Tracked::moved;
+	Q[1000];
+	return Tracked::built == built + 1 && Tracked::copied == copied && (!nodes || Tracked::moved == moved);
+}
+
+bool check2(){ //every ordered map of the library
+	return built_in_place<sjtu::map<int, Tracked> >(true) && built_in_place<sjtu::skiplist_map<int, Tracked> >(true) &&
+		built_in_place<sjtu::btree_map<int, Tracked> >(false) && built_in_place<sjtu::flat_map<int, Tracked> >(false);
+}
+
+bool check3(){ //persistent_map, whose nodes are only copied when a snapshot shares them
+	sjtu::persistent_map<int, Tracked> Q;
+	for(int i = 0; i < 200; i++){
+		int built = Tracked::built, copied = Tracked::copied, moved = Tracked::moved;
+		if(!Q.try_emplace(i * 37 % 200, i).second) return 0;
+		if(Tracked::built != built + 1 || Tracked::copied != copied || Tracked::moved != moved) return 0;
+		if(Q.try_emplace(i * 37 % 200, -1).second || Tracked::built != built + 1) return 0;
+	}
+	return Q.size() == 200 && Q.at(37).data == 1;
+}
+
+int main(){
+	bool (*checks[])() = {check1, check2, check3};
+	for(int i = 0; i < 3; i++){
+		if(checks[i]()) printf("Test %d Passed!\n", i + 1);
+		else printf("Test %d Failed!\n", i + 1);
+	}
+	return 0;
+}
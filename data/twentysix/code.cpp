@@ -0,0 +1,148 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "map.hpp"
+
+using namespace std;
+
+//counts the values alive, so erased ones must be destroyed
+class Counted {
+public:
+	static int alive;
+	int data;
+	Counted(int value = 0) : data(value) { ++alive; }
+	Counted(const Counted &other) : data(other.data) { ++alive; }
+	Counted &operator=(const Counted &other) { data = other.data; return *this; }
+	~Counted() { --alive; }
+};
+int Counted::alive = 0;
+
+typedef sjtu::map<int, Counted> smap;
+typedef sjtu::map<int, Counted, std::less<int>, std::allocator<sjtu::pair<const int, Counted> >, true> rmap;
+
+template<class M>
+bool same(const M &Q, const std::map<int, int> &stdQ){
+	if(Q.size() != stdQ.size()) return 0;
+	typename M::const_iterator it = Q.cbegin();
+	for(std::map<int, int>::const_iterator stdit = stdQ.begin(); stdit != stdQ.end(); ++stdit, ++it)
+		if(it -> first != stdit -> first || it -> second.data != stdit -> second) return 0;
+	if(it != Q.cend()) return 0;
+	for(std::map<int, int>::const_reverse_iterator stdit = stdQ.rbegin(); stdit != stdQ.rend(); ++stdit)
+		if((--it) -> first != stdit -> first) return 0;
+	return true;
+}
+
+template<class M>
+void fill(M &Q, std::map<int, int> &stdQ, int n, int range){
+	for(int i = 0; i < n; i++){ int a = rand() % range; Q[a] = Counted(a * 3); stdQ[a] = a * 3; }
+}
+
+template<class M>
+bool keys(){ //erase(key) of present and absent keys
+	M Q;
+	std::map<int, int> stdQ;
+	fill(Q, stdQ, 3000, 6000);
+	for(int i = 0; i < 6000; i++){
+		int a = rand() % 6100 - 50;
+		if(Q.erase(a) != stdQ.erase(a)) return 0;
+		if(i % 3 == 0){ Q[a + 1] = Counted(i); stdQ[a + 1] = i; }
+	}
+	return same(Q, stdQ) && Counted::alive == (int)Q.size();
+}
+
+template<class M>
+typename M::iterator at(M &Q, int k){
+	typename M::iterator it = Q.begin();
+	while(k-- > 0) ++it;
+	return it;
+}
+
+template<class M>
+bool ranges(){ //erase(first, last) of every length, at the ends and inside, short and long
+	int lens[] = {0, 1, 2, 5, 11, 12, 13, 40, 700, 2999};
+	for(int k = 0; k < 10; k++) for(int where = 0; where < 3; where++){
+		M Q;
+		std::map<int, int> stdQ;
+		fill(Q, stdQ, 5000, 3000);
+		int n = (int)Q.size(), len = std::min(lens[k], n);
+		int from = where == 0 ? 0 : where == 1 ? n - len : rand() % (n - len + 1);
+		typename M::iterator first = at(Q, from), last = at(Q, from + len), before = Q.end();
+		if(from > 0){ before = first; --before; }
+		std::map<int, int>::iterator sf = stdQ.begin(), sl;
+		std::advance(sf, from);
+		sl = sf;
+		std::advance(sl, len);
+		stdQ.erase(sf, sl);
+		Q.erase(first, last);
+		if(!same(Q, stdQ) || Counted::alive != (int)Q.size()) return 0;
+		//the iterators around the range still work
+		if(from > 0){
+			typename M::iterator nx = before;
+			++nx;
+			if(nx != last) return 0;
+		}
+		if(last != Q.end() && stdQ.count(last -> first) == 0) return 0;
+		for(int i = 0; i < 500; i++){
+			int a = rand() % 3000;
+			if(rand() % 2){ Q[a] = Counted(a * 3); stdQ[a] = a * 3; }
+			else if(Q.erase(a) != stdQ.erase(a)) return 0;
+		}
+		if(!same(Q, stdQ)) return 0;
+	}
+	M Q;
+	std::map<int, int> stdQ;
+	fill(Q, stdQ, 2000, 3000);
+	Q.erase(Q.begin(), Q.end());
+	return Q.size() == 0 && Q.begin() == Q.end() && Counted::alive == 0;
+}
+
+bool check1(){ //erase(key), for a plain and a ranked map
+	return keys<smap>() && keys<rmap>() && Counted::alive == 0;
+}
+
+bool check2(){ //erase(first, last), for a plain and a ranked map, whose ranks must follow
+	if(!ranges<smap>() || !ranges<rmap>() || Counted::alive != 0) return 0;
+	rmap Q;
+	for(int i = 0; i < 3000; i++) Q[i];
+	Q.erase(Q.find(1000), Q.find(2000));
+	for(int i = 0; i < 3000; i += 7){
+		rmap::iterator it = Q.find(i);
+		if((i >= 1000 && i < 2000) != (it == Q.end())) return 0;
+		if(it != Q.end() && it - Q.begin() != (i < 1000 ? i : i - 1000)) return 0;
+	}
+	return true;
+}
+
+bool check3(){ //ranges that are reversed or from another map are refused and change nothing
+	smap Q, R;
+	std::map<int, int> stdQ, stdR;
+	fill(Q, stdQ, 100, 1000);
+	fill(R, stdR, 100, 1000);
+	smap::iterator a = at(Q, 10), b = at(Q, 50);
+	try {
+		Q.erase(b, a);
+		return 0;
+	} catch (sjtu::invalid_iterator &) {}
+	try {
+		Q.erase(R.begin(), R.end());
+		return 0;
+	} catch (sjtu::invalid_iterator &) {}
+	try {
+		Q.erase(Q.begin(), R.end());
+		return 0;
+	} catch (sjtu::invalid_iterator &) {}
+	return same(Q, stdQ) && same(R, stdR);
+}
+
+int main(){
+	srand(time(0));
+	bool (*checks[])() = {check1, check2, check3};
+	for(int i = 0; i < 3; i++){
+		if(checks[i]()) printf("Test %d Passed!\n", i + 1);
+		else printf("Test %d Failed!\n", i + 1);
+	}
+	return 0;
+}
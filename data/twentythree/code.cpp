@@ -0,0 +1,119 @@
+#include<iostream>
+#include<map>
+#include<vector>
+#include<string>
+#include<ctime>
+#include<cstdio>
+#include<cstdlib>
+#include "map.hpp"
+
+using namespace std;
+
+long calls = 0;
+
+struct Less{ //counts its calls
+	bool operator()(int a, int b) const { calls++; return a < b; }
+};
+
+typedef sjtu::map<int, std::string, Less> smap;
+typedef sjtu::map<int, std::string, Less, std::allocator<sjtu::pair<const int, std::string> >, true> rmap;
+
+template<class M>
+bool same(const M &Q, const std::map<int, std::string> &stdQ){
+	if(Q.size() != stdQ.size()) return 0;
+	typename M::const_iterator it = Q.cbegin();
+	for(std::map<int, std::string>::const_iterator stdit = stdQ.begin(); stdit != stdQ.end(); ++stdit, ++it)
+		if(it -> first != stdit -> first || it -> second != stdit -> second) return 0;
+	if(it != Q.cend()) return 0;
+	for(std::map<int, std::string>::const_reverse_iterator stdit = stdQ.rbegin(); stdit != stdQ.rend(); ++stdit)
+		if((--it) -> first != stdit -> first) return 0;
+	return true;
+}
+
+std::string name(int a){
+	char buf[16];
+	sprintf(buf, "%d", a);
+	return buf;
+}
+
+//a hint anywhere: the right place, next to it, far off, begin(), end() or on the key itself
+template<class M>
+typename M::iterator pick(M &Q, int key){
+	int n = (int)Q.size(), where = rand() % 6;
+	if(where == 0 || n == 0) return Q.end();
+	if(where == 1) return Q.begin();
+	typename M::iterator it = Q.lower_bound(key);
+	if(where == 2) return it;
+	if(where == 3 && it != Q.begin()) return --it;
+	if(where == 4 && it != Q.end()) return ++it;
+	it = Q.begin();
+	for(int k = rand() % n; k > 0; k--) ++it;
+	return it;
+}
+
+template<class M>
+bool hints(){ //every overload with hints right and wrong agrees with std::map
+	M Q;
+	std::map<int, std::string> stdQ;
+	for(int i = 0; i < 6000; i++){
+		int a = rand() % 3000, how = rand() % 3;
+		typename M::iterator h = pick(Q, a), res;
+		sjtu::pair<const int, std::string> v(a, name(i));
+		if(how == 0) res = Q.insert(h, v);
+		else if(how == 1) res = Q.insert(h, sjtu::pair<const int, std::string>(a, name(i)));
+		else res = Q.emplace_hint(h, a, name(i));
+		stdQ.insert(std::make_pair(a, name(i)));
+		//the new element, or the one that was there and kept its value
+		if(res == Q.end() || res -> first != a || res -> second != stdQ[a]) return 0;
+	}
+	return same(Q, stdQ);
+}
+
+bool check1(){ //a plain and a ranked map, whose ranks must follow
+	if(!hints<smap>() || !hints<rmap>()) return 0;
+	rmap Q;
+	for(int i = 0; i < 2000; i++) Q.emplace_hint(pick(Q, i * 7 % 2000), i * 7 % 2000, "");
+	for(int i = 0; i < 2000; i++)
+		if(Q.find(i) - Q.begin() != i) return 0;
+	return true;
+}
+
+bool check2(){ //a hint in the right place costs one comparison, where a search costs a descent
+	const int n = 100000;
+	smap A, B, C;
+	calls = 0;
+	for(int i = 0; i < n; i++) A.insert(A.end(), sjtu::pair<const int, std::string>(i, ""));
+	long ascending = calls;
+	calls = 0;
+	smap::iterator h = B.end();
+	for(int i = n - 1; i >= 0; i--) h = B.emplace_hint(h, i, "");
+	long descending = calls;
+	calls = 0;
+	for(int i = 0; i < n; i++) C.insert(sjtu::pair<const int, std::string>(i, ""));
+	long plain = calls;
+	return ascending == n - 1 && descending == n - 1 && plain > 10L * n && A.size() == (size_t)n && B.size() == (size_t)n;
+}
+
+bool check3(){ //a hint from another map is refused and changes nothing
+	smap Q, R;
+	for(int i = 0; i < 100; i++) Q[i], R[i + 1000];
+	try {
+		Q.insert(R.begin(), sjtu::pair<const int, std::string>(500, ""));
+		return 0;
+	} catch (sjtu::invalid_iterator &) {}
+	try {
+		Q.emplace_hint(R.end(), 500, "");
+		return 0;
+	} catch (sjtu::invalid_iterator &) {}
+	return Q.size() == 100 && R.size() == 100 && Q.count(500) == 0;
+}
+
+int main(){
+	srand(time(0));
+	bool (*checks[])() = {check1, check2, check3};
+	for(int i = 0; i < 3; i++){
+		if(checks[i]()) printf("Test %d Passed!\n", i + 1);
+		else printf("Test %d Failed!\n", i + 1);
+	}
+	return 0;
+}
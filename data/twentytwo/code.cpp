@@ -0,0 +1,119 @@
+#include<iostream>
+#include<map>
+#include<string>
+#include<cstring>
+#include<cstdio>
+#include<cstdlib>
+#include "map.hpp"
+
+using namespace std;
+
+long whole = 0, mixed = 0; //comparisons between two std::string, and with anything else
+
+struct initial{ //every key that starts with c
+	char c;
+};
+
+struct Less{ //orders std::string against const char * and initial without building a std::string
+	typedef void is_transparent;
+	bool operator()(const std::string &a, const std::string &b) const { whole++; return a < b; }
+	bool operator()(const std::string &a, const char *b) const { mixed++; return a.compare(b) < 0; }
+	bool operator()(const char *a, const std::string &b) const { mixed++; return b.compare(a) > 0; }
+	bool operator()(const std::string &a, initial b) const { mixed++; return a.empty() || a[0] < b.c; }
+	bool operator()(initial a, const std::string &b) const { mixed++; return !b.empty() && a.c < b[0]; }
+};
+
+typedef sjtu::map<std::string, int, Less> smap;
+typedef sjtu::map<std::string, int, Less, std::allocator<sjtu::pair<const std::string, int> >, true> rmap;
+
+//four letters, with about a hundred words to each initial
+std::string word(int i){
+	std::string res;
+	unsigned h = i * 2654435761u;
+	for(int k = 0; k < 4; k++, h /= 26) res += char('a' + h % 26);
+	return res;
+}
+
+template<class M>
+void fill(M &Q, std::map<std::string, int> &stdQ){
+	for(int i = 0; i < 2000; i++){ Q[word(i)] = i; stdQ[word(i)] = i; }
+}
+
+template<class M>
+bool lookups(){ //find, count, at and the bounds by const char * agree with std::map, and never compare two std::string
+	M Q;
+	std::map<std::string, int> stdQ;
+	fill(Q, stdQ);
+	const M &C = Q;
+	char buf[8];
+	whole = mixed = 0;
+	for(int i = 0; i < 3000; i++){
+		std::string w = word(i * 3 + 1);
+		strcpy(buf, w.c_str());
+		const char *k = buf;
+		std::map<std::string, int>::iterator it = stdQ.find(w);
+		bool in = it != stdQ.end();
+		if((Q.find(k) != Q.end()) != in || (C.find(k) != C.cend()) != in || Q.count(k) != (in ? 1u : 0u)) return 0;
+		if(in && (Q.find(k) -> second != it -> second || C.find(k) -> first != w)) return 0;
+		try {
+			int v = Q.at(k);
+			if(!in || v != it -> second || C.at(k) != v) return 0;
+			Q.at(k) = v;
+		} catch (sjtu::index_out_of_bound &) {
+			if(in) return 0;
+		}
+		typename M::iterator lb = Q.lower_bound(k), ub = Q.upper_bound(k);
+		typename M::const_iterator clb = C.lower_bound(k), cub = C.upper_bound(k);
+		if((lb == Q.end()) != (stdQ.lower_bound(w) == stdQ.end()) || (ub == Q.end()) != (stdQ.upper_bound(w) == stdQ.end())) return 0;
+		if(lb != Q.end() && lb -> first != stdQ.lower_bound(w) -> first) return 0;
+		if(ub != Q.end() && ub -> first != stdQ.upper_bound(w) -> first) return 0;
+		if(clb != typename M::const_iterator(lb) || cub != typename M::const_iterator(ub)) return 0;
+		sjtu::pair<typename M::iterator, typename M::iterator> er = Q.equal_range(k);
+		sjtu::pair<typename M::const_iterator, typename M::const_iterator> cer = C.equal_range(k);
+		if(er.first != lb || er.second != ub || cer.first != clb || cer.second != cub) return 0;
+	}
+	return whole == 0 && mixed > 0;
+}
+
+bool check1(){ //a plain and a ranked map
+	return lookups<smap>() && lookups<rmap>();
+}
+
+template<class M>
+bool initials(){ //a probe that does not convert to std::string and matches many keys: count, the bounds and equal_range
+	M Q;
+	std::map<std::string, int> stdQ;
+	fill(Q, stdQ);
+	whole = 0;
+	for(char c = 'a' - 1; c <= 'z' + 1; c++){
+		initial in = {c};
+		std::map<std::string, int>::iterator first = stdQ.lower_bound(std::string(1, c)), last = stdQ.lower_bound(std::string(1, char(c + 1)));
+		size_t n = std::distance(first, last);
+		typename M::iterator lb = Q.lower_bound(in), ub = Q.upper_bound(in);
+		if(Q.count(in) != n) return 0;
+		if((first == stdQ.end()) != (lb == Q.end()) || (last == stdQ.end()) != (ub == Q.end())) return 0;
+		if(first != stdQ.end() && lb -> first != first -> first) return 0;
+		if(last != stdQ.end() && ub -> first != last -> first) return 0;
+		size_t k = 0;
+		for(typename M::iterator it = lb; it != ub; ++it) k++;
+		if(k != n) return 0;
+		sjtu::pair<typename M::iterator, typename M::iterator> r = Q.equal_range(in);
+		const M &C = Q;
+		sjtu::pair<typename M::const_iterator, typename M::const_iterator> cr = C.equal_range(in);
+		if(r.first != lb || r.second != ub || cr.first != C.lower_bound(in) || cr.second != C.upper_bound(in)) return 0;
+	}
+	return whole == 0;
+}
+
+bool check2(){ //a plain and a ranked map
+	return initials<smap>() && initials<rmap>();
+}
+
+int main(){
+	bool (*checks[])() = {check1, check2};
+	for(int i = 0; i < 2; i++){
+		if(checks[i]()) printf("Test %d Passed!\n", i + 1);
+		else printf("Test %d Failed!\n", i + 1);
+	}
+	return 0;
+}
@@ -0,0 +1,324 @@
+#ifndef SJTU_EPOCH_HPP
+#define SJTU_EPOCH_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sjtu {
+
+/**
+ * epoch-based reclamation for lock-free containers.
+ *
+ * a thread pins the domain while it reads shared nodes. a node that has been
+ * unlinked is handed to retire() instead of being freed, and is freed once the
+ * global epoch has moved on twice: by then every thread that was pinned when it
+ * was retired has unpinned, so nobody can still hold a pointer to it. the epoch
+ * only moves on when every pinned thread has seen the current one, so a thread
+ * that stays pinned holds back reclamation, never correctness.
+ *
+ * a thread that retired something tries to move the epoch on as soon as it
+ * unpins, so with nobody else pinned a node is freed right away; threads that
+ * only read help every so often while anything is left. any thread may free
+ * what any other retired, so reclaim functions must be safe to call on every
+ * thread that uses the domain. a thread that exits leaves its record, and
+ * whatever it had not yet freed, to be taken over by the next thread to come.
+ *
+ * pins nest, and belong to the thread that took them: a guard must be released
+ * on the thread that created it. whatever is still retired when the domain is
+ * destroyed is freed then, so the domain must go before what its reclaim
+ * functions use.
+ */
+class epoch_domain {
+public:
+    typedef void (*reclaim_fn)(void *ctx, void *p);
+
+private:
+    struct retired {
+        void *p;
+        reclaim_fn fn;
+        void *ctx;
+    };
+    // one per thread pinning the domain; never unlinked before the domain dies, but reused
+    struct record {
+        std::atomic<size_t> state; // (epoch << 1) | pinned
+        size_t depth;
+        std::atomic<const void *> owner; // the owning thread's token, or null once it exited
+        record *next;
+        std::atomic<bool> busy; // guards the bags, which any scanning thread may empty
+        std::vector<retired> bag[3];
+        size_t bag_epoch[3];
+        size_t since_scan, idle;
+
+        explicit record(const void *id)
+            : state(0), depth(0), owner(id), next(nullptr), busy(false), since_scan(0), idle(0) {
+            bag_epoch[0] = bag_epoch[1] = bag_epoch[2] = 0;
+        }
+        void lock() {
+            while (busy.exchange(true, std::memory_order_acquire))
+                std::this_thread::yield();
+        }
+        bool try_lock() {
+            return !busy.exchange(true, std::memory_order_acquire);
+        }
+        void unlock() {
+            busy.store(false, std::memory_order_release);
+        }
+    };
+
+    /**
+     * the serials of the domains alive now. a thread that exits gives its
+     * records back only in those, under the lock, so a domain being destroyed
+     * waits for it.
+     */
+    struct registry {
+        std::mutex m;
+        std::set<size_t> live;
+    };
+    static registry &domains() {
+        static registry r;
+        return r;
+    }
+    // the records a thread holds; its address tells the thread apart while it lives
+    struct owned {
+        std::vector<std::pair<size_t, record *> > held;
+        size_t prune_at;
+
+        owned() : prune_at(8) {}
+        ~owned() {
+            registry &g = domains();
+            std::lock_guard<std::mutex> l(g.m);
+            for (size_t i = 0; i < held.size(); i++)
+                if (g.live.count(held[i].first))
+                    held[i].second->owner.store(nullptr, std::memory_order_release);
+        }
+        void add(size_t serial, record *r) {
+            if (held.size() >= prune_at) {
+                // forget the domains that are gone, so a thread making many maps stays small
+                registry &g = domains();
+                std::lock_guard<std::mutex> l(g.m);
+                size_t k = 0;
+                for (size_t i = 0; i < held.size(); i++)
+                    if (g.live.count(held[i].first))
+                        held[k++] = held[i];
+                held.resize(k);
+                prune_at = 2 * k < 8 ? 8 : 2 * k;
+            }
+            held.push_back(std::make_pair(serial, r));
+        }
+    };
+    static owned &mine() {
+        static thread_local owned o;
+        return o;
+    }
+
+    // retiring this many nodes while pinned, or unpinning this many times while
+    // anything is left, makes a thread try to move the epoch on
+    static const size_t scan_every = 64;
+
+    std::atomic<size_t> global;
+    std::atomic<record *> records;
+    std::atomic<size_t> pending; // retired and not freed yet
+    size_t serial;
+
+    static size_t next_serial() {
+        static std::atomic<size_t> s(0);
+        return ++s;
+    }
+
+    /**
+     * the record of the calling thread: its own, one an exited thread left, or a
+     * new one. a small thread-local cache keyed by the domain's serial, which is
+     * never reused, saves the walk over the records.
+     */
+    record *local() {
+        struct entry {
+            size_t serial;
+            record *r;
+        };
+        static thread_local entry cache[4];
+        entry &c = cache[serial & 3];
+        if (c.serial == serial)
+            return c.r;
+        owned &o = mine();
+        const void *me = &o;
+        record *r = records.load(std::memory_order_acquire);
+        while (r != nullptr && r->owner.load(std::memory_order_relaxed) != me)
+            r = r->next;
+        if (r == nullptr) {
+            for (r = records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+                const void *none = nullptr;
+                if (r->owner.load(std::memory_order_relaxed) == nullptr &&
+                    r->owner.compare_exchange_strong(none, me, std::memory_order_acquire))
+                    break;
+            }
+            if (r == nullptr) {
+                r = new record(me);
+                record *head = records.load(std::memory_order_relaxed);
+                do
+                    r->next = head;
+                while (!records.compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+            }
+            o.add(serial, r);
+        }
+        c.serial = serial, c.r = r;
+        return r;
+    }
+
+    void free_bag(std::vector<retired> &bag) {
+        if (bag.empty())
+            return;
+        for (size_t i = 0; i < bag.size(); i++)
+            bag[i].fn(bag[i].ctx, bag[i].p);
+        pending.fetch_sub(bag.size(), std::memory_order_relaxed);
+        bag.clear();
+    }
+    // whether every pinned thread has seen epoch e
+    bool settled(size_t e) const {
+        for (record *r = records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+            size_t s = r->state.load(std::memory_order_acquire);
+            if ((s & 1) && (s >> 1) != e)
+                return false;
+        }
+        return true;
+    }
+    /**
+     * move the epoch on as far as the pinned threads allow, at most twice, then
+     * free what has become safe in every thread's bags. a bag another scanner
+     * holds is left for later.
+     */
+    void scan() {
+        size_t e = global.load(std::memory_order_acquire);
+        for (int round = 0; round < 2; round++) {
+            // pairs with the fence in pin(): a pin we miss here comes after our unlinks
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!settled(e))
+                break;
+            if (global.compare_exchange_strong(e, e + 1, std::memory_order_acq_rel))
+                e++;
+        }
+        for (record *r = records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+            if (!r->try_lock())
+                continue;
+            for (int i = 0; i < 3; i++)
+                if (!r->bag[i].empty() && r->bag_epoch[i] + 2 <= e)
+                    free_bag(r->bag[i]);
+            r->unlock();
+        }
+    }
+
+    void unpin(record *r) {
+        if (--r->depth != 0)
+            return;
+        r->state.store(0, std::memory_order_release);
+        if (r->since_scan != 0 || (pending.load(std::memory_order_relaxed) != 0 && ++r->idle >= scan_every)) {
+            r->since_scan = r->idle = 0;
+            scan();
+        }
+    }
+
+public:
+    // keeps the calling thread pinned while it lives
+    class guard {
+        friend class epoch_domain;
+        epoch_domain *d;
+        record *r;
+
+        guard(epoch_domain *_d, record *_r) : d(_d), r(_r) {}
+
+    public:
+        guard() : d(nullptr), r(nullptr) {}
+        guard(const guard &o) : d(o.d), r(o.r) {
+            if (r != nullptr)
+                r->depth++;
+        }
+        guard &operator=(const guard &o) {
+            if (o.r != nullptr)
+                o.r->depth++;
+            if (r != nullptr)
+                d->unpin(r);
+            d = o.d, r = o.r;
+            return *this;
+        }
+        ~guard() {
+            if (r != nullptr)
+                d->unpin(r);
+        }
+    };
+
+    epoch_domain() : global(2), records(nullptr), pending(0), serial(next_serial()) {
+        registry &g = domains();
+        std::lock_guard<std::mutex> l(g.m);
+        g.live.insert(serial);
+    }
+    epoch_domain(const epoch_domain &) = delete;
+    epoch_domain &operator=(const epoch_domain &) = delete;
+    ~epoch_domain() {
+        {
+            registry &g = domains();
+            std::lock_guard<std::mutex> l(g.m);
+            g.live.erase(serial);
+        }
+        record *r = records.load(std::memory_order_acquire);
+        while (r != nullptr) {
+            for (int i = 0; i < 3; i++)
+                free_bag(r->bag[i]);
+            record *n = r->next;
+            delete r;
+            r = n;
+        }
+    }
+
+    guard pin() {
+        record *r = local();
+        if (r->depth++ == 0) {
+            r->state.store(global.load(std::memory_order_acquire) << 1 | 1, std::memory_order_relaxed);
+            // the pin must be visible before any shared pointer is read
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        return guard(this, r);
+    }
+
+    /**
+     * hand over p, already unreachable for threads that pin from now on, to be
+     * freed by fn(ctx, p) once no pinned thread can hold it. the caller must be pinned.
+     */
+    void retire(void *p, reclaim_fn fn, void *ctx) {
+        record *r = local();
+        /*
+         * tag p with the global epoch, not with the one this thread pinned in:
+         * a pin may lag behind the global epoch, and threads that pinned after it
+         * can still hold p.
+         */
+        size_t e = global.load(std::memory_order_acquire);
+        int i = e % 3;
+        retired x = {p, fn, ctx};
+        pending.fetch_add(1, std::memory_order_relaxed);
+        r->lock();
+        if (r->bag_epoch[i] != e) {
+            // what is left there was retired at least three epochs ago
+            free_bag(r->bag[i]);
+            r->bag_epoch[i] = e;
+        }
+        try {
+            r->bag[i].push_back(x);
+        } catch (...) {
+            r->unlock();
+            pending.fetch_sub(1, std::memory_order_relaxed);
+            throw;
+        }
+        r->unlock();
+        if (++r->since_scan >= scan_every) {
+            r->since_scan = 0;
+            scan();
+        }
+    }
+};
+
+}
+
+#endif
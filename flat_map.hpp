@@ -0,0 +1,853 @@
+#ifndef SJTU_FLAT_MAP_HPP
+#define SJTU_FLAT_MAP_HPP
+
+#include <algorithm>
+#include <functional>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "map.hpp"
+
+namespace sjtu {
+
+/**
+ * an ordered map kept as one sorted array of values, for tables that are built
+ * once and then mostly read: lookups are binary searches over contiguous memory,
+ * iteration is a linear scan, and there is no per-element allocation.
+ * insert and erase shift the elements after the position, in O(n), and like any
+ * growth of the array they invalidate iterators.
+ * keys and values are moved by construction, never assigned. when a move may
+ * throw and the value can be copied, insert and erase copy into a new array
+ * instead, so a throw leaves the map as it was.
+ */
+template<
+    class Key,
+    class T,
+    class Compare = std::less<Key>,
+    class Allocator = std::allocator<pair<const Key, T>>
+> class flat_map {
+public:
+    typedef pair<const Key, T> value_type;
+    typedef Allocator allocator_type;
+
+private:
+    typedef std::allocator_traits<Allocator> value_traits;
+    // whether shifting must copy, because a move may throw halfway through
+    typedef std::integral_constant<bool, !(std::is_nothrow_move_constructible<Key>::value &&
+                                           std::is_nothrow_move_constructible<T>::value) &&
+                                         std::is_copy_constructible<value_type>::value> copy_shift;
+
+    value_type *data;
+    size_t _size, cap;
+    Compare cmp;
+    Allocator alloc;
+
+    // the key is only const to users: a value that is destroyed right after gives it up too
+    static void move_construct(value_type *dst, value_type &src) {
+        new (dst) value_type(std::move(const_cast<Key &>(src.first)), std::move(src.second));
+    }
+    // move n values from src to dst, which may overlap, by construction
+    static void relocate(value_type *dst, value_type *src, size_t n) {
+        if (n == 0 || dst == src)
+            return;
+        if (std::is_trivially_copyable<value_type>::value) {
+            std::memmove(static_cast<void *>(dst), static_cast<const void *>(src), n * sizeof(value_type));
+        } else if (dst < src) {
+            for (size_t i = 0; i < n; i++) {
+                move_construct(dst + i, src[i]);
+                src[i].~value_type();
+            }
+        } else {
+            for (size_t i = n; i-- > 0;) {
+                move_construct(dst + i, src[i]);
+                src[i].~value_type();
+            }
+        }
+    }
+    void copy_construct(value_type *dst, value_type &src, std::true_type) {
+        value_traits::construct(alloc, dst, static_cast<const value_type &>(src));
+    }
+    void copy_construct(value_type *dst, value_type &src, std::false_type) {
+        move_construct(dst, src);
+    }
+    /**
+     * fill the new array d with copies of the values before i and from i + skip
+     * on, leaving gap free slots at i. on a throw d holds nothing and the old
+     * array is untouched; otherwise the old array is freed.
+     */
+    void copy_around(value_type *d, size_t n, size_t i, size_t skip, size_t gap) {
+        size_t k = 0;
+        try {
+            for (; k < i; k++)
+                copy_construct(d + k, data[k], copy_shift());
+            for (; k + skip < _size; k++)
+                copy_construct(d + k + gap, data[k + skip], copy_shift());
+        } catch (...) {
+            while (k-- > 0)
+                value_traits::destroy(alloc, d + (k < i ? k : k + gap));
+            throw;
+        }
+        for (size_t j = 0; j < _size; j++)
+            value_traits::destroy(alloc, data + j);
+        if (data != nullptr)
+            value_traits::deallocate(alloc, data, cap);
+        data = d, cap = n;
+    }
+    void release() {
+        for (size_t i = 0; i < _size; i++)
+            value_traits::destroy(alloc, data + i);
+        if (data != nullptr)
+            value_traits::deallocate(alloc, data, cap);
+        data = nullptr;
+        _size = cap = 0;
+    }
+    void grow_to(size_t n) {
+        value_type *d = value_traits::allocate(alloc, n);
+        if (copy_shift::value) {
+            try {
+                copy_around(d, n, _size, 0, 0);
+            } catch (...) {
+                value_traits::deallocate(alloc, d, n);
+                throw;
+            }
+            return;
+        }
+        relocate(d, data, _size);
+        if (data != nullptr)
+            value_traits::deallocate(alloc, data, cap);
+        data = d, cap = n;
+    }
+    // copy (or move) n values in order from it into the empty array; on a throw it is left empty
+    template<class InputIt>
+    void fill(InputIt it, size_t n) {
+        try {
+            if (n > cap)
+                grow_to(n);
+            for (; _size < n; ++it, _size++)
+                value_traits::construct(alloc, data + _size, *it);
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    template<class K>
+    size_t lower_pos(const K &k) const {
+        size_t lo = 0, hi = _size;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (cmp(data[mid].first, k))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+    template<class K>
+    size_t upper_pos(const K &k) const {
+        size_t lo = 0, hi = _size;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (cmp(k, data[mid].first))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        return lo;
+    }
+    template<class K>
+    size_t find_pos(const K &k) const {
+        size_t i = lower_pos(k);
+        return i < _size && !cmp(k, data[i].first) ? i : _size;
+    }
+    template<class K>
+    bool has_key_at(size_t i, const K &k) const {
+        return i < _size && !cmp(k, data[i].first);
+    }
+
+    /**
+     * construct a new value at position i from args. when the array is full, or
+     * shifting must copy, the value goes straight into a new buffer, so a throw
+     * leaves everything as it was.
+     */
+    template<class... Args>
+    size_t insert_at(size_t i, Args&&... args) {
+        if (_size == cap || copy_shift::value) {
+            size_t n = _size == cap ? (cap < 8 ? 8 : cap * 2) : cap;
+            value_type *d = value_traits::allocate(alloc, n);
+            try {
+                value_traits::construct(alloc, d + i, std::forward<Args>(args)...);
+            } catch (...) {
+                value_traits::deallocate(alloc, d, n);
+                throw;
+            }
+            if (copy_shift::value) {
+                try {
+                    copy_around(d, n, i, 0, 1);
+                } catch (...) {
+                    value_traits::destroy(alloc, d + i);
+                    value_traits::deallocate(alloc, d, n);
+                    throw;
+                }
+                _size++;
+                return i;
+            }
+            relocate(d, data, i);
+            relocate(d + i + 1, data + i, _size - i);
+            if (data != nullptr)
+                value_traits::deallocate(alloc, data, cap);
+            data = d, cap = n;
+        } else {
+            relocate(data + i + 1, data + i, _size - i);
+            try {
+                value_traits::construct(alloc, data + i, std::forward<Args>(args)...);
+            } catch (...) {
+                relocate(data + i, data + i + 1, _size - i);
+                throw;
+            }
+        }
+        _size++;
+        return i;
+    }
+    void erase_at(size_t i, size_t n) {
+        if (copy_shift::value && n != 0 && i + n < _size) {
+            value_type *d = value_traits::allocate(alloc, cap);
+            try {
+                copy_around(d, cap, i, n, 0);
+            } catch (...) {
+                value_traits::deallocate(alloc, d, cap);
+                throw;
+            }
+            _size -= n;
+            return;
+        }
+        for (size_t j = i; j < i + n; j++)
+            value_traits::destroy(alloc, data + j);
+        relocate(data + i, data + i + n, _size - i - n);
+        _size -= n;
+    }
+
+public:
+    class const_iterator;
+    class iterator {
+        friend class flat_map;
+        friend const_iterator;
+
+    public:
+        typedef pair<const Key, T> value_type;
+        typedef value_type&         reference;
+        typedef value_type*           pointer;
+        typedef std::ptrdiff_t        difference_type;
+        typedef std::random_access_iterator_tag iterator_category;
+
+    private:
+        flat_map *_map;
+        value_type *p;
+
+    public:
+        iterator() : _map(nullptr), p(nullptr) {}
+        iterator(const iterator &o) : _map(o._map), p(o.p) {}
+        iterator(flat_map *__map, value_type *_p) : _map(__map), p(_p) {}
+        iterator &operator=(const iterator &o) {
+            _map = o._map, p = o.p;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator res(*this);
+            ++*this;
+            return res;
+        }
+        iterator &operator++() {
+            if (_map == nullptr || p == _map->data + _map->_size)
+                throw invalid_iterator();
+            ++p;
+            return *this;
+        }
+        iterator operator--(int) {
+            iterator res(*this);
+            --*this;
+            return res;
+        }
+        iterator &operator--() {
+            if (_map == nullptr || p == _map->data)
+                throw invalid_iterator();
+            --p;
+            return *this;
+        }
+
+        /**
+         * random access in O(1).
+         * throw if the result would leave [begin(), end()].
+         */
+        iterator &operator+=(difference_type n) {
+            if (_map == nullptr || n < _map->data - p || n > _map->data + _map->_size - p)
+                throw invalid_iterator();
+            p += n;
+            return *this;
+        }
+        iterator &operator-=(difference_type n) {
+            return *this += -n;
+        }
+        iterator operator+(difference_type n) const {
+            iterator res(*this);
+            return res += n;
+        }
+        iterator operator-(difference_type n) const {
+            iterator res(*this);
+            return res -= n;
+        }
+        difference_type operator-(const const_iterator &o) const {
+            if (_map != o._map)
+                throw invalid_iterator();
+            return p - o.p;
+        }
+        reference operator[](difference_type n) const {
+            return *(*this + n);
+        }
+        bool operator<(const const_iterator &o) const {
+            return *this - o < 0;
+        }
+        bool operator>(const const_iterator &o) const {
+            return *this - o > 0;
+        }
+        bool operator<=(const const_iterator &o) const {
+            return *this - o <= 0;
+        }
+        bool operator>=(const const_iterator &o) const {
+            return *this - o >= 0;
+        }
+
+        reference operator*() const {
+            return *p;
+        }
+        pointer operator->() const noexcept {
+            return p;
+        }
+
+        bool operator==(const iterator &o) const {
+            return _map == o._map && p == o.p;
+        }
+        bool operator==(const const_iterator &o) const {
+            return _map == o._map && p == o.p;
+        }
+        bool operator!=(const iterator &o) const {
+            return _map != o._map || p != o.p;
+        }
+        bool operator!=(const const_iterator &o) const {
+            return _map != o._map || p != o.p;
+        }
+    };
+    class const_iterator {
+        friend class flat_map;
+        friend iterator;
+
+    public:
+        typedef const pair<const Key, T> value_type;
+        typedef value_type&         reference;
+        typedef value_type*           pointer;
+        typedef std::ptrdiff_t        difference_type;
+        typedef std::random_access_iterator_tag iterator_category;
+
+    private:
+        const flat_map *_map;
+        const typename flat_map::value_type *p;
+
+    public:
+        const_iterator() : _map(nullptr), p(nullptr) {}
+        const_iterator(const iterator &o) : _map(o._map), p(o.p) {}
+        const_iterator(const const_iterator &o) : _map(o._map), p(o.p) {}
+        const_iterator(const flat_map *__map, const typename flat_map::value_type *_p) : _map(__map), p(_p) {}
+        const_iterator &operator=(const const_iterator &o) {
+            _map = o._map, p = o.p;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator res(*this);
+            ++*this;
+            return res;
+        }
+        const_iterator &operator++() {
+            if (_map == nullptr || p == _map->data + _map->_size)
+                throw invalid_iterator();
+            ++p;
+            return *this;
+        }
+        const_iterator operator--(int) {
+            const_iterator res(*this);
+            --*this;
+            return res;
+        }
+        const_iterator &operator--() {
+            if (_map == nullptr || p == _map->data)
+                throw invalid_iterator();
+            --p;
+            return *this;
+        }
+
+        const_iterator &operator+=(difference_type n) {
+            if (_map == nullptr || n < _map->data - p || n > _map->data + _map->_size - p)
+                throw invalid_iterator();
+            p += n;
+            return *this;
+        }
+        const_iterator &operator-=(difference_type n) {
+            return *this += -n;
+        }
+        const_iterator operator+(difference_type n) const {
+            const_iterator res(*this);
+            return res += n;
+        }
+        const_iterator operator-(difference_type n) const {
+            const_iterator res(*this);
+            return res -= n;
+        }
+        difference_type operator-(const const_iterator &o) const {
+            if (_map != o._map)
+                throw invalid_iterator();
+            return p - o.p;
+        }
+        reference operator[](difference_type n) const {
+            return *(*this + n);
+        }
+        bool operator<(const const_iterator &o) const {
+            return *this - o < 0;
+        }
+        bool operator>(const const_iterator &o) const {
+            return *this - o > 0;
+        }
+        bool operator<=(const const_iterator &o) const {
+            return *this - o <= 0;
+        }
+        bool operator>=(const const_iterator &o) const {
+            return *this - o >= 0;
+        }
+
+        reference operator*() const {
+            return *p;
+        }
+        pointer operator->() const noexcept {
+            return p;
+        }
+
+        bool operator==(const iterator &o) const {
+            return _map == o._map && p == o.p;
+        }
+        bool operator==(const const_iterator &o) const {
+            return _map == o._map && p == o.p;
+        }
+        bool operator!=(const iterator &o) const {
+            return _map != o._map || p != o.p;
+        }
+        bool operator!=(const const_iterator &o) const {
+            return _map != o._map || p != o.p;
+        }
+    };
+
+private:
+    size_t hint_pos(const const_iterator &hint) const {
+        if (hint._map != this)
+            throw invalid_iterator();
+        return hint.p - data;
+    }
+    // where k belongs, trying just before the hint first
+    template<class K>
+    size_t insert_pos(size_t h, const K &k) const {
+        if ((h == 0 || cmp(data[h - 1].first, k)) && (h == _size || !cmp(data[h].first, k)))
+            return h;
+        return lower_pos(k);
+    }
+    template<class K, class... Args>
+    pair<iterator, bool> insert_key(size_t i, const K &k, Args&&... args) {
+        if (has_key_at(i, k))
+            return pair<iterator, bool>(iterator(this, data + i), false);
+        i = insert_at(i, std::forward<Args>(args)...);
+        return pair<iterator, bool>(iterator(this, data + i), true);
+    }
+
+public:
+    flat_map() : data(nullptr), _size(0), cap(0), cmp(), alloc() {}
+    explicit flat_map(const Allocator &a) : data(nullptr), _size(0), cap(0), cmp(), alloc(a) {}
+    flat_map(const flat_map &o) : data(nullptr), _size(0), cap(0), cmp(o.cmp),
+                                  alloc(value_traits::select_on_container_copy_construction(o.alloc)) {
+        fill(o.data, o._size);
+    }
+    flat_map(const flat_map &o, const Allocator &a) : data(nullptr), _size(0), cap(0), cmp(o.cmp), alloc(a) {
+        fill(o.data, o._size);
+    }
+    flat_map(flat_map &&o) noexcept : data(o.data), _size(o._size), cap(o.cap),
+                                      cmp(std::move(o.cmp)), alloc(std::move(o.alloc)) {
+        o.data = nullptr;
+        o._size = o.cap = 0;
+    }
+    /**
+     * build from [first, last), which must be sorted by Compare and free of
+     * duplicate keys, in O(n) and one allocation.
+     */
+    template<class ForwardIt>
+    flat_map(sorted_unique_t, ForwardIt first, ForwardIt last, const Allocator &a = Allocator())
+        : data(nullptr), _size(0), cap(0), cmp(), alloc(a) {
+        fill(first, std::distance(first, last));
+    }
+    /**
+     * build from any range in O(n log n): the values are gathered, sorted once and
+     * laid out in order. of several values with the same key the first one is kept,
+     * as if they had been inserted one by one.
+     */
+    template<class InputIt, class = typename std::iterator_traits<InputIt>::iterator_category>
+    flat_map(InputIt first, InputIt last, const Allocator &a = Allocator())
+        : data(nullptr), _size(0), cap(0), cmp(), alloc(a) {
+        flat_map raw(a);
+        for (; first != last; ++first)
+            raw.insert_at(raw._size, *first);
+        std::vector<value_type *> order(raw._size);
+        for (size_t i = 0; i < raw._size; i++)
+            order[i] = raw.data + i;
+        const Compare &c = cmp;
+        std::stable_sort(order.begin(), order.end(), [&c](const value_type *x, const value_type *y) {
+            return c(x->first, y->first);
+        });
+        if (order.empty())
+            return;
+        try {
+            grow_to(order.size());
+            for (size_t i = 0; i < order.size(); i++)
+                if (_size == 0 || cmp(data[_size - 1].first, order[i]->first)) {
+                    move_construct(data + _size, *order[i]);
+                    _size++;
+                }
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+    /**
+     * take the content of a sjtu::map in one linear pass and one allocation.
+     * the opposite way is the sorted_unique constructor of sjtu::map over
+     * begin() and end().
+     */
+    template<class MapAllocator, bool Ranked, bool Checked>
+    explicit flat_map(const map<Key, T, Compare, MapAllocator, Ranked, Checked> &m, const Allocator &a = Allocator())
+        : data(nullptr), _size(0), cap(0), cmp(), alloc(a) {
+        fill(m.cbegin(), m.size());
+    }
+    ~flat_map() {
+        release();
+    }
+
+    flat_map &operator=(const flat_map &o) {
+        if (this == &o)
+            return *this;
+        clear();
+        cmp = o.cmp;
+        if (value_traits::propagate_on_container_copy_assignment::value && alloc != o.alloc) {
+            release();
+            alloc = o.alloc;
+        }
+        fill(o.data, o._size);
+        return *this;
+    }
+    flat_map &operator=(flat_map &&o) noexcept(value_traits::propagate_on_container_move_assignment::value) {
+        if (this == &o)
+            return *this;
+        cmp = std::move(o.cmp);
+        if (value_traits::propagate_on_container_move_assignment::value || alloc == o.alloc) {
+            release();
+            if (value_traits::propagate_on_container_move_assignment::value)
+                alloc = std::move(o.alloc);
+            data = o.data, _size = o._size, cap = o.cap;
+            o.data = nullptr;
+            o._size = o.cap = 0;
+        } else {
+            clear();
+            fill(std::make_move_iterator(o.data), o._size);
+            o.release();
+        }
+        return *this;
+    }
+    void swap(flat_map &o) noexcept {
+        std::swap(data, o.data), std::swap(_size, o._size), std::swap(cap, o.cap);
+        using std::swap;
+        swap(cmp, o.cmp);
+        if (value_traits::propagate_on_container_swap::value)
+            swap(alloc, o.alloc);
+    }
+    allocator_type get_allocator() const {
+        return alloc;
+    }
+
+    T &at(const Key &key) {
+        size_t i = find_pos(key);
+        if (i == _size)
+            throw index_out_of_bound();
+        return data[i].second;
+    }
+    const T &at(const Key &key) const {
+        size_t i = find_pos(key);
+        if (i == _size)
+            throw index_out_of_bound();
+        return data[i].second;
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    T &at(const K &key) {
+        size_t i = find_pos(key);
+        if (i == _size)
+            throw index_out_of_bound();
+        return data[i].second;
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const T &at(const K &key) const {
+        size_t i = find_pos(key);
+        if (i == _size)
+            throw index_out_of_bound();
+        return data[i].second;
+    }
+    T &operator[](const Key &key) {
+        return try_emplace(key).first->second;
+    }
+    T &operator[](Key &&key) {
+        return try_emplace(std::move(key)).first->second;
+    }
+    // behave like at(): throw index_out_of_bound if no such element exists
+    const T &operator[](const Key &key) const {
+        return at(key);
+    }
+
+    iterator begin() {
+        return iterator(this, data);
+    }
+    const_iterator begin() const {
+        return const_iterator(this, data);
+    }
+    const_iterator cbegin() const {
+        return const_iterator(this, data);
+    }
+    iterator end() {
+        return iterator(this, data + _size);
+    }
+    const_iterator end() const {
+        return const_iterator(this, data + _size);
+    }
+    const_iterator cend() const {
+        return const_iterator(this, data + _size);
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+    size_t size() const {
+        return _size;
+    }
+    size_t capacity() const {
+        return cap;
+    }
+    void reserve(size_t n) {
+        if (n > cap)
+            grow_to(n);
+    }
+    void shrink_to_fit() {
+        if (_size == 0)
+            release();
+        else if (_size < cap)
+            grow_to(_size);
+    }
+    // destroy every element but keep the array for reuse
+    void clear() {
+        for (size_t i = 0; i < _size; i++)
+            value_traits::destroy(alloc, data + i);
+        _size = 0;
+    }
+
+    /**
+     * insert value if its key is absent.
+     * return a pair of the iterator to the element with that key, and whether
+     * the insertion took place.
+     */
+    pair<iterator, bool> insert(const value_type &value) {
+        return insert_key(lower_pos(value.first), value.first, value);
+    }
+    pair<iterator, bool> insert(value_type &&value) {
+        return insert_key(lower_pos(value.first), value.first, std::move(value));
+    }
+    /**
+     * insert with a hint: when the value belongs right before hint no search
+     * is made, so appending a sorted sequence at end() costs amortized O(1).
+     * throw invalid_iterator if hint is not an iterator of this map.
+     */
+    iterator insert(const_iterator hint, const value_type &value) {
+        return insert_key(insert_pos(hint_pos(hint), value.first), value.first, value).first;
+    }
+    iterator insert(const_iterator hint, value_type &&value) {
+        return insert_key(insert_pos(hint_pos(hint), value.first), value.first, std::move(value)).first;
+    }
+    template<class... Args>
+    pair<iterator, bool> emplace(Args&&... args) {
+        typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type buf;
+        value_type *v = reinterpret_cast<value_type *>(&buf);
+        value_traits::construct(alloc, v, std::forward<Args>(args)...);
+        try {
+            pair<iterator, bool> res = insert_key(lower_pos(v->first), v->first,
+                                                  std::move(const_cast<Key &>(v->first)), std::move(v->second));
+            value_traits::destroy(alloc, v);
+            return res;
+        } catch (...) {
+            value_traits::destroy(alloc, v);
+            throw;
+        }
+    }
+    template<class... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args) {
+        hint_pos(hint);
+        return emplace(std::forward<Args>(args)...).first;
+    }
+    template<class... Args>
+    pair<iterator, bool> try_emplace(const Key &key, Args&&... args) {
+        size_t i = lower_pos(key);
+        if (has_key_at(i, key))
+            return pair<iterator, bool>(iterator(this, data + i), false);
+        i = insert_at(i, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        return pair<iterator, bool>(iterator(this, data + i), true);
+    }
+    template<class... Args>
+    pair<iterator, bool> try_emplace(Key &&key, Args&&... args) {
+        size_t i = lower_pos(key);
+        if (has_key_at(i, key))
+            return pair<iterator, bool>(iterator(this, data + i), false);
+        i = insert_at(i, std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+        return pair<iterator, bool>(iterator(this, data + i), true);
+    }
+    template<class M>
+    pair<iterator, bool> insert_or_assign(const Key &key, M &&obj) {
+        size_t i = lower_pos(key);
+        if (has_key_at(i, key)) {
+            data[i].second = std::forward<M>(obj);
+            return pair<iterator, bool>(iterator(this, data + i), false);
+        }
+        i = insert_at(i, key, std::forward<M>(obj));
+        return pair<iterator, bool>(iterator(this, data + i), true);
+    }
+    template<class M>
+    pair<iterator, bool> insert_or_assign(Key &&key, M &&obj) {
+        size_t i = lower_pos(key);
+        if (has_key_at(i, key)) {
+            data[i].second = std::forward<M>(obj);
+            return pair<iterator, bool>(iterator(this, data + i), false);
+        }
+        i = insert_at(i, std::move(key), std::forward<M>(obj));
+        return pair<iterator, bool>(iterator(this, data + i), true);
+    }
+
+    /**
+     * erase the element at pos.
+     * throw if pos pointed to a bad element (pos == this->end() || pos points an element out of this)
+     */
+    void erase(iterator pos) {
+        if (this != pos._map || pos.p == data + _size)
+            throw invalid_iterator();
+        erase_at(pos.p - data, 1);
+    }
+    /**
+     * erase every element in [first, last) with a single shift.
+     * throw if either iterator is out of this or last comes before first.
+     */
+    void erase(iterator first, iterator last) {
+        if (this != first._map || this != last._map || last.p < first.p)
+            throw invalid_iterator();
+        erase_at(first.p - data, last.p - first.p);
+    }
+    /**
+     * erase the element with the given key, if any.
+     * return the number of elements removed (0 or 1).
+     */
+    size_t erase(const Key &key) {
+        size_t i = find_pos(key);
+        if (i == _size)
+            return 0;
+        erase_at(i, 1);
+        return 1;
+    }
+
+    size_t count(const Key &key) const {
+        return find_pos(key) != _size ? 1 : 0;
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    size_t count(const K &key) const {
+        // a probe may be equivalent to several keys
+        return upper_pos(key) - lower_pos(key);
+    }
+    iterator find(const Key &key) {
+        return iterator(this, data + find_pos(key));
+    }
+    const_iterator find(const Key &key) const {
+        return const_iterator(this, data + find_pos(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    iterator find(const K &key) {
+        return iterator(this, data + find_pos(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator find(const K &key) const {
+        return const_iterator(this, data + find_pos(key));
+    }
+
+    // first element whose key is not less than key
+    iterator lower_bound(const Key &key) {
+        return iterator(this, data + lower_pos(key));
+    }
+    const_iterator lower_bound(const Key &key) const {
+        return const_iterator(this, data + lower_pos(key));
+    }
+    // first element whose key is greater than key
+    iterator upper_bound(const Key &key) {
+        return iterator(this, data + upper_pos(key));
+    }
+    const_iterator upper_bound(const Key &key) const {
+        return const_iterator(this, data + upper_pos(key));
+    }
+    pair<iterator, iterator> equal_range(const Key &key) {
+        return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+    }
+    pair<const_iterator, const_iterator> equal_range(const Key &key) const {
+        return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    iterator lower_bound(const K &key) {
+        return iterator(this, data + lower_pos(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator lower_bound(const K &key) const {
+        return const_iterator(this, data + lower_pos(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    iterator upper_bound(const K &key) {
+        return iterator(this, data + upper_pos(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator upper_bound(const K &key) const {
+        return const_iterator(this, data + upper_pos(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    pair<iterator, iterator> equal_range(const K &key) {
+        return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    pair<const_iterator, const_iterator> equal_range(const K &key) const {
+        return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+    }
+};
+
+template<class Key, class T, class Compare, class Allocator>
+void swap(flat_map<Key, T, Compare, Allocator> &a, flat_map<Key, T, Compare, Allocator> &b) noexcept {
+    a.swap(b);
+}
+
+}
+
+#endif
@@ -3,173 +3,1122 @@
 
 #include <functional>
 #include <cstddef>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define SJTU_MAP_HAS_PMR 1
+#endif
+#endif
+#ifndef SJTU_MAP_NO_THREADS
+#include <exception>
+#include <thread>
+#endif
 #include "utility.hpp"
 #include "exceptions.hpp"
 
 namespace sjtu {
 
+// the iterator policy of sjtu::map unless one is given: unchecked if SJTU_MAP_UNCHECKED is defined
+#ifdef SJTU_MAP_UNCHECKED
+constexpr bool map_checked_iterators = false;
+#else
+constexpr bool map_checked_iterators = true;
+#endif
+
+/**
+ * the key order of a map, made of its Compare. Compare is a less-than unless
+ * it opts in to being three-way: by a member compare(a, b), or by declaring
+ * is_three_way, which makes its own call three-way. a three-way result is
+ * negative, zero or positive as a is less than, equivalent to or greater than b.
+ * the return type alone decides nothing, since a less-than may well return int.
+ * either way operator() is less-than, and order() answers -1, 0 or 1 with one
+ * call of a three-way comparator or at most two of a less-than.
+ */
+template<class Compare>
+class key_order {
+    Compare c;
+
+    template<class A, class B>
+    struct kind {
+        template<class C>
+        static auto member(int) -> decltype(std::declval<const C &>().compare(std::declval<const A &>(),
+                                                                              std::declval<const B &>()), std::true_type());
+        template<class>
+        static std::false_type member(...);
+        template<class C, class = typename C::is_three_way>
+        static std::true_type call(int);
+        template<class>
+        static std::false_type call(...);
+
+        // 2: compare() member, 1: is_three_way, so the call is three-way, 0: a less-than
+        typedef std::integral_constant<int, decltype(member<Compare>(0))::value ? 2 :
+                                            decltype(call<Compare>(0))::value ? 1 : 0> type;
+    };
+
+    template<class R>
+    static int sign(const R &r) {
+        return r < 0 ? -1 : r > 0 ? 1 : 0;
+    }
+    template<class A, class B>
+    bool less(const A &a, const B &b, std::integral_constant<int, 2>) const {
+        return c.compare(a, b) < 0;
+    }
+    template<class A, class B>
+    bool less(const A &a, const B &b, std::integral_constant<int, 1>) const {
+        return c(a, b) < 0;
+    }
+    template<class A, class B>
+    bool less(const A &a, const B &b, std::integral_constant<int, 0>) const {
+        return c(a, b);
+    }
+    template<class A, class B>
+    int order(const A &a, const B &b, std::integral_constant<int, 2>) const {
+        return sign(c.compare(a, b));
+    }
+    template<class A, class B>
+    int order(const A &a, const B &b, std::integral_constant<int, 1>) const {
+        return sign(c(a, b));
+    }
+    template<class A, class B>
+    int order(const A &a, const B &b, std::integral_constant<int, 0>) const {
+        return c(a, b) ? -1 : c(b, a) ? 1 : 0;
+    }
+
+public:
+    // whether ordering an A against a B takes a single call of Compare
+    template<class A, class B>
+    struct three_way : std::integral_constant<bool, kind<A, B>::type::value != 0> {};
+
+    key_order() : c() {}
+
+    template<class A, class B>
+    bool operator()(const A &a, const B &b) const {
+        return less(a, b, typename kind<A, B>::type());
+    }
+    template<class A, class B>
+    int order(const A &a, const B &b) const {
+        return order(a, b, typename kind<A, B>::type());
+    }
+};
+
+/**
+ * with Ranked, every node also keeps the size of its subtree, which
+ * gives select/rank/count_range and iterator arithmetic in O(log n)
+ * at the price of one word per node and a walk to the root per update.
+ *
+ * with Checked, iterators keep their map and throw invalid_iterator when
+ * moved off either end or used with another map. without it they are a
+ * single node pointer (plus the map for arithmetic, if Ranked) and check
+ * nothing: stepping off an end is undefined, and ++/-- are one load each.
+ */
 template<
     class Key,
     class T,
-    class Compare = std::less<Key>
+    class Compare = std::less<Key>,
+    class Allocator = std::allocator<pair<const Key, T>>,
+    bool Ranked = false,
+    bool Checked = map_checked_iterators
 > class map {
 public:
     typedef pair<const Key, T> value_type;
+    typedef Allocator allocator_type;
+
+    /**
+     * one operation of a batch for apply_batch:
+     *   upsert: insert (key, value), or assign value if key is present;
+     *   erase: remove key.
+     * apply_batch records in result what the operation did.
+     */
+    struct batch_op {
+        enum op_type { upsert, erase };
+        enum result_type { inserted, updated, erased, missing };
+
+        Key key;
+        T value;
+        op_type type;
+        result_type result;
+
+        batch_op(const Key &k, const T &v) : key(k), value(v), type(upsert), result(missing) {}
+        batch_op(const Key &k, T &&v) : key(k), value(std::move(v)), type(upsert), result(missing) {}
+        explicit batch_op(const Key &k) : key(k), value(), type(erase), result(missing) {}
+    };
 
 public:
+    /**
+     * slab allocator for fixed-size objects.
+     * slots are carved out of geometrically growing slabs, and released
+     * slots go to a free list to be reused before the slab is bumped again.
+     * release() gives every slab back at once, without touching the slots.
+     * slabs are requested from Alloc, rebound to the slot type.
+     */
+    template<class U, class Alloc>
+    class pool {
+        struct slab_info {
+            void *next;
+            size_t capacity;
+        };
+        union slot {
+            slot *next;
+            slab_info info;
+            typename std::aligned_storage<sizeof(U), alignof(U)>::type storage;
+        };
+
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<slot> slot_allocator;
+        typedef std::allocator_traits<slot_allocator> slot_traits;
+
+        static const size_t min_capacity = 16;
+        static const size_t max_capacity = 65536;
+
+        slot_allocator alloc;
+        slot *slabs, *free_list, *free_tail; // free_tail is only meaningful while free_list is not empty
+        slot *cur, *cur_end;
+        size_t free_count, next_capacity;
+
+        // the first slot of every slab keeps the slab list, so a slab of n slots holds n - 1 objects
+        void grow(size_t n) {
+            slot *s = slot_traits::allocate(alloc, n + 1);
+            s->info.next = slabs;
+            s->info.capacity = n + 1;
+            slabs = s;
+            while (cur != cur_end)
+                deallocate(reinterpret_cast<U *>(cur++));
+            cur = s + 1, cur_end = s + n + 1;
+        }
+
+    public:
+        explicit pool(const Alloc &a) : alloc(a), slabs(nullptr), free_list(nullptr), free_tail(nullptr), cur(nullptr),
+                                        cur_end(nullptr), free_count(0), next_capacity(min_capacity) {}
+        pool(const pool &) = delete;
+        pool &operator=(const pool &) = delete;
+        pool(pool &&o) noexcept : alloc(std::move(o.alloc)), slabs(o.slabs), free_list(o.free_list), free_tail(o.free_tail), cur(o.cur),
+                                  cur_end(o.cur_end), free_count(o.free_count), next_capacity(o.next_capacity) {
+            o.forget();
+        }
+        ~pool() {
+            release();
+        }
+
+        U *allocate() {
+            if (free_list != nullptr) {
+                slot *s = free_list;
+                free_list = s->next;
+                free_count--;
+                return reinterpret_cast<U *>(s);
+            }
+            if (cur == cur_end) {
+                grow(next_capacity);
+                if (next_capacity < max_capacity)
+                    next_capacity <<= 1;
+            }
+            return reinterpret_cast<U *>(cur++);
+        }
+        void deallocate(U *p) {
+            slot *s = reinterpret_cast<slot *>(p);
+            if (free_list == nullptr)
+                free_tail = s;
+            s->next = free_list;
+            free_list = s;
+            free_count++;
+        }
+
+        size_t available() const {
+            return free_count + (cur_end - cur);
+        }
+        void reserve(size_t n) {
+            if (available() < n)
+                grow(n - available());
+        }
+        // n slots in a row, to be filled by the caller; they go back only with release()
+        U *allocate_run(size_t n) {
+            if (size_t(cur_end - cur) < n)
+                grow(n);
+            U *p = reinterpret_cast<U *>(cur);
+            cur += n;
+            return p;
+        }
+        static U *run_at(U *run, size_t i) {
+            return reinterpret_cast<U *>(reinterpret_cast<slot *>(run) + i);
+        }
+
+        void release() {
+            while (slabs != nullptr) {
+                slot *s = slabs;
+                slabs = static_cast<slot *>(s->info.next);
+                slot_traits::deallocate(alloc, s, s->info.capacity);
+            }
+            free_list = cur = cur_end = nullptr;
+            free_count = 0;
+            next_capacity = min_capacity;
+        }
+
+        // only for allocators that propagate, and only once every slab is released
+        void set_allocator(const Alloc &a) {
+            alloc = a;
+        }
+
+        void forget() {
+            slabs = free_list = cur = cur_end = nullptr;
+            free_count = 0;
+            next_capacity = min_capacity;
+        }
+        // take over every slab of o, whose allocator must compare equal to ours
+        void steal(pool &o) {
+            release();
+            slabs = o.slabs, free_list = o.free_list, free_tail = o.free_tail;
+            cur = o.cur, cur_end = o.cur_end;
+            free_count = o.free_count, next_capacity = o.next_capacity;
+            o.forget();
+        }
+        // take over the slabs of o but leave it its free slots, which stay valid while we live
+        void adopt_slabs(pool &o) {
+            if (o.slabs == nullptr)
+                return;
+            slot *t = o.slabs;
+            while (t->info.next != nullptr)
+                t = static_cast<slot *>(t->info.next);
+            t->info.next = slabs;
+            slabs = o.slabs;
+            o.slabs = nullptr;
+        }
+        // take over every slab of o and every slot o has not handed out, for allocators that compare equal
+        void absorb(pool &o) {
+            while (o.cur != o.cur_end)
+                o.deallocate(reinterpret_cast<U *>(o.cur++));
+            if (o.free_list != nullptr) {
+                o.free_tail->next = free_list;
+                if (free_list == nullptr)
+                    free_tail = o.free_tail;
+                free_list = o.free_list;
+                free_count += o.free_count;
+            }
+            adopt_slabs(o);
+            o.forget();
+        }
+        void swap(pool &o) {
+            std::swap(slabs, o.slabs), std::swap(free_list, o.free_list), std::swap(free_tail, o.free_tail);
+            std::swap(cur, o.cur), std::swap(cur_end, o.cur_end);
+            std::swap(free_count, o.free_count), std::swap(next_capacity, o.next_capacity);
+        }
+        void swap_allocator(pool &o) {
+            using std::swap;
+            swap(alloc, o.alloc);
+        }
+    };
+
+    // subtree size of a node; 0 in nil. unranked maps store nothing and never read it
+    template<bool R, class = void>
+    struct node_size {
+        size_t size() const { return 0; }
+        void set_size(size_t) {}
+    };
+    template<class V>
+    struct node_size<true, V> {
+        size_t cnt = 0;
+        size_t size() const { return cnt; }
+        void set_size(size_t n) { cnt = n; }
+    };
+
     class RBT {
     public:
-        struct node {
-            value_type *value;
+        struct node : node_size<Ranked> {
+            typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type storage;
             bool color; // 0 -> black, 1 -> red
             node *son[2], *fa;
             node *last, *next;
 
-            node() : value(nullptr), color(0) {
+            node() : color(0) {
                 son[0] = son[1] = fa = nullptr;
                 last = next = nullptr;
             }
-            node(const value_type &val, node* _nil = nullptr) : value(new value_type(val)) {
-                color = 0;
+            explicit node(node* _nil) : color(0) {
                 last = next = _nil;
                 son[0] = son[1] = fa = _nil;
             }
-            node(const node &o) {
-                value = new value_type(*o.value);
-                color = o.color;
-                last = o.last, next = o.next;
-                son[0] = o.son[0], son[1] = o.son[1];
-                fa = o.fa;
-            }
-            ~node() {
-                if (value != nullptr)
-                    delete value;
-            }
-            node &operator=(const node &o) {
-                if (this == &o)
-                    return *this;
-                delete value;
-                value = new value_type(*o.value), color = o.color;
-                son[0] = o.son[0], son[1] = o.son[1];
-                fa = o.fa;
-                last = o.last, next = o.next;
-                return *this;
+
+            // only meaningful for real nodes: nil never has a value constructed in it
+            value_type &value() {
+                return *reinterpret_cast<value_type *>(&storage);
+            }
+            const value_type &value() const {
+                return *reinterpret_cast<const value_type *>(&storage);
             }
         } *nil, *root;
 
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<node> node_allocator;
+        typedef std::allocator_traits<node_allocator> node_traits;
+
+        // no red-black tree that fits in memory is taller
+        static const size_t max_depth = 128;
+        // copies of at least this many elements are split over two threads
+        static const size_t parallel_clone_min = 1 << 16;
+
         size_t _size;
-        Compare cmp;
+        key_order<Compare> cmp;
+
+        node_allocator alloc;
+        pool<node, node_allocator> node_pool;
+
+        /**
+         * split and join hand nodes from one tree to another, so the slabs they live in
+         * can no longer belong to a single pool. such slabs go to an arena that lives as
+         * long as some tree refers to it; arenas that meet in a join are merged, the
+         * later one forwarding to the earlier through parent.
+         * no slab of an arena goes back to the allocator before the last tree sharing it
+         * is cleared or destroyed. until then a tree that is cleared hands its nodes and
+         * free slots to the arena, and the trees still sharing it take their new nodes
+         * from there before growing their own pools, so the memory held stays bounded by
+         * what the trees had in use at once.
+         */
+        struct arena {
+            pool<node, node_allocator> slabs;
+            arena *parent;
+            size_t refs;
+
+            explicit arena(const node_allocator &a) : slabs(a), parent(nullptr), refs(1) {}
+        };
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<arena> arena_allocator;
+        typedef std::allocator_traits<arena_allocator> arena_traits;
+
+        arena *shared; // nullptr as long as every node of the tree is in node_pool
+
+        // the arena that every arena of ours forwards to
+        arena *shared_root() const {
+            arena *a = shared;
+            while (a->parent != nullptr)
+                a = a->parent;
+            return a;
+        }
+        node *allocate_node() {
+            if (shared != nullptr && node_pool.available() == 0) {
+                arena *a = shared_root();
+                if (a->slabs.available() != 0)
+                    return a->slabs.allocate();
+            }
+            return node_pool.allocate();
+        }
+
+        template<class... Args>
+        node *create_node(Args&&... args) {
+            node *p = new (allocate_node()) node(nil);
+            try {
+                node_traits::construct(alloc, &p->value(), std::forward<Args>(args)...);
+            } catch (...) {
+                node_pool.deallocate(p);
+                throw;
+            }
+            return p;
+        }
+        void destroy_node(node *p) {
+            node_traits::destroy(alloc, &p->value());
+            node_pool.deallocate(p);
+        }
+
+        void create_nil() {
+            nil = new (node_traits::allocate(alloc, 1)) node;
+            nil->son[0] = nil->son[1] = nil->fa = nil->next = nil->last = nil;
+        }
+
+        /**
+         * a tree that has been moved from owns no nil at all (nil == root == nullptr):
+         * it still reads as empty, and gets a fresh nil before anything is put back into it.
+         */
+        void revive() {
+            if (nil == nullptr) {
+                create_nil();
+                root = nil;
+            }
+        }
+        /**
+         * make first..last the whole in-order thread, closing it into a ring through
+         * nil: nil->next is the minimum and nil->last the maximum (nil itself when empty).
+         */
+        void link_ends(node *first, node *last) {
+            nil->next = first, nil->last = last;
+            first->last = last->next = nil;
+        }
+        void release_nil() {
+            if (nil != nullptr)
+                node_traits::deallocate(alloc, nil, 1);
+            nil = root = nullptr;
+        }
+
+        void drop(arena *a) {
+            while (a != nullptr && --a->refs == 0) {
+                arena *p = a->parent;
+                arena_allocator aa(alloc);
+                arena_traits::destroy(aa, a);
+                arena_traits::deallocate(aa, a, 1);
+                a = p;
+            }
+        }
+        // move the slabs of node_pool to the arena, so nodes may leave this tree
+        arena* share() {
+            if (shared == nullptr) {
+                arena_allocator aa(alloc);
+                arena *a = arena_traits::allocate(aa, 1);
+                arena_traits::construct(aa, a, alloc);
+                shared = a;
+            } else if (shared->parent != nullptr) {
+                arena *a = shared->parent;
+                while (a->parent != nullptr)
+                    a = a->parent;
+                a->refs++;
+                drop(shared);
+                shared = a;
+            }
+            shared->slabs.adopt_slabs(node_pool);
+            return shared;
+        }
+
+        static const value_type &source(node *p, std::false_type) {
+            return p->value();
+        }
+        static value_type &&source(node *p, std::true_type) {
+            return std::move(p->value());
+        }
+        // a node in a slot of a run; should the value throw, the slot just stays unused
+        template<class... Args>
+        node *create_at(node *where, Args&&... args) {
+            node *p = new (where) node(nil);
+            node_traits::construct(alloc, &p->value(), std::forward<Args>(args)...);
+            return p;
+        }
 
-        void construct(node *&o, node *oo, node *f, node *oo_nil, node *&last_create) {
-            if (oo == oo_nil) {
-                o = nil;
+        /**
+         * copy the subtree oo of a tree whose nil is oo_nil into the slots from run on,
+         * without recursion, and thread the copies in key order from first to last.
+         * nothing outside the copy is touched (its root keeps fa == nil), so several
+         * subtrees may be cloned at once into different runs.
+         * on a throw the values built so far are destroyed again.
+         */
+        template<class Move>
+        node *clone(node *oo, node *oo_nil, node *run, node *&first, node *&last) {
+            node *src[max_depth], *dst[max_depth];
+            size_t top = 0;
+            node *res = nil, *f = nil, *prev = nil;
+            bool side = 0;
+            first = nil;
+            try {
+                while (true) {
+                    for (; oo != oo_nil; oo = oo->son[0]) {
+                        node *o = create_at(run, source(oo, Move()));
+                        run = node_pool.run_at(run, 1);
+                        o->fa = f;
+                        o->color = oo->color;
+                        o->set_size(oo->size());
+                        (f == nil ? res : f->son[side]) = o;
+                        src[top] = oo, dst[top++] = o;
+                        f = o, side = 0;
+                    }
+                    if (top == 0)
+                        break;
+                    node *o = dst[--top];
+                    o->last = prev;
+                    if (prev != nil)
+                        prev->next = o;
+                    else
+                        first = o;
+                    prev = o;
+                    f = o, side = 1;
+                    oo = src[top]->son[1];
+                }
+            } catch (...) {
+                if (res != nil)
+                    destroy_values(res);
+                throw;
+            }
+            last = prev;
+            return res;
+        }
+
+#ifndef SJTU_MAP_NO_THREADS
+        /**
+         * clone the left subtree of o's root on a second thread while this one copies
+         * the root and the right subtree, each into its own part of run.
+         * only for std::allocator, whose construct and heap may be used from two threads.
+         */
+        template<class Move>
+        node *clone_parallel(const RBT &o, node *run, node *&first, node *&last) {
+            node *oo = o.root, *p = oo;
+            size_t left = 0;
+            if (Ranked) {
+                left = oo->son[0]->size();
+            } else {
+                while (p->son[0] != o.nil)
+                    p = p->son[0];
+                for (; p != oo; p = p->next)
+                    left++;
+            }
+
+            node *lroot = nil, *lfirst = nil, *llast = nil;
+            std::exception_ptr error;
+            std::thread worker;
+            try {
+                worker = std::thread([&] {
+                    try {
+                        lroot = clone<Move>(oo->son[0], o.nil, run, lfirst, llast);
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+                });
+            } catch (...) {
+                return clone<Move>(oo, o.nil, run, first, last);
+            }
+
+            node *res = nullptr, *rroot = nil, *rfirst = nil, *rlast = nil;
+            try {
+                res = create_at(node_pool.run_at(run, left), source(oo, Move()));
+                rroot = clone<Move>(oo->son[1], o.nil, node_pool.run_at(run, left + 1), rfirst, rlast);
+            } catch (...) {
+                worker.join();
+                if (lroot != nil)
+                    destroy_values(lroot);
+                if (res != nullptr)
+                    node_traits::destroy(alloc, &res->value());
+                throw;
+            }
+            worker.join();
+            if (error) {
+                if (rroot != nil)
+                    destroy_values(rroot);
+                node_traits::destroy(alloc, &res->value());
+                std::rethrow_exception(error);
+            }
+
+            res->color = oo->color;
+            res->set_size(oo->size());
+            res->son[0] = lroot, res->son[1] = rroot;
+            if (lroot != nil)
+                lroot->fa = res;
+            if (rroot != nil)
+                rroot->fa = res;
+            first = lroot != nil ? lfirst : res;
+            last = rroot != nil ? rlast : res;
+            if (lroot != nil)
+                llast->next = res, res->last = llast;
+            if (rroot != nil)
+                res->next = rfirst, rfirst->last = res;
+            return res;
+        }
+#endif
+
+        /**
+         * with Move = std::true_type the values of o are moved out, leaving its shape intact.
+         * with parallel, large copies go through clone_parallel.
+         */
+        template<class Move>
+        void copy_from(const RBT &o, bool parallel = false) {
+            revive();
+            if (o._size == 0)
                 return;
+            // *this is empty, so the pool has nothing else and the nodes form one block
+            node *run = node_pool.allocate_run(o._size), *first, *last;
+            try {
+#ifndef SJTU_MAP_NO_THREADS
+                if (parallel && std::is_same<node_allocator, std::allocator<node>>::value && o._size >= parallel_clone_min &&
+                    std::thread::hardware_concurrency() > 1)
+                    root = clone_parallel<Move>(o, run, first, last);
+                else
+#endif
+                    root = clone<Move>(o.root, o.nil, run, first, last);
+            } catch (...) {
+                node_pool.release();
+                throw;
             }
-            o = new node(*oo->value, nil);
-            o->fa = f;
-            o->color = oo->color;
+            root->fa = nil;
+            link_ends(first, last);
+            _size = o._size;
+        }
 
-            construct(o->son[0], oo->son[0], o, oo_nil, last_create);
+        /**
+         * build the subtree of the next n elements of it in key order, which is also
+         * the order the nodes are allocated in: splitting evenly keeps every nil within
+         * one level, so the nodes on the deepest level (red_depth) are red, all others black.
+         */
+        template<class ForwardIt>
+        node *build(ForwardIt &it, size_t n, size_t depth, size_t red_depth, node *f, node *&last_create) {
+            if (n == 0)
+                return nil;
+            size_t ln = (n - 1) / 2;
+            node *l = build(it, ln, depth + 1, red_depth, nullptr, last_create);
+            node *o = create_node(*it);
+            ++it;
+            o->fa = f;
+            o->color = depth == red_depth && depth != 0;
+            o->son[0] = l;
+            if (l != nil)
+                l->fa = o;
 
             last_create->next = o;
             o->last = last_create;
             last_create = o;
 
-            construct(o->son[1], oo->son[1], o, oo_nil, last_create);
+            o->son[1] = build(it, n - 1 - ln, depth + 1, red_depth, o, last_create);
+            pull(o);
+            return o;
+        }
+        // the shape of build over the nodes v[0, n), already in key order; the thread is left alone
+        node *relink(node **v, size_t n, size_t depth, size_t red_depth, node *f) {
+            if (n == 0)
+                return nil;
+            size_t ln = (n - 1) / 2;
+            node *o = v[ln];
+            o->fa = f;
+            o->color = depth == red_depth && depth != 0;
+            o->son[0] = relink(v, ln, depth + 1, red_depth, o);
+            o->son[1] = relink(v + ln + 1, n - 1 - ln, depth + 1, red_depth, o);
+            pull(o);
+            return o;
+        }
+        template<class ForwardIt>
+        void assign_sorted(ForwardIt first, ForwardIt last) {
+            clear();
+            revive();
+            size_t n = std::distance(first, last), red_depth = 0;
+            while ((size_t(2) << red_depth) <= n)
+                red_depth++;
+            reserve(n);
+            node *last_create = nil;
+            try {
+                root = build(first, n, 0, red_depth, nil, last_create);
+            } catch (...) {
+                for (node *p = last_create, *q; p != nil; p = q) {
+                    q = p->last;
+                    destroy_node(p);
+                }
+                root = nil;
+                link_ends(nil, nil);
+                throw;
+            }
+            link_ends(nil->next, last_create);
+            _size = n;
+        }
+
+        void assign_allocator(const RBT &o, std::true_type) {
+            if (alloc != o.alloc) {
+                clear();
+                release_nil();
+                alloc = o.alloc;
+                node_pool.set_allocator(alloc);
+            }
+        }
+        void assign_allocator(const RBT &, std::false_type) {}
+
+        // take every node of o, whose allocator must compare equal to ours; *this must be released
+        void take(RBT &o) {
+            node_pool.steal(o.node_pool);
+            nil = o.nil, root = o.root, _size = o._size, shared = o.shared;
+            o.nil = o.root = nullptr, o._size = 0, o.shared = nullptr;
+        }
+        void move_assign(RBT &o, std::true_type) {
+            clear();
+            release_nil();
+            alloc = std::move(o.alloc);
+            node_pool.set_allocator(alloc);
+            take(o);
         }
+        void move_assign(RBT &o, std::false_type) {
+            clear();
+            if (alloc == o.alloc) {
+                release_nil();
+                take(o);
+            } else {
+                copy_from<std::true_type>(o);
+                o.clear();
+            }
+        }
+
+        void swap_allocator(RBT &o, std::true_type) {
+            using std::swap;
+            swap(alloc, o.alloc);
+            node_pool.swap_allocator(o.node_pool);
+        }
+        void swap_allocator(RBT &, std::false_type) {}
     public:
-        RBT() {
-            nil = new node;
-            nil->son[0] = nil->son[1] = nil->fa = nil;
+        explicit RBT(const Allocator &a) : cmp(), alloc(a), node_pool(alloc), shared(nullptr) {
+            create_nil();
 
             root = nil;
             _size = 0;
         }
-        RBT(const RBT &o) {
-            nil = new node;
-            nil->son[0] = nil->son[1] = nil->fa = nil;
-
-            node *last_create = nil;
-            construct(root, o.root, nil, o.nil, last_create);
-            last_create->next = nil;
-            nil->last = last_create;
-            _size = o._size;
+        RBT(const RBT &o, const Allocator &a, bool parallel = false) : nil(nullptr), root(nullptr), _size(0), cmp(o.cmp), alloc(a), node_pool(alloc), shared(nullptr) {
+            try {
+                copy_from<std::false_type>(o, parallel);
+            } catch (...) {
+                release_nil();
+                throw;
+            }
+        }
+        RBT(RBT &&o) noexcept : nil(o.nil), root(o.root), _size(o._size), cmp(std::move(o.cmp)),
+                                alloc(std::move(o.alloc)), node_pool(std::move(o.node_pool)), shared(o.shared) {
+            o.nil = o.root = nullptr;
+            o._size = 0;
+            o.shared = nullptr;
         }
         ~RBT() {
-            if (root != nil)
-                clear(root);
-            delete nil;
+            clear();
+            release_nil();
         }
         RBT &operator=(const RBT &o) {
             if (this == &o)
                 return *this;
 
-            if (root != nil)
-                clear(root);
-            root = nullptr;
-            node *last_create = nil;
-            construct(root, o.root, nil, o.nil, last_create);
-            last_create->next = nil;
-            nil->last = last_create;
-            _size = o._size;
+            clear();
+            cmp = o.cmp;
+            assign_allocator(o, typename node_traits::propagate_on_container_copy_assignment());
+            copy_from<std::false_type>(o);
+            return *this;
+        }
+        RBT &operator=(RBT &&o) noexcept(node_traits::propagate_on_container_move_assignment::value) {
+            if (this == &o)
+                return *this;
+
+            cmp = std::move(o.cmp);
+            move_assign(o, typename node_traits::propagate_on_container_move_assignment());
             return *this;
         }
 
-        void clear(const node *p) {
+        void swap(RBT &o) noexcept {
+            using std::swap;
+            swap(cmp, o.cmp);
+            swap_allocator(o, typename node_traits::propagate_on_container_swap());
+            swap_nodes(o);
+        }
+        // exchange the trees only: cmp and allocators stay where they are
+        void swap_nodes(RBT &o) {
+            std::swap(nil, o.nil), std::swap(root, o.root);
+            std::swap(_size, o._size), std::swap(shared, o.shared);
+            node_pool.swap(o.node_pool);
+        }
+
+        void destroy_values(node *p) {
             if (p->son[0] != nil)
-                clear(p->son[0]);
+                destroy_values(p->son[0]);
             if (p->son[1] != nil)
-                clear(p->son[1]);
-            delete p;
+                destroy_values(p->son[1]);
+            node_traits::destroy(alloc, &p->value());
+        }
+        // whether the arenas we refer to outlive us, as some other tree refers to them too
+        bool arena_shared() const {
+            for (arena *a = shared; a != nullptr; a = a->parent)
+                if (a->refs > 1)
+                    return true;
+            return false;
+        }
+        /**
+         * nodes are never destroyed one by one here: the slabs are handed back as a whole.
+         * while other trees share our arena, the nodes and the pool go to the arena instead,
+         * which takes one pass over the nodes.
+         */
+        void clear() {
+            if (shared != nullptr && arena_shared()) {
+                arena *a = shared_root();
+                for (node *p = nil->next; p != nil;) {
+                    node *q = p->next;
+                    node_traits::destroy(alloc, &p->value());
+                    a->slabs.deallocate(p);
+                    p = q;
+                }
+                a->slabs.absorb(node_pool);
+            } else if (!std::is_trivially_destructible<value_type>::value && root != nil)
+                destroy_values(root);
+            node_pool.release();
+            drop(shared);
+            shared = nullptr;
+            root = nil;
+            _size = 0;
+            if (nil != nullptr)
+                link_ends(nil, nil);
+        }
+        void reserve(size_t n) {
+            node_pool.reserve(n);
         }
 
-        node* find(const Key &k) const {
-            node *p = root;
-            while (p != nil && (cmp(p->value->first, k) || cmp(k, p->value->first)))
-                p = cmp(k, p->value->first) ? p->son[0] : p->son[1];
-            return p == nil ? nil : p;
+        /**
+         * lower_bound of k, and whether it holds k. a three-way Compare stops at k
+         * with one call per level; a less-than goes down to a leaf with one call
+         * per level, then checks the bound with one more.
+         */
+        template<class K>
+        node* search(const K &k, bool &found) const {
+            return search(k, found, typename key_order<Compare>::template three_way<K, Key>());
+        }
+        template<class K>
+        node* search(const K &k, bool &found, std::true_type) const {
+            node *p = root, *res = nil;
+            found = false;
+            while (p != nil) {
+                int c = cmp.order(k, p->value().first);
+                if (c == 0) {
+                    found = true;
+                    return p;
+                }
+                if (c < 0)
+                    res = p, p = p->son[0];
+                else
+                    p = p->son[1];
+            }
+            return res;
+        }
+        template<class K>
+        node* search(const K &k, bool &found, std::false_type) const {
+            node *res = lower_bound(k);
+            found = res != nil && !cmp(k, res->value().first);
+            return res;
         }
 
-        node* find_insert(const Key &k) const {
-            node *p = root;
-            while (1) {
-                if (!cmp(k, p->value->first) && !cmp(p->value->first, k)) // insert fail
-                    return nil;
-                if (cmp(k, p->value->first)) {
-                    if (p->son[0] == nil)
-                        return p;
-                    p = p->son[0];
-                } else {
-                    if (p->son[1] == nil)
-                        return p;
+        // K is Key, or anything a transparent Compare can order against Key
+        template<class K>
+        node* find(const K &k) const {
+            bool found;
+            node *p = search(k, found);
+            return found ? p : nil;
+        }
+
+        // first node whose key is not less than k (nil if there is none)
+        template<class K>
+        node* lower_bound(const K &k) const {
+            node *p = root, *res = nil;
+            while (p != nil) {
+                if (cmp(p->value().first, k))
+                    p = p->son[1];
+                else
+                    res = p, p = p->son[0];
+            }
+            return res;
+        }
+        // first node whose key is greater than k (nil if there is none)
+        template<class K>
+        node* upper_bound(const K &k) const {
+            node *p = root, *res = nil;
+            while (p != nil) {
+                if (cmp(k, p->value().first))
+                    res = p, p = p->son[0];
+                else
                     p = p->son[1];
+            }
+            return res;
+        }
+        /**
+         * keys are unique, so the range of a Key is empty or the single node holding it.
+         * a transparent probe may be equivalent to several keys: take both bounds for it.
+         */
+        pair<node *, node *> equal_range(const Key &k) const {
+            bool found;
+            node *p = search(k, found);
+            return pair<node *, node *>(p, found ? p->next : p);
+        }
+
+        node* maximum() const {
+            return _size == 0 ? nil : nil->last;
+        }
+        // whether p (nil for end()) is where the in-order thread starts, so -- must throw
+        bool at_begin(const node *p) const {
+            return _size == 0 || p->last == nil;
+        }
+
+        /**
+         * lower_bound of k, found from x upwards instead of from the root: x must
+         * hold a key less than k. climbing stops below the first ancestor
+         * that x hangs left of and k is less than, so the walk is O(log d) in the
+         * distance d between x and the result rather than O(log n).
+         */
+        template<class K>
+        node* lower_bound_from(node *x, const K &k) const {
+            node *v = x, *res = nil;
+            while (v != root) {
+                node *f = v->fa;
+                if (f->son[0] == v) {
+                    int c = cmp.order(k, f->value().first);
+                    if (c < 0) {
+                        res = f;
+                        break;
+                    }
+                    if (c == 0)
+                        return f;
                 }
+                v = f;
             }
+            while (v != nil) {
+                if (cmp(v->value().first, k))
+                    v = v->son[1];
+                else
+                    res = v, v = v->son[0];
+            }
+            return res;
         }
 
-        node* begin() {
-            if (_size == 0)
-                return nil;
+        /**
+         * lower_bound of k from the finger x, for keys visited in ascending order:
+         * x == nullptr is no finger yet, otherwise x is where the previous key landed.
+         */
+        template<class K>
+        node* seek(node *x, const K &k) const {
+            if (x == nullptr)
+                return lower_bound(k);
+            if (x == nil || !cmp(x->value().first, k))
+                return x;
+            if (x->next == nil || !cmp(x->next->value().first, k))
+                return x->next;
+            return lower_bound_from(x->next, k);
+        }
+        // hang q right before lb (nil: after the maximum), which seek found from x
+        node* insert_before(node *lb, node *x, node *q) {
+            node *b;
+            if (lb != nil)
+                b = lb->last;
+            else
+                b = x != nullptr && x != nil && x->next == nil ? x : maximum();
+            node *f = lb;
+            int d = 0;
+            if (b != nil && b->son[1] == nil)
+                f = b, d = 1;
+            return insert_at(f, d, q);
+        }
+        /**
+         * apply op, whose key is not less than that of the previous op in the batch.
+         * finger is where the previous op ended (nullptr before the first one): the
+         * thread is tried first and the tree is only climbed when that fails, and
+         * a missing key is linked in next to its lower bound without another search.
+         */
+        void apply(batch_op &op, node *&finger) {
+            const Key &k = op.key;
+            node *x = finger, *lb = seek(x, k);
+
+            if (lb != nil && !cmp(k, lb->value().first)) {
+                if (op.type == batch_op::upsert) {
+                    lb->value().second = std::move(op.value);
+                    op.result = batch_op::updated;
+                    finger = lb;
+                } else {
+                    finger = lb->next;
+                    erase(lb);
+                    op.result = batch_op::erased;
+                }
+                return;
+            }
+            if (op.type == batch_op::erase) {
+                op.result = batch_op::missing;
+                finger = lb;
+                return;
+            }
+
+            finger = insert_before(lb, x, create_node(k, std::move(op.value)));
+            op.result = batch_op::inserted;
+        }
+
+        /**
+         * look for k: return the node holding it, or nil when it is absent,
+         * in which case k belongs at son[d] of f (f == nil for an empty tree).
+         * the calls of Compare are counted as in search.
+         */
+        node* find_insert(const Key &k, node *&f, int &d) const {
+            return find_insert(k, f, d, typename key_order<Compare>::template three_way<Key, Key>());
+        }
+        node* find_insert(const Key &k, node *&f, int &d, std::true_type) const {
             node *p = root;
-            while (p->son[0] != nil)
-                p = p->son[0];
-            return p;
+            f = nil, d = 0;
+            while (p != nil) {
+                int c = cmp.order(k, p->value().first);
+                if (c == 0)
+                    return p;
+                d = c > 0;
+                f = p;
+                p = p->son[d];
+            }
+            return nil;
+        }
+        node* find_insert(const Key &k, node *&f, int &d, std::false_type) const {
+            // le: the last node passed whose key is not greater than k
+            node *p = root, *le = nil;
+            f = nil, d = 0;
+            while (p != nil) {
+                d = !cmp(k, p->value().first);
+                if (d)
+                    le = p;
+                f = p;
+                p = p->son[d];
+            }
+            return le != nil && !cmp(le->value().first, k) ? le : nil;
+        }
+
+        node* begin() {
+            return _size == 0 ? nil : nil->next;
         }
         node *end() {
             return nil;
         }
         const node* cbegin() const {
-            if (_size == 0)
-                return nil;
-            const node *p = root;
-            while (p->son[0] != nil)
-                p = p->son[0];
-            return p;
+            return _size == 0 ? nil : nil->next;
         }
         const node *cend() const {
             return nil;
         }
 
+        void pull(node *p) {
+            if (Ranked)
+                p->set_size(p->son[0]->size() + p->son[1]->size() + 1);
+        }
+        // add d to the subtree sizes of p and all its ancestors
+        void add_size(node *p, ptrdiff_t d) {
+            if (Ranked)
+                for (; p != nil; p = p->fa)
+                    p->set_size(p->size() + d);
+        }
+
+        // in-order index of x; _size for nil
+        size_t position(const node *x) const {
+            if (x == nil)
+                return _size;
+            size_t k = x->son[0]->size();
+            for (; x != root; x = x->fa)
+                if (x->fa->son[1] == x)
+                    k += x->fa->son[0]->size() + 1;
+            return k;
+        }
+        // the node with in-order index k; nil for k >= _size
+        node* select(size_t k) const {
+            if (k >= _size)
+                return nil;
+            node *p = root;
+            while (k != p->son[0]->size()) {
+                if (k < p->son[0]->size())
+                    p = p->son[0];
+                else
+                    k -= p->son[0]->size() + 1, p = p->son[1];
+            }
+            return p;
+        }
+        // number of keys less than k
+        template<class K>
+        size_t rank(const K &k) const {
+            size_t r = 0;
+            for (node *p = root; p != nil;) {
+                if (cmp(p->value().first, k))
+                    r += p->son[0]->size() + 1, p = p->son[1];
+                else
+                    p = p->son[0];
+            }
+            return r;
+        }
+        // x moved by n places in order, nil standing for end(); throw if that leaves [begin, end]
+        node* advance(const node *x, ptrdiff_t n) const {
+            if (n == 1 && x != nil)
+                return x->next;
+            if (n == -1 && x != nil && x->last != nil)
+                return x->last;
+            ptrdiff_t k = ptrdiff_t(position(x)) + n;
+            if (k < 0 || size_t(k) > _size)
+                throw invalid_iterator();
+            return select(size_t(k));
+        }
+
         void rotate(node *o) {
             node *f = o->fa, *ff = f->fa;
             int l = f->son[1] == o, r = l ^ 1;
@@ -179,9 +1128,14 @@ public:
             if (o->son[r] != nil)
                 o->son[r]->fa = f;
             f->son[l] = o->son[r], o->son[r] = f;
+            pull(f), pull(o);
         }
 
-        void insert_maintain(node *z) {
+        /**
+         * restore the colors above the red node z.
+         * return whether that grew the black height (a red reached the root).
+         */
+        bool insert_maintain(node *z) {
             while (z->fa->color == 1) {
                 int r = z->fa == z->fa->fa->son[0], l = r ^ 1;
                 if (z->fa == z->fa->fa->son[l]) {
@@ -202,327 +1156,955 @@ public:
                     }
                 }
             }
+            bool grown = root->color == 1;
             root->color = 0;
+            return grown;
         }
-        node* insert(const value_type &val) {
-            if (root == nil) {
-                _size++;
-                root = new node(val, nil);
-                return root;
+        /**
+         * find_insert, but try the gap just before h first (h == nil stands for end()):
+         * when k belongs right there it is placed with at most two comparisons and
+         * no descent, which makes feeding sorted keys with end() as the hint O(1) each.
+         */
+        template<class K>
+        node* find_hint(node *h, const K &k, node *&f, int &d) const {
+            if (h == nil) {
+                // the thread ends at the largest node, which has no right son
+                node *p = nil->last;
+                if (p == nil)
+                    return find_insert(k, f, d);
+                if (cmp(p->value().first, k)) {
+                    f = p, d = 1;
+                    return nil;
+                }
+                return find_insert(k, f, d);
             }
+            int c = cmp.order(k, h->value().first);
+            if (c < 0) {
+                node *b = h->last;
+                if (b == nil || cmp(b->value().first, k)) {
+                    // b has no right son, or else h is the leftmost node below it
+                    if (b != nil && b->son[1] == nil)
+                        f = b, d = 1;
+                    else
+                        f = h, d = 0;
+                    return nil;
+                }
+            } else if (c > 0) {
+                node *a = h->next;
+                if (a == nil || cmp(k, a->value().first)) {
+                    if (h->son[1] == nil)
+                        f = h, d = 1;
+                    else
+                        f = a, d = 0;
+                    return nil;
+                }
+            } else
+                return h;
+            return find_insert(k, f, d);
+        }
+        // h == nullptr: no hint
+        template<class K>
+        node* locate(node *h, const K &k, node *&f, int &d) const {
+            return h == nullptr ? find_insert(k, f, d) : find_hint(h, k, f, d);
+        }
 
-            node *p = find_insert(val.first);
-            if (p == nil) // insert fail
-                return nil;
-
+        // hang the new node q at son[d] of f, as located by find_insert
+        node* insert_at(node *f, int d, node *q) {
             _size++;
-            node *q = new node(val, nil);
-            q->fa = p;
-            if (cmp(val.first, p->value->first)) {
-                p->son[0] = q;
-                q->last = p->last;
-                p->last->next = q;
-                p->last = q;
-                q->next = p;
+            q->fa = f;
+            pull(q);
+            if (f == nil) {
+                root = q;
+                link_ends(q, q);
+                return q;
+            }
+            f->son[d] = q;
+            add_size(f, 1);
+            if (d == 0) {
+                q->last = f->last;
+                f->last->next = q;
+                f->last = q;
+                q->next = f;
             } else {
-                p->son[1] = q;
-                q->next = p->next;
-                p->next->last = q;
-                p->next = q;
-                q->last = p;
+                q->next = f->next;
+                f->next->last = q;
+                f->next = q;
+                q->last = f;
             }
             q->color = 1;
 
             insert_maintain(q);
             nil->color = 0;
-            nil->son[0] = nil->son[1] = nil->fa = nil->next = nil->last = nil;
+            nil->son[0] = nil->son[1] = nil->fa = nil;
             return q;
         }
 
-        void swap_info(node *x, node *y) {
-            node *tmp1 = new node, *tmp2 = new node;
+        // the first of the result is the new node, or the one holding the same key
+        template<class V>
+        pair<node *, bool> insert(node *h, V &&val) {
+            revive();
+            node *f;
+            int d;
+            node *p = locate(h, val.first, f, d);
+            if (p != nil) // insert fail
+                return pair<node *, bool>(p, false);
+            return pair<node *, bool>(insert_at(f, d, create_node(std::forward<V>(val))), true);
+        }
+        template<class... Args>
+        pair<node *, bool> emplace(node *h, Args&&... args) {
+            revive();
+            node *q = create_node(std::forward<Args>(args)...), *f;
+            int d;
+            node *p;
+            try {
+                p = locate(h, q->value().first, f, d);
+            } catch (...) {
+                destroy_node(q);
+                throw;
+            }
+            if (p != nil) {
+                destroy_node(q);
+                return pair<node *, bool>(p, false);
+            }
+            return pair<node *, bool>(insert_at(f, d, q), true);
+        }
+        // nothing is constructed when k is already present
+        template<class K, class... Args>
+        pair<node *, bool> try_emplace(K &&k, Args&&... args) {
+            revive();
+            node *f;
+            int d;
+            node *p = find_insert(k, f, d);
+            if (p != nil)
+                return pair<node *, bool>(p, false);
+            node *q = create_node(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(k)), std::forward_as_tuple(std::forward<Args>(args)...));
+            return pair<node *, bool>(insert_at(f, d, q), true);
+        }
+        template<class K, class M>
+        pair<node *, bool> insert_or_assign(K &&k, M &&obj) {
+            revive();
+            node *f;
+            int d;
+            node *p = find_insert(k, f, d);
+            if (p != nil) {
+                p->value().second = std::forward<M>(obj);
+                return pair<node *, bool>(p, false);
+            }
+            node *q = create_node(std::forward<K>(k), std::forward<M>(obj));
+            return pair<node *, bool>(insert_at(f, d, q), true);
+        }
+
+        // put v where u hangs; u's own links are left for the caller
+        void transplant(node *u, node *v) {
+            if (u->fa == nil)
+                root = v;
+            else
+                u->fa->son[u->fa->son[1] == u] = v;
+            v->fa = u->fa;
+        }
+
+        void erase_maintain(node *x) {
+            while (x != root && x->color == 0) {
+                int l = x->fa->son[1] == x, r = l ^ 1;
+                node *w = x->fa->son[r];
+                if (w->color == 1) {
+                    w->color = 0;
+                    x->fa->color = 1;
+                    rotate(w);
+                    w = x->fa->son[r];
+                }
+                if (w->son[0]->color == 0 && w->son[1]->color == 0) {
+                    w->color = 1;
+                    x = x->fa;
+                } else {
+                    if (w->son[r]->color == 0) {
+                        w->son[l]->color = 0;
+                        w->color = 1;
+                        rotate(w->son[l]);
+                        w = x->fa->son[r];
+                    }
+                    w->color = x->fa->color;
+                    x->fa->color = 0;
+                    w->son[r]->color = 0;
+                    rotate(x->fa->son[r]);
+                    break;
+                }
+            }
+            x->color = 0;
+        }
+        /**
+         * unlink z by pointer surgery only: when z has two children its
+         * successor is moved into z's place, so no value is ever copied
+         * and every other node (and iterator) stays where it was.
+         */
+        void erase(node *z) {
+            _size--;
+            node *y = z, *x;
+            bool y_color = y->color;
+            if (z->son[0] == nil) {
+                x = z->son[1];
+                transplant(z, x);
+            } else if (z->son[1] == nil) {
+                x = z->son[0];
+                transplant(z, x);
+            } else {
+                y = z->next;
+                y_color = y->color;
+                x = y->son[1];
+                if (y->fa == z)
+                    x->fa = y;
+                else {
+                    transplant(y, x);
+                    y->son[1] = z->son[1];
+                    y->son[1]->fa = y;
+                }
+                transplant(z, y);
+                y->son[0] = z->son[0];
+                y->son[0]->fa = y;
+                y->color = z->color;
+                y->set_size(z->size());
+            }
+            add_size(x->fa, -1);
+
+            if (y_color == 0)
+                erase_maintain(x);
+            nil->color = 0;
+            nil->son[0] = nil->son[1] = nil->fa = nil;
+
+            z->last->next = z->next;
+            z->next->last = z->last;
+            destroy_node(z);
+        }
+
+        /**
+         * split/join on standalone subtrees (fa == nil, root black), used to cut
+         * whole ranges out at once. black heights are passed along instead of
+         * being recomputed, so a bottom-up split costs O(log n) in total.
+         */
+        size_t black_height(node *t) const {
+            size_t h = 0;
+            for (; t != nil; t = t->son[0])
+                h += t->color == 0;
+            return h;
+        }
+        size_t blacken(node *t, size_t h) {
+            if (t != nil)
+                t->fa = nil;
+            if (t->color == 1) {
+                t->color = 0;
+                return h + 1;
+            }
+            return h;
+        }
+        /**
+         * joins l < k < r into one tree and returns its root; h receives its black height.
+         * k is hung along the spine of the taller tree and fixed like a fresh insertion.
+         */
+        node* join(node *l, size_t hl, node *k, node *r, size_t hr, size_t &h) {
+            k->fa = nil;
+            if (hl == hr) {
+                k->son[0] = l, k->son[1] = r, k->color = 0;
+                if (l != nil)
+                    l->fa = k;
+                if (r != nil)
+                    r->fa = k;
+                pull(k);
+                h = hl + 1;
+                return k;
+            }
+            int s = hl < hr, t = s ^ 1;
+            node *c = s ? r : l, *o = s ? l : r, *p = nil;
+            size_t hc = s ? hr : hl, ho = s ? hl : hr;
+            h = hc;
+            root = c;
+            while (c->color == 1 || hc != ho) {
+                hc -= c->color == 0;
+                p = c, c = c->son[t];
+            }
+            k->son[s] = c, k->son[t] = o, k->fa = p, k->color = 1;
+            p->son[t] = k;
+            if (c != nil)
+                c->fa = k;
+            if (o != nil)
+                o->fa = k;
+            pull(k);
+            add_size(p, o->size() + 1);
+            h += insert_maintain(k);
+            return root;
+        }
+        /**
+         * cuts the tree containing x (which must hang below a root whose fa is nil)
+         * into the parts before and after x; x itself is left detached.
+         */
+        void split(node *x, node *&l, size_t &hl, node *&r, size_t &hr) {
+            size_t hc = black_height(x->son[0]);
+            l = x->son[0], r = x->son[1];
+            hl = blacken(l, hc), hr = blacken(r, hc);
+            hc += x->color == 0;
+            node *c = x, *p = x->fa;
+            while (p != nil) {
+                node *pp = p->fa;
+                int right = p->son[1] == c;
+                node *sib = p->son[right ^ 1];
+                size_t hs = blacken(sib, hc);
+                hc += p->color == 0;
+                if (right)
+                    l = join(sib, hs, p, l, hl, hl);
+                else
+                    r = join(r, hr, p, sib, hs, hr);
+                c = p, p = pp;
+            }
+        }
+        /**
+         * erase [a, b), b may be nil. n is the number of nodes in the range.
+         * short ranges go node by node; longer ones are cut out with two splits
+         * and one join and then freed along the thread, O(n + log size).
+         */
+        void erase(node *a, node *b, size_t n) {
+            size_t lg = 0;
+            for (size_t s = _size; s; s >>= 1)
+                lg++;
+            if (n <= lg) {
+                while (a != b) {
+                    node *q = a->next;
+                    erase(a);
+                    a = q;
+                }
+                return;
+            }
+            node *l, *r, *m;
+            size_t hl, hr, hm;
+            split(a, l, hl, r, hr);
+            if (b == nil)
+                root = l;
+            else {
+                split(b, m, hm, r, hr);
+                root = join(l, hl, b, r, hr, hm);
+            }
+            root->fa = nil;
+            _size -= n;
+            a->last->next = b;
+            b->last = a->last;
+            nil->color = 0;
+            nil->son[0] = nil->son[1] = nil->fa = nil;
+            while (a != b) {
+                node *q = a->next;
+                destroy_node(a);
+                a = q;
+            }
+        }
+
+        // the nodes first..last, a whole tree hanging off old, are moved to hang off nil
+        void repoint(node *first, node *last, node *old) {
+            for (node *p = first;; p = p->next) {
+                if (p->son[0] == old)
+                    p->son[0] = nil;
+                if (p->son[1] == old)
+                    p->son[1] = nil;
+                if (p->fa == old)
+                    p->fa = nil;
+                if (p == last)
+                    break;
+            }
+            first->last = last->next = nil;
+        }
+        /**
+         * move x and every node after it into o, which must be empty and use an
+         * allocator equal to ours. only the smaller of the two parts is repointed
+         * to a new nil: O(log n + min(k, n - k)) for k nodes moved.
+         */
+        void split_off(node *x, RBT &o) {
+            if (x == nil)
+                return;
+            if (x->last == nil) {
+                swap_nodes(o);
+                return;
+            }
+            o.revive();
+            // walk out from the cut on both sides until the smaller part is used up
+            node *lo = x->last, *hi = x, *lo_end = lo, *hi_end = hi;
+            size_t n = 0;
+            while (lo != nil && hi != nil)
+                lo_end = lo, hi_end = hi, lo = lo->last, hi = hi->next, n++;
+
+            share();
+            o.shared = shared;
+            shared->refs++;
 
-            *tmp1 = *x;
-            x->son[0]->fa = tmp1, x->son[1]->fa = tmp1;
-            x->fa->son[x->fa->son[1] == x] = tmp1;
-            x->last->next = tmp1, x->next->last = tmp1;
+            node *first = nil->next, *before = x->last, *last = nil->last, *l, *r, *u;
+            size_t hl, hr, h;
+            split(x, l, hl, r, hr);
+            u = join(nil, 0, x, r, hr, h);
+            root = l;
+            if (hi == nil) {
+                o.root = u, o._size = n;
+                o.repoint(x, hi_end, nil);
+            } else {
+                std::swap(nil, o.nil);
+                o.root = u, o._size = _size - n;
+                repoint(lo_end, before, o.nil);
+            }
+            _size -= o._size;
+            link_ends(first, before);
+            o.link_ends(x, last);
+            nil->son[0] = nil->son[1] = nil->fa = nil;
+            o.nil->son[0] = o.nil->son[1] = o.nil->fa = o.nil;
+        }
+        /**
+         * take every node of o, whose keys are all greater than ours, leaving it empty.
+         * the allocators must compare equal; the smaller tree is repointed to the other's nil.
+         */
+        void join_after(RBT &o) {
+            if (o._size == 0)
+                return;
+            if (_size == 0) {
+                swap_nodes(o);
+                return;
+            }
+            arena *a = share(), *b = o.share();
+            if (a != b) {
+                b->parent = a;
+                a->refs++;
+                a->slabs.absorb(b->slabs);
+            }
 
-            *tmp2 = *y;
-            y->son[0]->fa = tmp2, y->son[1]->fa = tmp2;
-            y->fa->son[y->fa->son[1] == y] = tmp2;
-            y->last->next = tmp2, y->next->last = tmp2;
+            node *lmin = begin(), *lmax = maximum(), *rmin = o.begin(), *rmax = o.maximum(), *l = root;
+            if (_size < o._size) {
+                std::swap(nil, o.nil);
+                repoint(lmin, lmax, o.nil);
+            } else
+                repoint(rmin, rmax, o.nil);
+            lmax->next = rmin;
+            rmin->last = lmax;
 
-            *y = *tmp1;
-            tmp1->son[0]->fa = y, tmp1->son[1]->fa = y;
-            tmp1->fa->son[tmp1->fa->son[1] == tmp1] = y;
-            tmp1->last->next = y, tmp1->next->last = y;
+            size_t hl = black_height(l), h0, hr, h;
+            node *l0, *r;
+            split(rmin, l0, h0, r, hr);
+            root = join(l, hl, rmin, r, hr, h);
+            _size += o._size;
+            o.root = o.nil, o._size = 0;
+            link_ends(lmin, rmax);
+            o.link_ends(o.nil, o.nil);
+            nil->son[0] = nil->son[1] = nil->fa = nil;
+            o.nil->son[0] = o.nil->son[1] = o.nil->fa = o.nil;
+        }
 
-            *x = *tmp2;
-            tmp2->son[0]->fa = x, tmp2->son[1]->fa = x;
-            tmp2->fa->son[tmp2->fa->son[1] == tmp2] = x;
-            tmp2->last->next = x, tmp2->next->last = x;
+        enum set_op { op_union, op_intersection, op_difference, op_symmetric };
 
-            delete tmp1;
-            delete tmp2;
-        }
+        /**
+         * leave the result of op on this tree and o in this tree; resolve(key, mine, theirs)
+         * may update our value of a key found in both. when one side is much smaller, its keys
+         * are sought with a finger in the other, and the runs an intersection drops are cut
+         * out with split/join; otherwise both threads are merged in O(n + m), and the nodes
+         * kept, ours and copies of o's, are relinked into a new shape. our values are never
+         * moved, so if a copy throws this tree is as it was (but for what resolve did).
+         */
+        template<class F>
+        void combine(const RBT &o, set_op op, F &resolve) {
+            revive();
+            size_t n = _size, m = o._size, lg_n = 0, lg_m = 0;
+            for (size_t s = n; s; s >>= 1)
+                lg_n++;
+            for (size_t s = m; s; s >>= 1)
+                lg_m++;
 
-        void erase_maintain(node *x) {
-            while (x != root && x->color == 0) {
-                int l = x->fa->son[1] == x, r = l ^ 1;
-                node *w = x->fa->son[r];
-                if (w->color == 1) {
-                    w->color = 0;
-                    x->fa->color = 1;
-                    rotate(w);
-                    w = x->fa->son[r];
+            if (m * lg_n < n) {
+                node *x = nullptr, *from = begin();
+                for (const node *q = o.cbegin(); q != o.nil; q = q->next) {
+                    node *lb = seek(x, q->value().first);
+                    bool found = lb != nil && !cmp(q->value().first, lb->value().first);
+                    if (op == op_intersection) {
+                        if (!found) {
+                            x = lb;
+                            continue;
+                        }
+                        size_t k = 0;
+                        for (node *p = from; p != lb; p = p->next)
+                            k++;
+                        if (k)
+                            erase(from, lb, k);
+                        resolve(lb->value().first, lb->value().second, q->value().second);
+                        x = lb, from = lb->next;
+                    } else if (found) {
+                        if (op == op_union) {
+                            resolve(lb->value().first, lb->value().second, q->value().second);
+                            x = lb;
+                        } else {
+                            x = lb->next;
+                            erase(lb);
+                        }
+                    } else if (op == op_difference)
+                        x = lb;
+                    else
+                        x = insert_before(lb, x, create_node(q->value()));
                 }
-                if (w->son[0]->color == 0 && w->son[1]->color == 0) {
-                    w->color = 1;
-                    x = x->fa;
-                } else {
-                    if (w->son[r]->color == 0) {
-                        w->son[l]->color = 0;
-                        w->color = 1;
-                        rotate(w->son[l]);
-                        w = x->fa->son[r];
+                if (op == op_intersection) {
+                    size_t k = 0;
+                    for (node *p = from; p != nil; p = p->next)
+                        k++;
+                    if (k)
+                        erase(from, nil, k);
+                }
+                return;
+            }
+            if (n * lg_m < m && (op == op_intersection || op == op_difference)) {
+                node *y = nullptr;
+                for (node *p = begin(), *q; p != nil; p = q) {
+                    q = p->next;
+                    y = o.seek(y, p->value().first);
+                    bool found = y != o.nil && !cmp(p->value().first, y->value().first);
+                    if (op == op_intersection && found)
+                        resolve(p->value().first, p->value().second, y->value().second);
+                    else if (op == op_difference ? found : !found)
+                        erase(p);
+                }
+                return;
+            }
+
+            std::vector<node *> kept, dropped, fresh;
+            kept.reserve(n + m), dropped.reserve(n), fresh.reserve(m);
+            node *a = begin();
+            const node *b = o.cbegin();
+            try {
+                while (a != nil || b != o.nil) {
+                    if (a == nil && (op == op_intersection || op == op_difference))
+                        break;
+                    int side = a == nil ? 1 : b == o.nil ? -1 : cmp.order(a->value().first, b->value().first);
+                    bool take = op == op_union || (op == op_intersection && side == 0) ||
+                                (op == op_difference && side < 0) || (op == op_symmetric && side != 0);
+                    if (side == 0 && take)
+                        resolve(a->value().first, a->value().second, b->value().second);
+                    if (side <= 0) {
+                        (take ? kept : dropped).push_back(a);
+                        a = a->next;
+                    } else if (take) {
+                        fresh.push_back(create_node(b->value()));
+                        kept.push_back(fresh.back());
                     }
-                    w->color = x->fa->color;
-                    x->fa->color = 0;
-                    w->son[r]->color = 0;
-                    rotate(x->fa->son[r]);
-                    break;
+                    if (side >= 0)
+                        b = b->next;
                 }
+            } catch (...) {
+                for (size_t i = 0; i < fresh.size(); i++)
+                    destroy_node(fresh[i]);
+                throw;
             }
-            x->color = 0;
+
+            for (size_t i = 0; i < dropped.size(); i++)
+                destroy_node(dropped[i]);
+            _size = kept.size();
+            if (_size == 0) {
+                root = nil;
+                link_ends(nil, nil);
+                return;
+            }
+            size_t red_depth = 0;
+            while ((size_t(2) << red_depth) <= _size)
+                red_depth++;
+            root = relink(kept.data(), _size, 0, red_depth, nil);
+            for (size_t i = 1; i < _size; i++)
+                kept[i - 1]->next = kept[i], kept[i]->last = kept[i - 1];
+            link_ends(kept.front(), kept.back());
         }
-        void erase(node *z) {
-            _size--;
-            node *y = z->son[0] == nil || z->son[1] == nil ? z : z->next;
-            if (y != z) {
-                if (z == root)
-                    root = y;
-                swap_info(y, z);
-                node *t = y;
-                y = z, z = t;
-                value_type *tmp = y->value;
-                delete z->value;
-                z->value = new value_type(*y->value);
-            }
-
-            node *x = y->son[0] != nil ? y->son[0] : y->son[1];
-            x->fa = y->fa;
-            if (y->fa == nil)
-                root = x;
-            else
-                y->fa->son[y->fa->son[1] == y] = x;
+    } tr;
 
-            if (y->color == 0)
-                erase_maintain(x);
-            nil->color = 0;
-            nil->son[0] = nil->son[1] = nil->fa = nil->next = nil->last = nil;
+    // the map an iterator is over, kept only by iterators that need it
+    template<class M, bool = Checked || Ranked>
+    class map_ref {
+        M *_map;
 
-            y->last->next = y->next;
-            y->next->last = y->last;
-            delete y;
+    protected:
+        explicit map_ref(M *m) : _map(m) {}
+        M *get() const {
+            return _map;
         }
-    } tr;
+    };
+    template<class M>
+    class map_ref<M, false> {
+    protected:
+        explicit map_ref(M *) {}
+        M *get() const {
+            return nullptr;
+        }
+    };
 
     /**
      * see BidirectionalIterator at CppReference for help.
      *
-     * if there is anything wrong throw invalid_iterator.
+     * if there is anything wrong throw invalid_iterator, when Checked.
      *     like it = map.begin(); --it;
      *       or it = map.end(); ++end();
      */
 
 public:
     class const_iterator;
-    class iterator {
+    class iterator : map_ref<map> {
         friend void map::erase(iterator pos);
+        friend void map::erase(iterator first, iterator last);
         friend const_iterator;
 
+    public:
         typedef pair<const Key, T> value_type;
         typedef value_type&         reference;
         typedef value_type*           pointer;
+        typedef std::ptrdiff_t        difference_type;
+        typedef typename std::conditional<Ranked, std::random_access_iterator_tag,
+                                          std::bidirectional_iterator_tag>::type iterator_category;
 
     private:
-        map *_map;
+        typedef map_ref<map> ref;
         typename RBT::node *p;
 
     public:
-        iterator() : _map(nullptr), p(nullptr) {}
-        iterator(const iterator &o) : _map(o._map), p(o.p) {}
-        iterator(map *__map, typename RBT::node *_p) : _map(__map), p(_p) {}
+        iterator() : ref(nullptr), p(nullptr) {}
+        iterator(const iterator &o) : ref(o.get()), p(o.p) {}
+        iterator(map *__map, typename RBT::node *_p) : ref(__map), p(_p) {}
 
         iterator operator++(int) {
-            if (*this == _map->end())
+            if (Checked && *this == this->get()->end())
                 throw invalid_iterator();
             iterator res(*this);
             p = p->next;
             return res;
         }
         iterator &operator++() {
-            if (*this == _map->end())
+            if (Checked && *this == this->get()->end())
                 throw invalid_iterator();
             p = p->next;
             return *this;
         }
+        // the thread runs through nil, so --end() is the maximum in O(1)
         iterator operator--(int) {
-            if (*this == _map->begin())
+            if (Checked && this->get()->tr.at_begin(p))
                 throw invalid_iterator();
             iterator res(*this);
-            if (p == _map->tr.nil) {
-                p = _map->tr.root;
-                while (p->son[1] != _map->tr.nil)
-                    p = p->son[1];
-            } else
-                p = p->last;
+            p = p->last;
             return res;
         }
         iterator &operator--() {
-            if (*this == _map->begin())
+            if (Checked && this->get()->tr.at_begin(p))
                 throw invalid_iterator();
-            if (p == _map->tr.nil) {
-                p = _map->tr.root;
-                while (p->son[1] != _map->tr.nil)
-                    p = p->son[1];
-            } else
-                p = p->last;
+            p = p->last;
             return *this;
         }
 
+        /**
+         * random access in O(log n), for a Ranked map only.
+         * throw if the result would leave [begin(), end()].
+         */
+        iterator &operator+=(difference_type n) {
+            static_assert(Ranked, "iterator arithmetic needs a ranked map");
+            p = this->get()->tr.advance(p, n);
+            return *this;
+        }
+        iterator &operator-=(difference_type n) {
+            return *this += -n;
+        }
+        iterator operator+(difference_type n) const {
+            iterator res(*this);
+            return res += n;
+        }
+        iterator operator-(difference_type n) const {
+            iterator res(*this);
+            return res -= n;
+        }
+        difference_type operator-(const const_iterator &o) const {
+            static_assert(Ranked, "iterator arithmetic needs a ranked map");
+            if (Checked && this->get() != o.get())
+                throw invalid_iterator();
+            return difference_type(this->get()->tr.position(p)) - difference_type(this->get()->tr.position(o.p));
+        }
+        reference operator[](difference_type n) const {
+            return *(*this + n);
+        }
+        bool operator<(const const_iterator &o) const {
+            return *this - o < 0;
+        }
+        bool operator>(const const_iterator &o) const {
+            return *this - o > 0;
+        }
+        bool operator<=(const const_iterator &o) const {
+            return *this - o <= 0;
+        }
+        bool operator>=(const const_iterator &o) const {
+            return *this - o >= 0;
+        }
+
         reference operator*() const {
-            return *p->value;
+            return p->value();
         }
         pointer operator->() const noexcept {
-            return &(*p->value);
+            return &p->value();
         }
 
         bool operator==(const iterator &o) const {
-            return _map == o._map && p == o.p;
+            return this->get() == o.get() && p == o.p;
         }
         bool operator==(const const_iterator &o) const {
-            return _map == o._map && p == o.p;
+            return this->get() == o.get() && p == o.p;
         }
         bool operator!=(const iterator &o) const {
-            return _map != o._map || p != o.p;
+            return this->get() != o.get() || p != o.p;
         }
         bool operator!=(const const_iterator &o) const {
-            return _map != o._map || p != o.p;
+            return this->get() != o.get() || p != o.p;
         }
     };
-    class const_iterator {
+    class const_iterator : map_ref<const map> {
         friend iterator;
+        friend class map;
 
+    public:
         typedef const pair<const Key, T> value_type;
         typedef value_type&         reference;
         typedef value_type*           pointer;
+        typedef std::ptrdiff_t        difference_type;
+        typedef typename std::conditional<Ranked, std::random_access_iterator_tag,
+                                          std::bidirectional_iterator_tag>::type iterator_category;
 
     private:
-        const map *_map;
+        typedef map_ref<const map> ref;
         const typename RBT::node *p;
 
     public:
-        const_iterator() : _map(nullptr), p(nullptr) {}
-        const_iterator(const iterator &o) : _map(o._map), p(o.p) {}
-        const_iterator(const const_iterator &o) : _map(o._map), p(o.p) {}
-        const_iterator(const map *__map, const typename RBT::node *_p) : _map(__map), p(_p) {}
+        const_iterator() : ref(nullptr), p(nullptr) {}
+        const_iterator(const iterator &o) : ref(o.get()), p(o.p) {}
+        const_iterator(const const_iterator &o) : ref(o.get()), p(o.p) {}
+        const_iterator(const map *__map, const typename RBT::node *_p) : ref(__map), p(_p) {}
 
         const_iterator operator++(int) {
-            if (*this == _map->cend())
+            if (Checked && *this == this->get()->cend())
                 throw invalid_iterator();
             const const_iterator res(*this);
             p = p->next;
             return res;
         }
         const_iterator &operator++() {
-            if (*this == _map->cend())
+            if (Checked && *this == this->get()->cend())
                 throw invalid_iterator();
             p = p->next;
             return *this;
         }
+        // the thread runs through nil, so --end() is the maximum in O(1)
         const_iterator operator--(int) {
-            if (*this == _map->cbegin())
+            if (Checked && this->get()->tr.at_begin(p))
                 throw invalid_iterator();
             const const_iterator res(*this);
-            if (p == _map->tr.nil) {
-                p = _map->tr.root;
-                while (p->son[1] != _map->tr.nil)
-                    p = p->son[1];
-            } else
-                p = p->last;
+            p = p->last;
             return res;
         }
         const_iterator &operator--() {
-            if (*this == _map->cbegin())
+            if (Checked && this->get()->tr.at_begin(p))
                 throw invalid_iterator();
-            if (p == _map->tr.nil) {
-                p = _map->tr.root;
-                while (p->son[1] != _map->tr.nil)
-                    p = p->son[1];
-            } else
-                p = p->last;
+            p = p->last;
             return *this;
         }
 
+        /**
+         * random access in O(log n), for a Ranked map only.
+         * throw if the result would leave [begin(), end()].
+         */
+        const_iterator &operator+=(difference_type n) {
+            static_assert(Ranked, "iterator arithmetic needs a ranked map");
+            p = this->get()->tr.advance(p, n);
+            return *this;
+        }
+        const_iterator &operator-=(difference_type n) {
+            return *this += -n;
+        }
+        const_iterator operator+(difference_type n) const {
+            const_iterator res(*this);
+            return res += n;
+        }
+        const_iterator operator-(difference_type n) const {
+            const_iterator res(*this);
+            return res -= n;
+        }
+        difference_type operator-(const const_iterator &o) const {
+            static_assert(Ranked, "iterator arithmetic needs a ranked map");
+            if (Checked && this->get() != o.get())
+                throw invalid_iterator();
+            return difference_type(this->get()->tr.position(p)) - difference_type(this->get()->tr.position(o.p));
+        }
+        reference operator[](difference_type n) const {
+            return *(*this + n);
+        }
+        bool operator<(const const_iterator &o) const {
+            return *this - o < 0;
+        }
+        bool operator>(const const_iterator &o) const {
+            return *this - o > 0;
+        }
+        bool operator<=(const const_iterator &o) const {
+            return *this - o <= 0;
+        }
+        bool operator>=(const const_iterator &o) const {
+            return *this - o >= 0;
+        }
+
         reference operator*() const {
-            return *p->value;
+            return p->value();
         }
         pointer operator->() const noexcept {
-            return &(*p->value);
+            return &p->value();
         }
 
         bool operator==(const iterator &o) const {
-            return _map == o._map && p == o.p;
+            return this->get() == o.get() && p == o.p;
         }
         bool operator==(const const_iterator &o) const {
-            return _map == o._map && p == o.p;
+            return this->get() == o.get() && p == o.p;
         }
         bool operator!=(const iterator &o) const {
-            return _map != o._map || p != o.p;
+            return this->get() != o.get() || p != o.p;
         }
         bool operator!=(const const_iterator &o) const {
-            return _map != o._map || p != o.p;
+            return this->get() != o.get() || p != o.p;
         }
     };
 
 
+private:
+    typename RBT::node *hint_node(const const_iterator &hint) {
+        if (Checked && hint.get() != this)
+            throw invalid_iterator();
+        tr.revive();
+        return hint.p == nullptr ? tr.nil : const_cast<typename RBT::node *>(hint.p);
+    }
+
+    // the default resolve of the set operations: our value stays
+    struct keep_own {
+        void operator()(const Key &, T &, const T &) const {}
+    };
+    template<class F>
+    void combine(const map &o, typename RBT::set_op op, F &resolve) {
+        if (this == &o) {
+            map copy(o);
+            tr.combine(copy.tr, op, resolve);
+        } else
+            tr.combine(o.tr, op, resolve);
+    }
+
 public:
-    map() {}
-    map(const map &o) = default;
+    map() : tr(Allocator()) {}
+    explicit map(const Allocator &alloc) : tr(alloc) {}
+    map(const map &o) : tr(o.tr, std::allocator_traits<Allocator>::select_on_container_copy_construction(o.get_allocator())) {}
+    map(const map &o, const Allocator &alloc) : tr(o.tr, alloc) {}
+    /**
+     * copy o, splitting a copy of at least 2^16 elements over two threads when
+     * Allocator is std::allocator and the machine has more than one core.
+     * the copy constructors of Key and T then run on both threads at once, so
+     * they must not share state without synchronizing it; the plain copy
+     * constructor always copies on the calling thread, as does this one with
+     * SJTU_MAP_NO_THREADS defined.
+     */
+    map(parallel_copy_t, const map &o)
+        : tr(o.tr, std::allocator_traits<Allocator>::select_on_container_copy_construction(o.get_allocator()), true) {}
+    /**
+     * build from [first, last), which must be sorted by Compare and free of
+     * duplicate keys: a balanced tree is laid out in one linear pass, with the
+     * nodes allocated contiguously in key order.
+     */
+    template<class ForwardIt>
+    map(sorted_unique_t, ForwardIt first, ForwardIt last, const Allocator &alloc = Allocator()) : tr(alloc) {
+        tr.assign_sorted(first, last);
+    }
+    /**
+     * moving hands over the whole tree in O(1); o is left empty.
+     * iterators into o are invalidated, since with Checked or Ranked they keep
+     * naming o; only plain node-pointer iterators (neither Checked nor Ranked)
+     * go on pointing to the same elements, which now belong to *this.
+     */
+    map(map &&o) noexcept : tr(std::move(o.tr)) {}
     ~map() = default;
     map &operator=(const map &o) = default;
+    /**
+     * iterators into o are invalidated as for the move constructor; all of
+     * them are when the allocators differ and do not propagate, as the
+     * elements are then moved one by one into new nodes.
+     */
+    map &operator=(map &&o) noexcept(std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value) {
+        tr = std::move(o.tr);
+        return *this;
+    }
+
+    /**
+     * exchange the trees in O(1). iterators into either map are invalidated
+     * as for the move constructor.
+     */
+    void swap(map &o) noexcept {
+        tr.swap(o.tr);
+    }
+
+    allocator_type get_allocator() const {
+        return allocator_type(tr.alloc);
+    }
 
     void clear() {
-        if (tr.root != tr.nil)
-            tr.clear(tr.root);
-        tr._size = 0;
-        tr.root = tr.nil;
+        tr.clear();
+    }
+
+    /**
+     * replace the content with [first, last), sorted and unique as for the
+     * sorted_unique constructor, in O(n).
+     */
+    template<class ForwardIt>
+    void assign(sorted_unique_t, ForwardIt first, ForwardIt last) {
+        tr.assign_sorted(first, last);
+    }
+
+    /**
+     * preallocate room for n elements, so that inserting up to n elements
+     * in total does not go back to the system allocator.
+     */
+    void reserve(size_t n) {
+        if (n > tr._size)
+            tr.reserve(n - tr._size);
     }
 
     T &at(const Key &k) {
         typename RBT::node *p = tr.find(k);
         if (p != tr.nil)
-            return p->value->second;
+            return p->value().second;
         throw index_out_of_bound();
     }
     const T& at(const Key &k) const {
         const typename RBT::node *p = tr.find(k);
         if (p != tr.nil)
-            return p->value->second;
+            return p->value().second;
         throw index_out_of_bound();
     }
 
-    T &operator[](const Key &k) {
+    /**
+     * heterogeneous lookup: when Compare declares is_transparent, find, count,
+     * at and the bound functions accept any K that Compare can order against Key,
+     * and no temporary Key is ever built.
+     */
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    T &at(const K &k) {
         typename RBT::node *p = tr.find(k);
-        if (p == tr.nil)
-            return tr.insert(value_type(k, T()))->value->second;
-        return p->value->second;
+        if (p != tr.nil)
+            return p->value().second;
+        throw index_out_of_bound();
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const T& at(const K &k) const {
+        const typename RBT::node *p = tr.find(k);
+        if (p != tr.nil)
+            return p->value().second;
+        throw index_out_of_bound();
+    }
+
+    T &operator[](const Key &k) {
+        return tr.try_emplace(k).first->value().second;
+    }
+    T &operator[](Key &&k) {
+        return tr.try_emplace(std::move(k)).first->value().second;
     }
     const T& operator[](const Key &k) const {
         const typename RBT::node *p = tr.find(k);
         if (p != tr.nil)
-            return p->value->second;
+            return p->value().second;
         throw index_out_of_bound();
     }
 
@@ -543,6 +2125,23 @@ public:
         return const_iterator(this, p);
     }
 
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    // the maximum is kept at hand, so these are O(1) like begin() and end()
+    reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+    const_reverse_iterator crbegin() const {
+        return const_reverse_iterator(cend());
+    }
+    reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+    const_reverse_iterator crend() const {
+        return const_reverse_iterator(cbegin());
+    }
+
     bool empty() const {
         return tr._size == 0;
     }
@@ -557,10 +2156,105 @@ public:
      *   the second one is true if insert successfully, or false.
      */
     pair<iterator, bool> insert(const value_type &value) {
-        typename RBT::node *p = tr.insert(value);
-        if (p == tr.nil)
-            return pair<iterator, bool>(iterator(this, tr.find(value.first)), false);
-        return pair<iterator, bool>(iterator(this, p), true);
+        pair<typename RBT::node *, bool> res = tr.insert(nullptr, value);
+        return pair<iterator, bool>(iterator(this, res.first), res.second);
+    }
+    pair<iterator, bool> insert(value_type &&value) {
+        pair<typename RBT::node *, bool> res = tr.insert(nullptr, std::move(value));
+        return pair<iterator, bool>(iterator(this, res.first), res.second);
+    }
+
+    /**
+     * insert value as close as possible to just before hint.
+     * when that is the right place (e.g. hint == end() for ascending keys)
+     * the node is linked in without searching from the root.
+     * return the new element, or the element that prevented the insertion.
+     */
+    iterator insert(const_iterator hint, const value_type &value) {
+        return iterator(this, tr.insert(hint_node(hint), value).first);
+    }
+    iterator insert(const_iterator hint, value_type &&value) {
+        return iterator(this, tr.insert(hint_node(hint), std::move(value)).first);
+    }
+    template<class... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args) {
+        return iterator(this, tr.emplace(hint_node(hint), std::forward<Args>(args)...).first);
+    }
+
+    /**
+     * construct the element in place from args.
+     * the node is built before the key is known, so it is thrown away
+     * again if the key is already present; try_emplace avoids that.
+     */
+    template<class... Args>
+    pair<iterator, bool> emplace(Args&&... args) {
+        pair<typename RBT::node *, bool> res = tr.emplace(nullptr, std::forward<Args>(args)...);
+        return pair<iterator, bool>(iterator(this, res.first), res.second);
+    }
+
+    /**
+     * insert k with a value constructed in place from args, if k is absent:
+     * T is never copied or moved, so it need not be movable at all.
+     * when k is present, neither k nor args are touched.
+     */
+    template<class... Args>
+    pair<iterator, bool> try_emplace(const Key &k, Args&&... args) {
+        pair<typename RBT::node *, bool> res = tr.try_emplace(k, std::forward<Args>(args)...);
+        return pair<iterator, bool>(iterator(this, res.first), res.second);
+    }
+    template<class... Args>
+    pair<iterator, bool> try_emplace(Key &&k, Args&&... args) {
+        pair<typename RBT::node *, bool> res = tr.try_emplace(std::move(k), std::forward<Args>(args)...);
+        return pair<iterator, bool>(iterator(this, res.first), res.second);
+    }
+
+    /**
+     * insert (k, obj), or assign obj to the mapped value if k is present.
+     * the second of the result is true if a new element was inserted.
+     */
+    template<class M>
+    pair<iterator, bool> insert_or_assign(const Key &k, M &&obj) {
+        pair<typename RBT::node *, bool> res = tr.insert_or_assign(k, std::forward<M>(obj));
+        return pair<iterator, bool>(iterator(this, res.first), res.second);
+    }
+    template<class M>
+    pair<iterator, bool> insert_or_assign(Key &&k, M &&obj) {
+        pair<typename RBT::node *, bool> res = tr.insert_or_assign(std::move(k), std::forward<M>(obj));
+        return pair<iterator, bool>(iterator(this, res.first), res.second);
+    }
+
+    /**
+     * apply a batch of upserts and erases, given as a range of batch_op.
+     * the ops are handled in key order (ops on the same key keep their order),
+     * so the batch is sorted first unless it already is, and then merged into
+     * the tree in a single pass: each op starts from where the previous one
+     * ended, for O(m log(n / m + 1)) work overall instead of m full descents.
+     * the value of every upsert is moved into the map; result is set on every op.
+     */
+    template<class RandomIt>
+    void apply_batch(RandomIt first, RandomIt last) {
+        tr.revive();
+        typename RBT::node *finger = nullptr;
+        const key_order<Compare> &cmp = tr.cmp;
+        bool sorted = true;
+        for (RandomIt it = first; it != last && sorted; ++it)
+            if (it != first && cmp(it->key, (it - 1)->key))
+                sorted = false;
+        if (sorted) {
+            for (RandomIt it = first; it != last; ++it)
+                tr.apply(*it, finger);
+            return;
+        }
+
+        std::vector<batch_op *> order;
+        order.reserve(last - first);
+        for (RandomIt it = first; it != last; ++it)
+            order.push_back(&*it);
+        std::stable_sort(order.begin(), order.end(), [&cmp](const batch_op *a, const batch_op *b) {
+            return cmp(a->key, b->key);
+        });
+        for (size_t i = 0; i < order.size(); i++)
+            tr.apply(*order[i], finger);
     }
 
     /**
@@ -568,15 +2262,170 @@ public:
      * throw if pos pointed to a bad element (pos == this->end() || pos points an element out of this)
      */
     void erase(iterator pos) {
-        if (this != pos._map || pos == end())
+        if ((Checked && this != pos.get()) || pos == end())
             throw invalid_iterator();
         tr.erase(pos.p);
     }
+    /**
+     * erase the smallest (pop_front) or the largest (pop_back) element, found in O(1).
+     * throw container_is_empty if the map is empty.
+     */
+    void pop_front() {
+        if (tr._size == 0)
+            throw container_is_empty();
+        tr.erase(tr.begin());
+    }
+    void pop_back() {
+        if (tr._size == 0)
+            throw container_is_empty();
+        tr.erase(tr.maximum());
+    }
+    /**
+     * erase every element in [first, last).
+     * throw if either iterator is out of this or last comes before first.
+     */
+    void erase(iterator first, iterator last) {
+        if (Checked && (this != first.get() || this != last.get()))
+            throw invalid_iterator();
+        size_t n = 0;
+        for (typename RBT::node *p = first.p; p != last.p; p = p->next, n++)
+            if (p == tr.nil)
+                throw invalid_iterator();
+        if (n)
+            tr.erase(first.p, last.p, n);
+    }
+    /**
+     * erase the element with the given key, if any, with a single descent.
+     * return the number of elements removed (0 or 1).
+     */
+    size_t erase(const Key &key) {
+        typename RBT::node *p = tr.find(key);
+        if (p == tr.nil)
+            return 0;
+        tr.erase(p);
+        return 1;
+    }
+
+    /**
+     * set operations with o, leaving the result in this map:
+     *   merge_union: add every element of o whose key is not here yet;
+     *   intersection: keep only the keys that o has too;
+     *   difference: keep only the keys that o does not have;
+     *   symmetric_difference: keep the keys in exactly one of the two maps.
+     * for a key in both, resolve(key, mine, theirs) may update the value kept here;
+     * by default it stays as it is. O(n + m), or O(k log(N / k)) when the smaller
+     * side, of size k, is much smaller than the other, of size N.
+     * if copying a value of o throws, no element of this map is lost or changed but
+     * by resolve; only some elements of o may have been added already.
+     */
+    template<class F>
+    void merge_union(const map &o, F resolve) {
+        combine(o, RBT::op_union, resolve);
+    }
+    void merge_union(const map &o) {
+        merge_union(o, keep_own());
+    }
+    template<class F>
+    void intersection(const map &o, F resolve) {
+        combine(o, RBT::op_intersection, resolve);
+    }
+    void intersection(const map &o) {
+        intersection(o, keep_own());
+    }
+    void difference(const map &o) {
+        keep_own resolve;
+        combine(o, RBT::op_difference, resolve);
+    }
+    void symmetric_difference(const map &o) {
+        keep_own resolve;
+        combine(o, RBT::op_symmetric, resolve);
+    }
+
+    /**
+     * move every element whose key is not less than key into a new map and return it.
+     * O(log n) plus the size of the smaller of the two parts, which is repointed to
+     * its new end. iterators to moved elements and end() iterators are invalidated.
+     * the two maps then share their memory until the last of them is cleared or
+     * destroyed: the nodes a cleared one frees are reused by the others, so two of
+     * them must not be modified on different threads at the same time.
+     */
+    map split(const Key &key) {
+        map res(get_allocator());
+        res.tr.cmp = tr.cmp;
+        tr.split_off(tr.lower_bound(key), res.tr);
+        return res;
+    }
+    /**
+     * move every element of o into this map, leaving o empty. the keys of o must all be
+     * greater, or all be less, than those of this map; throw runtime_error otherwise.
+     * O(log n) plus the size of the smaller map when the allocators compare equal;
+     * otherwise the elements of o are moved over one at a time.
+     */
+    void join(map &&o) {
+        if (this == &o || o.tr._size == 0)
+            return;
+        bool after = true;
+        if (tr._size != 0) {
+            if (tr.cmp(tr.maximum()->value().first, o.tr.begin()->value().first))
+                after = true;
+            else if (tr.cmp(o.tr.maximum()->value().first, tr.begin()->value().first))
+                after = false;
+            else
+                throw runtime_error();
+        }
+        if (tr.alloc == o.tr.alloc) {
+            if (!after)
+                tr.swap_nodes(o.tr);
+            tr.join_after(o.tr);
+            return;
+        }
+        tr.revive();
+        if (after) {
+            for (typename RBT::node *p = o.tr.begin(); p != o.tr.nil; p = p->next)
+                tr.insert(tr.nil, std::move(p->value()));
+        } else {
+            for (typename RBT::node *p = o.tr.maximum(); p != o.tr.nil; p = p->last)
+                tr.insert(tr.begin(), std::move(p->value()));
+        }
+        o.clear();
+    }
 
     size_t count(const Key &key) const {
         return tr.find(key) != tr.nil ? 1 : 0;
     }
 
+    /**
+     * the element at index k in key order, in O(log n); Ranked maps only.
+     * throw index_out_of_bound if k >= size().
+     */
+    iterator select(size_t k) {
+        static_assert(Ranked, "select needs a ranked map");
+        if (k >= tr._size)
+            throw index_out_of_bound();
+        return iterator(this, tr.select(k));
+    }
+    const_iterator select(size_t k) const {
+        static_assert(Ranked, "select needs a ranked map");
+        if (k >= tr._size)
+            throw index_out_of_bound();
+        return const_iterator(this, tr.select(k));
+    }
+    /**
+     * the number of keys less than key, in O(log n); Ranked maps only.
+     */
+    size_t rank(const Key &key) const {
+        static_assert(Ranked, "rank needs a ranked map");
+        return tr.rank(key);
+    }
+    /**
+     * the number of keys in [lo, hi), in O(log n); Ranked maps only.
+     */
+    size_t count_range(const Key &lo, const Key &hi) const {
+        static_assert(Ranked, "count_range needs a ranked map");
+        size_t a = tr.rank(lo), b = tr.rank(hi);
+        return b > a ? b - a : 0;
+    }
+
     iterator find(const Key &key) {
         typename RBT::node *p = tr.find(key);
         return p == tr.nil ? end() : iterator(this, p);
@@ -585,8 +2434,106 @@ public:
         const typename RBT::node *p = tr.find(key);
         return p == tr.nil ? cend() : const_iterator(this, p);
     }
+
+    /**
+     * lower_bound: the first element whose key is not less than key,
+     * upper_bound: the first element whose key is greater than key,
+     * equal_range: the pair of both.
+     * each is a single descent from the root, but equal_range of a transparent
+     * probe, which may match several keys, takes two; end() when there is no such element.
+     */
+    iterator lower_bound(const Key &key) {
+        return iterator(this, tr.lower_bound(key));
+    }
+    const_iterator lower_bound(const Key &key) const {
+        return const_iterator(this, tr.lower_bound(key));
+    }
+    iterator upper_bound(const Key &key) {
+        return iterator(this, tr.upper_bound(key));
+    }
+    const_iterator upper_bound(const Key &key) const {
+        return const_iterator(this, tr.upper_bound(key));
+    }
+    pair<iterator, iterator> equal_range(const Key &key) {
+        pair<typename RBT::node *, typename RBT::node *> res = tr.equal_range(key);
+        return pair<iterator, iterator>(iterator(this, res.first), iterator(this, res.second));
+    }
+    pair<const_iterator, const_iterator> equal_range(const Key &key) const {
+        pair<typename RBT::node *, typename RBT::node *> res = tr.equal_range(key);
+        return pair<const_iterator, const_iterator>(const_iterator(this, res.first), const_iterator(this, res.second));
+    }
+
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    iterator lower_bound(const K &key) {
+        return iterator(this, tr.lower_bound(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator lower_bound(const K &key) const {
+        return const_iterator(this, tr.lower_bound(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    iterator upper_bound(const K &key) {
+        return iterator(this, tr.upper_bound(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator upper_bound(const K &key) const {
+        return const_iterator(this, tr.upper_bound(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    pair<iterator, iterator> equal_range(const K &key) {
+        return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    pair<const_iterator, const_iterator> equal_range(const K &key) const {
+        return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+    }
+
+    // a probe may be equivalent to several keys: they are neighbours on the thread
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    size_t count(const K &key) const {
+        typename RBT::node *p = tr.find(key);
+        if (p == tr.nil)
+            return 0;
+        size_t n = 1;
+        for (typename RBT::node *q = p->last; q != tr.nil && !tr.cmp(q->value().first, key); q = q->last)
+            n++;
+        for (typename RBT::node *q = p->next; q != tr.nil && !tr.cmp(key, q->value().first); q = q->next)
+            n++;
+        return n;
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    iterator find(const K &key) {
+        typename RBT::node *p = tr.find(key);
+        return p == tr.nil ? end() : iterator(this, p);
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator find(const K &key) const {
+        const typename RBT::node *p = tr.find(key);
+        return p == tr.nil ? cend() : const_iterator(this, p);
+    }
 };
 
+template<class Key, class T, class Compare, class Allocator, bool Ranked, bool Checked>
+void swap(map<Key, T, Compare, Allocator, Ranked, Checked> &a, map<Key, T, Compare, Allocator, Ranked, Checked> &b) noexcept {
+    a.swap(b);
+}
+
+// map with order statistics: select, rank, count_range and random access iterators
+template<class Key, class T, class Compare = std::less<Key>, class Allocator = std::allocator<pair<const Key, T>>>
+using ranked_map = map<Key, T, Compare, Allocator, true>;
+
+#ifdef SJTU_MAP_HAS_PMR
+namespace pmr {
+/**
+ * map whose nodes come from a std::pmr::memory_resource, e.g.
+ *     std::pmr::monotonic_buffer_resource arena;
+ *     sjtu::pmr::map<int, int> m(&arena);
+ */
+template<class Key, class T, class Compare = std::less<Key>>
+using map = sjtu::map<Key, T, Compare, std::pmr::polymorphic_allocator<pair<const Key, T>>>;
+}
+#endif
+
 }
 
 #endif
@@ -0,0 +1,609 @@
+#ifndef SJTU_PERSISTENT_MAP_HPP
+#define SJTU_PERSISTENT_MAP_HPP
+
+#include <atomic>
+#include <functional>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include "utility.hpp"
+#include "exceptions.hpp"
+
+namespace sjtu {
+
+/**
+ * an ordered map whose copies share structure: copying is O(1), and a mutation
+ * copies only the O(log n) nodes on its path that another copy still uses, so
+ * many snapshots live side by side in memory proportional to how they differ.
+ *
+ * the tree is an AVL tree without parent pointers or threads, so that a node
+ * can hang under the roots of several maps; each node counts the pointers to it
+ * atomically, which makes it safe to copy a map and use the copies on different
+ * threads. a single map is no more thread-safe than sjtu::map.
+ *
+ * the elements can only be changed through the map (operator[], at,
+ * insert_or_assign), never through an iterator, since the node may be shared.
+ * iterators stay valid until their own map is changed.
+ */
+template<
+    class Key,
+    class T,
+    class Compare = std::less<Key>,
+    class Allocator = std::allocator<pair<const Key, T>>
+> class persistent_map {
+public:
+    typedef pair<const Key, T> value_type;
+    typedef Allocator allocator_type;
+
+private:
+    // an AVL tree of 2^44 elements is at most this tall
+    static const size_t max_height = 64;
+
+    struct node {
+        value_type value;
+        node *son[2];
+        std::atomic<size_t> refs;
+        int h;
+
+        template<class... Args>
+        explicit node(Args&&... args) : value(std::forward<Args>(args)...), refs(1), h(1) {
+            son[0] = son[1] = nullptr;
+        }
+    };
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<node> node_allocator;
+    typedef std::allocator_traits<node_allocator> node_traits;
+
+    node *root;
+    size_t _size;
+    Compare cmp;
+    node_allocator alloc;
+
+    template<class... Args>
+    node *create(Args&&... args) {
+        node *p = node_traits::allocate(alloc, 1);
+        try {
+            node_traits::construct(alloc, p, std::forward<Args>(args)...);
+        } catch (...) {
+            node_traits::deallocate(alloc, p, 1);
+            throw;
+        }
+        return p;
+    }
+    static node *share(node *t) {
+        if (t != nullptr)
+            t->refs.fetch_add(1, std::memory_order_relaxed);
+        return t;
+    }
+    // drop one pointer to t, freeing what no map uses any more
+    void release(node *t) {
+        while (t != nullptr && t->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            node *r = t->son[1];
+            release(t->son[0]);
+            node_traits::destroy(alloc, t);
+            node_traits::deallocate(alloc, t, 1);
+            t = r;
+        }
+    }
+    // make the node in slot t ours alone, copying it if another map uses it too
+    void unshare(node *&t) {
+        if (t->refs.load(std::memory_order_acquire) == 1)
+            return;
+        node *c = create(t->value);
+        c->son[0] = share(t->son[0]), c->son[1] = share(t->son[1]);
+        c->h = t->h;
+        release(t);
+        t = c;
+    }
+
+    static int height(const node *t) {
+        return t == nullptr ? 0 : t->h;
+    }
+    static void pull(node *t) {
+        int a = height(t->son[0]), b = height(t->son[1]);
+        t->h = (a > b ? a : b) + 1;
+    }
+    // lift son d of t into its place; both must be ours alone
+    static void rotate(node *&t, int d) {
+        node *c = t->son[d];
+        t->son[d] = c->son[!d];
+        c->son[!d] = t;
+        pull(t), pull(c);
+        t = c;
+    }
+    // restore the AVL balance at t after one of its subtrees changed height by one
+    void fix(node *&t) {
+        int b = height(t->son[1]) - height(t->son[0]);
+        if (b < 2 && b > -2) {
+            pull(t);
+            return;
+        }
+        int d = b > 0;
+        unshare(t->son[d]);
+        node *c = t->son[d];
+        if (height(c->son[!d]) > height(c->son[d])) {
+            unshare(c->son[!d]);
+            rotate(t->son[d], !d);
+        }
+        rotate(t, d);
+    }
+
+    template<class K>
+    const node *find_node(const K &k) const {
+        const node *p = root;
+        while (p != nullptr) {
+            if (cmp(k, p->value.first))
+                p = p->son[0];
+            else if (cmp(p->value.first, k))
+                p = p->son[1];
+            else
+                return p;
+        }
+        return nullptr;
+    }
+    // the node with key k, which must be present, after copying the shared nodes on its path
+    template<class K>
+    node *touch(const K &k) {
+        node **slot = &root;
+        while (true) {
+            unshare(*slot);
+            node *p = *slot;
+            if (cmp(k, p->value.first))
+                slot = &p->son[0];
+            else if (cmp(p->value.first, k))
+                slot = &p->son[1];
+            else
+                return p;
+        }
+    }
+    // add a node for k, which must be absent, built from args
+    template<class K, class... Args>
+    void insert_rec(node *&t, const K &k, Args&&... args) {
+        if (t == nullptr) {
+            t = create(std::forward<Args>(args)...);
+            return;
+        }
+        unshare(t);
+        insert_rec(t->son[cmp(t->value.first, k)], k, std::forward<Args>(args)...);
+        fix(t);
+    }
+    // detach the smallest node of t
+    node *take_min(node *&t) {
+        unshare(t);
+        if (t->son[0] == nullptr) {
+            node *m = t;
+            t = m->son[1];
+            m->son[1] = nullptr;
+            return m;
+        }
+        node *m = take_min(t->son[0]);
+        fix(t);
+        return m;
+    }
+    // remove the node with key k, which must be present; k is not used once it is found
+    template<class K>
+    void erase_rec(node *&t, const K &k) {
+        unshare(t);
+        if (cmp(k, t->value.first)) {
+            erase_rec(t->son[0], k);
+        } else if (cmp(t->value.first, k)) {
+            erase_rec(t->son[1], k);
+        } else {
+            node *x = t;
+            if (x->son[0] == nullptr || x->son[1] == nullptr) {
+                // the only son keeps its shape, and may be shared, so it is left alone
+                t = x->son[x->son[0] == nullptr];
+                x->son[0] = x->son[1] = nullptr;
+                release(x);
+                return;
+            }
+            t = take_min(x->son[1]);
+            t->son[0] = x->son[0], t->son[1] = x->son[1];
+            x->son[0] = x->son[1] = nullptr;
+            release(x);
+        }
+        fix(t);
+    }
+
+    // a balanced tree of the next n values from it
+    template<class InputIt>
+    node *build(InputIt &it, size_t n) {
+        if (n == 0)
+            return nullptr;
+        node *l = build(it, n / 2), *t;
+        try {
+            t = create(*it);
+        } catch (...) {
+            release(l);
+            throw;
+        }
+        ++it;
+        t->son[0] = l;
+        try {
+            t->son[1] = build(it, n - n / 2 - 1);
+        } catch (...) {
+            release(t);
+            throw;
+        }
+        pull(t);
+        return t;
+    }
+
+public:
+    /**
+     * a bidirectional iterator over the elements, read-only.
+     * it keeps the path from the root, so stepping is amortized O(1).
+     * throw invalid_iterator on ++end() and --begin().
+     */
+    class const_iterator {
+        friend class persistent_map;
+
+    public:
+        typedef const pair<const Key, T> value_type;
+        typedef value_type&         reference;
+        typedef value_type*           pointer;
+        typedef std::ptrdiff_t        difference_type;
+        typedef std::bidirectional_iterator_tag iterator_category;
+
+    private:
+        const persistent_map *_map;
+        const node *stack[max_height];
+        size_t depth; // 0 at end()
+
+        void push_min(const node *p) {
+            for (; p != nullptr; p = p->son[0])
+                stack[depth++] = p;
+        }
+        void push_max(const node *p) {
+            for (; p != nullptr; p = p->son[1])
+                stack[depth++] = p;
+        }
+
+    public:
+        const_iterator() : _map(nullptr), depth(0) {}
+        const_iterator(const persistent_map *__map) : _map(__map), depth(0) {}
+        const_iterator(const const_iterator &o) : _map(o._map), depth(o.depth) {
+            for (size_t i = 0; i < depth; i++)
+                stack[i] = o.stack[i];
+        }
+        const_iterator &operator=(const const_iterator &o) {
+            _map = o._map, depth = o.depth;
+            for (size_t i = 0; i < depth; i++)
+                stack[i] = o.stack[i];
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator res(*this);
+            ++*this;
+            return res;
+        }
+        const_iterator &operator++() {
+            if (_map == nullptr || depth == 0)
+                throw invalid_iterator();
+            const node *p = stack[depth - 1];
+            if (p->son[1] != nullptr) {
+                push_min(p->son[1]);
+            } else {
+                do
+                    p = stack[--depth];
+                while (depth > 0 && stack[depth - 1]->son[1] == p);
+            }
+            return *this;
+        }
+        const_iterator operator--(int) {
+            const_iterator res(*this);
+            --*this;
+            return res;
+        }
+        const_iterator &operator--() {
+            if (_map == nullptr || _map->root == nullptr)
+                throw invalid_iterator();
+            if (depth == 0) {
+                push_max(_map->root);
+                return *this;
+            }
+            const node *p = stack[depth - 1];
+            if (p->son[0] != nullptr) {
+                push_max(p->son[0]);
+                return *this;
+            }
+            size_t d = depth;
+            do
+                p = stack[--d];
+            while (d > 0 && stack[d - 1]->son[0] == p);
+            if (d == 0)
+                throw invalid_iterator();
+            depth = d;
+            return *this;
+        }
+
+        reference operator*() const {
+            return stack[depth - 1]->value;
+        }
+        pointer operator->() const noexcept {
+            return &stack[depth - 1]->value;
+        }
+
+        bool operator==(const const_iterator &o) const {
+            return _map == o._map && depth == o.depth && (depth == 0 || stack[depth - 1] == o.stack[depth - 1]);
+        }
+        bool operator!=(const const_iterator &o) const {
+            return !(*this == o);
+        }
+    };
+    typedef const_iterator iterator;
+
+private:
+    // iterators to the first element not less than (or, with upper, greater than) k
+    template<class K>
+    const_iterator bound(const K &k, bool upper) const {
+        const_iterator it(this), res(this);
+        for (const node *p = root; p != nullptr;) {
+            it.stack[it.depth++] = p;
+            if (upper ? cmp(k, p->value.first) : !cmp(p->value.first, k)) {
+                res = it;
+                p = p->son[0];
+            } else {
+                p = p->son[1];
+            }
+        }
+        return res;
+    }
+    template<class K>
+    const_iterator find_it(const K &k) const {
+        const_iterator it(this);
+        for (const node *p = root; p != nullptr;) {
+            it.stack[it.depth++] = p;
+            if (cmp(k, p->value.first))
+                p = p->son[0];
+            else if (cmp(p->value.first, k))
+                p = p->son[1];
+            else
+                return it;
+        }
+        return const_iterator(this);
+    }
+    void check_hint(const const_iterator &hint) const {
+        if (hint._map != this)
+            throw invalid_iterator();
+    }
+    template<class K, class... Args>
+    pair<iterator, bool> insert_key(const K &k, Args&&... args) {
+        if (find_node(k) != nullptr)
+            return pair<iterator, bool>(find_it(k), false);
+        insert_rec(root, k, std::forward<Args>(args)...);
+        _size++;
+        return pair<iterator, bool>(find_it(k), true);
+    }
+
+public:
+    persistent_map() : root(nullptr), _size(0), cmp(), alloc() {}
+    explicit persistent_map(const Allocator &a) : root(nullptr), _size(0), cmp(), alloc(a) {}
+    /**
+     * O(1): the copy shares every node with o until one of them is changed.
+     */
+    persistent_map(const persistent_map &o) : root(share(o.root)), _size(o._size), cmp(o.cmp), alloc(o.alloc) {}
+    persistent_map(persistent_map &&o) noexcept : root(o.root), _size(o._size), cmp(std::move(o.cmp)), alloc(std::move(o.alloc)) {
+        o.root = nullptr;
+        o._size = 0;
+    }
+    /**
+     * build from [first, last), which must be sorted by Compare and free of
+     * duplicate keys, in O(n).
+     */
+    template<class ForwardIt>
+    persistent_map(sorted_unique_t, ForwardIt first, ForwardIt last, const Allocator &a = Allocator())
+        : root(nullptr), _size(0), cmp(), alloc(a) {
+        size_t n = std::distance(first, last);
+        root = build(first, n);
+        _size = n;
+    }
+    ~persistent_map() {
+        release(root);
+    }
+
+    // the nodes are shared by every copy, so the allocator always goes with them
+    persistent_map &operator=(const persistent_map &o) {
+        node *r = share(o.root);
+        release(root);
+        root = r, _size = o._size;
+        cmp = o.cmp, alloc = o.alloc;
+        return *this;
+    }
+    persistent_map &operator=(persistent_map &&o) noexcept {
+        if (this == &o)
+            return *this;
+        release(root);
+        root = o.root, _size = o._size;
+        cmp = std::move(o.cmp), alloc = std::move(o.alloc);
+        o.root = nullptr;
+        o._size = 0;
+        return *this;
+    }
+    void swap(persistent_map &o) noexcept {
+        std::swap(root, o.root), std::swap(_size, o._size);
+        using std::swap;
+        swap(cmp, o.cmp);
+        swap(alloc, o.alloc);
+    }
+    allocator_type get_allocator() const {
+        return allocator_type(alloc);
+    }
+
+    /**
+     * access specified element with bounds checking.
+     * throw index_out_of_bound if no such element exists.
+     * the non-const version copies the shared nodes on the way, since the result may be written.
+     */
+    T &at(const Key &key) {
+        if (find_node(key) == nullptr)
+            throw index_out_of_bound();
+        return touch(key)->value.second;
+    }
+    const T &at(const Key &key) const {
+        const node *p = find_node(key);
+        if (p == nullptr)
+            throw index_out_of_bound();
+        return p->value.second;
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const T &at(const K &key) const {
+        const node *p = find_node(key);
+        if (p == nullptr)
+            throw index_out_of_bound();
+        return p->value.second;
+    }
+    T &operator[](const Key &key) {
+        if (find_node(key) == nullptr) {
+            insert_rec(root, key, key, T());
+            _size++;
+        }
+        return touch(key)->value.second;
+    }
+    // behave like at(): throw index_out_of_bound if no such element exists
+    const T &operator[](const Key &key) const {
+        return at(key);
+    }
+
+    const_iterator begin() const {
+        const_iterator it(this);
+        it.push_min(root);
+        return it;
+    }
+    const_iterator cbegin() const {
+        return begin();
+    }
+    const_iterator end() const {
+        return const_iterator(this);
+    }
+    const_iterator cend() const {
+        return const_iterator(this);
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+    size_t size() const {
+        return _size;
+    }
+    void clear() {
+        release(root);
+        root = nullptr;
+        _size = 0;
+    }
+
+    /**
+     * insert value if its key is absent.
+     * return a pair of the iterator to the element with that key, and whether
+     * the insertion took place.
+     */
+    pair<iterator, bool> insert(const value_type &value) {
+        return insert_key(value.first, value);
+    }
+    pair<iterator, bool> insert(value_type &&value) {
+        return insert_key(value.first, std::move(value));
+    }
+    // the hint must be an iterator of this map (throw invalid_iterator otherwise) and is not used
+    iterator insert(const_iterator hint, const value_type &value) {
+        check_hint(hint);
+        return insert(value).first;
+    }
+    iterator insert(const_iterator hint, value_type &&value) {
+        check_hint(hint);
+        return insert(std::move(value)).first;
+    }
+    template<class... Args>
+    pair<iterator, bool> emplace(Args&&... args) {
+        value_type v(std::forward<Args>(args)...);
+        return insert_key(v.first, std::move(v));
+    }
+    template<class... Args>
+    pair<iterator, bool> try_emplace(const Key &key, Args&&... args) {
+        if (find_node(key) != nullptr)
+            return pair<iterator, bool>(find_it(key), false);
+        return insert_key(key, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    template<class M>
+    pair<iterator, bool> insert_or_assign(const Key &key, M &&obj) {
+        if (find_node(key) != nullptr) {
+            touch(key)->value.second = std::forward<M>(obj);
+            return pair<iterator, bool>(find_it(key), false);
+        }
+        return insert_key(key, key, std::forward<M>(obj));
+    }
+
+    /**
+     * erase the element at pos.
+     * throw if pos pointed to a bad element (pos == this->end() || pos points an element out of this)
+     */
+    void erase(const_iterator pos) {
+        if (this != pos._map || pos.depth == 0)
+            throw invalid_iterator();
+        erase_rec(root, pos->first);
+        _size--;
+    }
+    /**
+     * erase the element with the given key, if any.
+     * return the number of elements removed (0 or 1).
+     */
+    size_t erase(const Key &key) {
+        if (find_node(key) == nullptr)
+            return 0;
+        erase_rec(root, key);
+        _size--;
+        return 1;
+    }
+
+    size_t count(const Key &key) const {
+        return find_node(key) != nullptr ? 1 : 0;
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    size_t count(const K &key) const {
+        // a probe may be equivalent to several keys
+        size_t n = 0;
+        for (const_iterator i = lower_bound(key), e = upper_bound(key); i != e; ++i)
+            n++;
+        return n;
+    }
+    const_iterator find(const Key &key) const {
+        return find_it(key);
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator find(const K &key) const {
+        return find_it(key);
+    }
+    // first element whose key is not less than key
+    const_iterator lower_bound(const Key &key) const {
+        return bound(key, false);
+    }
+    // first element whose key is greater than key
+    const_iterator upper_bound(const Key &key) const {
+        return bound(key, true);
+    }
+    pair<const_iterator, const_iterator> equal_range(const Key &key) const {
+        return pair<const_iterator, const_iterator>(bound(key, false), bound(key, true));
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator lower_bound(const K &key) const {
+        return bound(key, false);
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator upper_bound(const K &key) const {
+        return bound(key, true);
+    }
+    template<class K, class C = Compare, class = typename C::is_transparent>
+    pair<const_iterator, const_iterator> equal_range(const K &key) const {
+        return pair<const_iterator, const_iterator>(bound(key, false), bound(key, true));
+    }
+};
+
+template<class Key, class T, class Compare, class Allocator>
+void swap(persistent_map<Key, T, Compare, Allocator> &a, persistent_map<Key, T, Compare, Allocator> &b) noexcept {
+    a.swap(b);
+}
+
+}
+
+#endif
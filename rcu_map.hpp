@@ -0,0 +1,237 @@
+#ifndef SJTU_RCU_MAP_HPP
+#define SJTU_RCU_MAP_HPP
+
+#include <atomic>
+#include <functional>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "epoch.hpp"
+#include "persistent_map.hpp"
+
+namespace sjtu {
+
+/**
+ * a thread-safe ordered map for read-mostly use: readers never lock and never
+ * write shared memory.
+ *
+ * the map is a published persistent_map version. a writer, one at a time,
+ * copies it in O(1), changes the copy (which copies only the nodes on its
+ * paths), and publishes the copy with one atomic store; several changes can be
+ * batched into one version with write(). a reader pins an epoch, loads the
+ * current version and walks it with plain loads: published nodes are never
+ * written again. the version a writer replaces is retired to an epoch_domain,
+ * and its nodes are freed once every reader that could see it has unpinned:
+ * with no reader in the way, before the write returns, and otherwise by the
+ * thread that next finds it safe, so the allocator must be usable from any
+ * thread that uses the map.
+ *
+ * read() gives a view that keeps one version alive for as long as a traversal
+ * needs; it must be dropped on the thread that took it, and a thread holding a
+ * view holds back reclamation.
+ */
+template<
+    class Key,
+    class T,
+    class Compare = std::less<Key>,
+    class Allocator = std::allocator<pair<const Key, T>>
+> class rcu_map {
+public:
+    typedef pair<const Key, T> value_type;
+    typedef Allocator allocator_type;
+    typedef persistent_map<Key, T, Compare, Allocator> version_type;
+    typedef typename version_type::const_iterator const_iterator;
+
+    /**
+     * a pinned, immutable version of the map. every const member of
+     * persistent_map can be used through it.
+     */
+    class view {
+        epoch_domain::guard g;
+        const version_type *v;
+
+    public:
+        view(const epoch_domain::guard &_g, const version_type *_v) : g(_g), v(_v) {}
+
+        const version_type &operator*() const {
+            return *v;
+        }
+        const version_type *operator->() const {
+            return v;
+        }
+    };
+
+private:
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<version_type> version_allocator;
+    typedef std::allocator_traits<version_allocator> version_traits;
+
+    std::atomic<version_type *> current;
+    std::mutex writer;
+    version_allocator alloc;
+    mutable epoch_domain dom; // last, so it reclaims before the allocator goes
+
+    template<class... Args>
+    version_type *make_version(Args&&... args) {
+        version_type *v = version_traits::allocate(alloc, 1);
+        try {
+            version_traits::construct(alloc, v, std::forward<Args>(args)...);
+        } catch (...) {
+            version_traits::deallocate(alloc, v, 1);
+            throw;
+        }
+        return v;
+    }
+    void drop(version_type *v) {
+        version_traits::destroy(alloc, v);
+        version_traits::deallocate(alloc, v, 1);
+    }
+    static void reclaim(void *ctx, void *p) {
+        static_cast<rcu_map *>(ctx)->drop(static_cast<version_type *>(p));
+    }
+
+    /**
+     * with the writer lock held, let f change a copy of the current version,
+     * then publish the copy and retire the old one. if f throws, nothing is published.
+     */
+    template<class F>
+    void publish(F f) {
+        epoch_domain::guard g = dom.pin();
+        version_type *old = current.load(std::memory_order_relaxed);
+        version_type *next = make_version(*old);
+        try {
+            f(*next);
+        } catch (...) {
+            drop(next);
+            throw;
+        }
+        current.store(next, std::memory_order_release);
+        dom.retire(old, reclaim, this);
+    }
+
+public:
+    explicit rcu_map(const Allocator &a = Allocator()) : current(nullptr), alloc(a) {
+        current.store(make_version(a), std::memory_order_relaxed);
+    }
+    rcu_map(const rcu_map &) = delete;
+    rcu_map &operator=(const rcu_map &) = delete;
+    ~rcu_map() {
+        drop(current.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * pin the current version for reading. changes published later do not show
+     * in it.
+     */
+    view read() const {
+        epoch_domain::guard g = dom.pin();
+        return view(g, current.load(std::memory_order_acquire));
+    }
+    /**
+     * an unpinned copy of the current version, in O(1); it shares nodes with the
+     * map but stays valid however long it is kept, on any thread.
+     */
+    version_type snapshot() const {
+        return *read();
+    }
+
+    size_t count(const Key &key) const {
+        return read()->count(key);
+    }
+    /**
+     * a copy of the value mapped to key.
+     * throw index_out_of_bound if no such element exists.
+     */
+    T at(const Key &key) const {
+        return read()->at(key);
+    }
+    /**
+     * call f(const value_type &) on the element with the given key, as found in
+     * the current version; return whether the element exists.
+     */
+    template<class F>
+    bool visit(const Key &key, F f) const {
+        view v = read();
+        const_iterator it = v->find(key);
+        if (it == v->cend())
+            return false;
+        f(*it);
+        return true;
+    }
+    size_t size() const {
+        return read()->size();
+    }
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * apply every change f(version_type &) makes as one new version: readers see
+     * all of them or none. writers are serialized, and a batch copies each node
+     * on its paths at most once.
+     */
+    template<class F>
+    void write(F f) {
+        std::lock_guard<std::mutex> l(writer);
+        publish(f);
+    }
+
+    /**
+     * insert value if its key is absent; return whether it was inserted.
+     * like every point change below, it publishes a version only if something changes.
+     */
+    bool insert(const value_type &value) {
+        std::lock_guard<std::mutex> l(writer);
+        if (current.load(std::memory_order_relaxed)->count(value.first))
+            return false;
+        publish([&value](version_type &v) { v.insert(value); });
+        return true;
+    }
+    template<class... Args>
+    bool try_emplace(const Key &key, Args&&... args) {
+        std::lock_guard<std::mutex> l(writer);
+        if (current.load(std::memory_order_relaxed)->count(key))
+            return false;
+        T value(std::forward<Args>(args)...);
+        publish([&key, &value](version_type &v) { v.try_emplace(key, std::move(value)); });
+        return true;
+    }
+    // return true if a new element was inserted, false if the value was assigned
+    template<class M>
+    bool insert_or_assign(const Key &key, M &&obj) {
+        std::lock_guard<std::mutex> l(writer);
+        bool res = current.load(std::memory_order_relaxed)->count(key) == 0;
+        publish([&key, &obj](version_type &v) { v.insert_or_assign(key, std::forward<M>(obj)); });
+        return res;
+    }
+    size_t erase(const Key &key) {
+        std::lock_guard<std::mutex> l(writer);
+        if (!current.load(std::memory_order_relaxed)->count(key))
+            return 0;
+        publish([&key](version_type &v) { v.erase(key); });
+        return 1;
+    }
+    /**
+     * call f(T &) on the value mapped to key in a new version, so a
+     * read-modify-write is atomic; return whether the element exists.
+     */
+    template<class F>
+    bool update(const Key &key, F f) {
+        std::lock_guard<std::mutex> l(writer);
+        if (!current.load(std::memory_order_relaxed)->count(key))
+            return false;
+        publish([&key, &f](version_type &v) { f(v.at(key)); });
+        return true;
+    }
+    void clear() {
+        std::lock_guard<std::mutex> l(writer);
+        if (!current.load(std::memory_order_relaxed)->empty())
+            publish([](version_type &v) { v.clear(); });
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,726 @@
+#ifndef SJTU_SKIPLIST_MAP_HPP
+#define SJTU_SKIPLIST_MAP_HPP
+
+#include <atomic>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "epoch.hpp"
+
+namespace sjtu {
+
+/**
+ * an ordered map with the interface of sjtu::map that threads may use at the
+ * same time without locks: a skip list whose links are changed by CAS only.
+ *
+ * an element is erased by marking its links, top level first, and the bottom
+ * mark decides which erase wins; whoever walks past a marked node unlinks it.
+ * unlinked nodes are reclaimed through an epoch_domain, and every iterator keeps
+ * its thread pinned, so an iterator stays valid (if perhaps erased) while it
+ * lives. iterators and the references they give must stay on the thread that got
+ * them, and a thread that holds one holds back reclamation. an erased node is
+ * freed by whichever thread using the map finds it safe, so the allocator must
+ * be usable from all of them.
+ *
+ * find, count, at and lower_bound only read. the value of an element is not
+ * synchronized: writing it (operator[] = ..., insert_or_assign) while another
+ * thread reads it is a data race, just as for any other container. references
+ * returned by at() and operator[] are safe only while no other thread may erase
+ * the element. copy, assignment, and destruction need the map to themselves;
+ * clear() does not.
+ */
+template<
+    class Key,
+    class T,
+    class Compare = std::less<Key>,
+    class Allocator = std::allocator<pair<const Key, T>>
+> class skiplist_map {
+public:
+    typedef pair<const Key, T> value_type;
+    typedef Allocator allocator_type;
+
+    class iterator;
+    class const_iterator;
+
+private:
+    static const int max_level = 32;
+
+    // a pointer to the next node, with bit 0 set once the owner of the link is erased
+    typedef std::atomic<uintptr_t> link;
+
+    // height links follow the node in memory; the head has max_level of them and no value
+    struct node {
+        typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type storage;
+        std::atomic<int> owners; // the list, and the insert while it links upper levels
+        int height;
+        link next[1];
+
+        value_type *value() {
+            return reinterpret_cast<value_type *>(&storage);
+        }
+        const Key &key() {
+            return value()->first;
+        }
+    };
+
+    typedef std::allocator_traits<Allocator> value_traits;
+    typedef typename value_traits::template rebind_alloc<node> node_allocator;
+    typedef std::allocator_traits<node_allocator> node_traits;
+
+    node *head;
+    std::atomic<int> levels; // no node is taller; searches start there
+    std::atomic<size_t> _size;
+    Compare cmp;
+    Allocator alloc;
+    node_allocator nalloc;
+    mutable epoch_domain dom; // last, so it reclaims before the allocators go
+
+    static node *ptr(uintptr_t v) {
+        return reinterpret_cast<node *>(v & ~uintptr_t(1));
+    }
+    static bool marked(uintptr_t v) {
+        return v & 1;
+    }
+    static uintptr_t word(node *p) {
+        return reinterpret_cast<uintptr_t>(p);
+    }
+
+    // a node of height h takes this many node-sized blocks
+    static size_t blocks(int h) {
+        return 1 + ((h - 1) * sizeof(link) + sizeof(node) - 1) / sizeof(node);
+    }
+    node *new_node(int h) {
+        node *p = node_traits::allocate(nalloc, blocks(h));
+        new (&p->owners) std::atomic<int>(2);
+        p->height = h;
+        for (int i = 0; i < h; i++)
+            new (p->next + i) link(0);
+        return p;
+    }
+    void free_node(node *p) {
+        node_traits::deallocate(nalloc, p, blocks(p->height));
+    }
+    template<class... Args>
+    node *create(int h, Args&&... args) {
+        node *p = new_node(h);
+        try {
+            value_traits::construct(alloc, p->value(), std::forward<Args>(args)...);
+        } catch (...) {
+            free_node(p);
+            throw;
+        }
+        return p;
+    }
+    void destroy(node *p) {
+        value_traits::destroy(alloc, p->value());
+        free_node(p);
+    }
+    static void reclaim(void *ctx, void *p) {
+        static_cast<skiplist_map *>(ctx)->destroy(static_cast<node *>(p));
+    }
+
+    // each level holds half the nodes of the one below
+    static int random_level() {
+        static thread_local uint64_t s = 0;
+        if (s == 0)
+            s = (std::hash<std::thread::id>()(std::this_thread::get_id()) | 1) * 0x9E3779B97F4A7C15ull;
+        s ^= s << 13, s ^= s >> 7, s ^= s << 17;
+        uint64_t r = s;
+        int h = 1;
+        while (h < max_level && (r & 1))
+            h++, r >>= 1;
+        return h;
+    }
+
+    /**
+     * fill preds and succs with the nodes around k on every level in use, unlinking the
+     * marked nodes met on the way; return whether succs[0] holds k.
+     * the caller must be pinned.
+     */
+    template<class K>
+    bool search(const K &k, node **preds, node **succs) {
+    retry:
+        node *pred = head;
+        for (int lv = levels.load(std::memory_order_acquire) - 1; lv >= 0; lv--) {
+            node *curr = ptr(pred->next[lv].load(std::memory_order_acquire));
+            while (curr != nullptr) {
+                uintptr_t nx = curr->next[lv].load(std::memory_order_acquire);
+                if (marked(nx)) {
+                    uintptr_t expect = word(curr);
+                    if (!pred->next[lv].compare_exchange_strong(expect, nx & ~uintptr_t(1),
+                                                                std::memory_order_acq_rel, std::memory_order_relaxed))
+                        goto retry;
+                    curr = ptr(nx);
+                } else if (cmp(curr->key(), k)) {
+                    pred = curr, curr = ptr(nx);
+                } else {
+                    break;
+                }
+            }
+            preds[lv] = pred, succs[lv] = curr;
+        }
+        return succs[0] != nullptr && !cmp(k, succs[0]->key());
+    }
+    /**
+     * the first live node with a key not less than k (greater than k if strict),
+     * or nullptr. it walks through marked nodes instead of unlinking them, so it
+     * never writes. the caller must be pinned.
+     */
+    template<class K>
+    node *lower(const K &k, bool strict) const {
+        node *pred = head, *curr = nullptr;
+        for (int lv = levels.load(std::memory_order_acquire) - 1; lv >= 0; lv--) {
+            curr = ptr(pred->next[lv].load(std::memory_order_acquire));
+            while (curr != nullptr && (strict ? !cmp(k, curr->key()) : cmp(curr->key(), k)))
+                pred = curr, curr = ptr(curr->next[lv].load(std::memory_order_acquire));
+        }
+        while (curr != nullptr) {
+            uintptr_t nx = curr->next[0].load(std::memory_order_acquire);
+            if (!marked(nx))
+                break;
+            curr = ptr(nx);
+        }
+        return curr;
+    }
+    template<class K>
+    node *find_node(const K &k) const {
+        node *p = lower(k, false);
+        return p != nullptr && !cmp(k, p->key()) ? p : nullptr;
+    }
+    // the first live node after p on the bottom level, or nullptr
+    static node *next_live(node *p) {
+        uintptr_t nx = p->next[0].load(std::memory_order_acquire);
+        while (true) {
+            p = ptr(nx);
+            if (p == nullptr)
+                return nullptr;
+            nx = p->next[0].load(std::memory_order_acquire);
+            if (!marked(nx))
+                return p;
+        }
+    }
+    /**
+     * the last live node with a key less than *k (the last live node if k is nullptr),
+     * or head if there is none. the caller must be pinned.
+     */
+    node *last_before(const Key *k) const {
+        while (true) {
+            node *pred = head;
+            for (int lv = levels.load(std::memory_order_acquire) - 1; lv >= 0; lv--) {
+                node *curr = ptr(pred->next[lv].load(std::memory_order_acquire));
+                while (curr != nullptr && (k == nullptr || cmp(curr->key(), *k)))
+                    pred = curr, curr = ptr(curr->next[lv].load(std::memory_order_acquire));
+            }
+            if (pred == head || !marked(pred->next[0].load(std::memory_order_acquire)))
+                return pred;
+            // it was erased: only a list without back links, so look before it
+            k = &pred->key();
+        }
+    }
+
+    // drop one owner of a published node; the last one retires it
+    void release(node *x) {
+        if (x->owners.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            dom.retire(x, reclaim, this);
+    }
+    /**
+     * link x, already linked at the bottom, on its upper levels, giving up as soon
+     * as it is erased. an erase that finished before a late link leaves x
+     * reachable again, so in that case it is unlinked once more here; only then
+     * may x be retired, by whichever of this and the erase comes last.
+     */
+    void link_upper(node *x, node **preds, node **succs) {
+        for (int lv = 1; lv < x->height; lv++) {
+            bool erased = false;
+            while (true) {
+                uintptr_t cur = x->next[lv].load(std::memory_order_acquire);
+                // nothing but an erase changes a link of x that is not in the list yet
+                if (marked(cur) || (cur != word(succs[lv]) &&
+                    !x->next[lv].compare_exchange_strong(cur, word(succs[lv]), std::memory_order_release,
+                                                         std::memory_order_relaxed))) {
+                    erased = true;
+                    break;
+                }
+                uintptr_t expect = word(succs[lv]);
+                if (preds[lv]->next[lv].compare_exchange_strong(expect, word(x), std::memory_order_release,
+                                                                std::memory_order_relaxed))
+                    break;
+                search(x->key(), preds, succs);
+            }
+            if (erased)
+                break;
+        }
+        if (marked(x->next[0].load(std::memory_order_acquire)))
+            search(x->key(), preds, succs);
+        release(x);
+    }
+    static void take_value(node *, node *, std::false_type) {}
+    static void take_value(node *p, node *x, std::true_type) {
+        p->value()->second = std::move(x->value()->second);
+    }
+    /**
+     * K is Key or anything Compare orders against it; the value comes from args.
+     * if the key turns out to be present, its value is assigned from the new one
+     * when Assign holds. the caller must be pinned, by g.
+     */
+    template<bool Assign, class K, class... Args>
+    pair<iterator, bool> insert_key(const epoch_domain::guard &g, const K &k, Args&&... args) {
+        node *preds[max_level], *succs[max_level];
+        node *x = nullptr;
+        int h = random_level(), top = levels.load(std::memory_order_relaxed);
+        while (top < h && !levels.compare_exchange_weak(top, h, std::memory_order_release, std::memory_order_relaxed))
+            ;
+        // once x holds the value, k may have been moved from: search for x's key instead
+        while (x == nullptr ? !search(k, preds, succs) : !search(x->key(), preds, succs)) {
+            if (x == nullptr)
+                x = create(h, std::forward<Args>(args)...);
+            for (int lv = 0; lv < x->height; lv++)
+                x->next[lv].store(word(succs[lv]), std::memory_order_relaxed);
+            uintptr_t expect = word(succs[0]);
+            if (preds[0]->next[0].compare_exchange_strong(expect, word(x), std::memory_order_release,
+                                                          std::memory_order_relaxed)) {
+                _size.fetch_add(1, std::memory_order_relaxed);
+                link_upper(x, preds, succs);
+                return pair<iterator, bool>(iterator(this, x, g), true);
+            }
+        }
+        if (Assign && x == nullptr)
+            x = create(1, std::forward<Args>(args)...);
+        if (x != nullptr) {
+            try {
+                take_value(succs[0], x, std::integral_constant<bool, Assign>());
+            } catch (...) {
+                destroy(x);
+                throw;
+            }
+            destroy(x);
+        }
+        return pair<iterator, bool>(iterator(this, succs[0], g), false);
+    }
+    template<class K, class... Args>
+    pair<iterator, bool> emplace_key(K &&k, Args&&... args) {
+        epoch_domain::guard g = dom.pin();
+        node *p = find_node(k);
+        if (p != nullptr)
+            return pair<iterator, bool>(iterator(this, p, g), false);
+        return insert_key<false>(g, k, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(k)), std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    template<class K, class M>
+    pair<iterator, bool> assign_key(K &&k, M &&obj) {
+        epoch_domain::guard g = dom.pin();
+        node *p = find_node(k);
+        if (p != nullptr) {
+            p->value()->second = std::forward<M>(obj);
+            return pair<iterator, bool>(iterator(this, p, g), false);
+        }
+        return insert_key<true>(g, k, std::forward<K>(k), std::forward<M>(obj));
+    }
+    /**
+     * mark x erased, top level first, then unlink it; return false if another
+     * erase marked its bottom link first. the caller must be pinned.
+     */
+    bool erase_node(node *x) {
+        for (int lv = x->height - 1; lv > 0; lv--) {
+            uintptr_t v = x->next[lv].load(std::memory_order_relaxed);
+            while (!marked(v) && !x->next[lv].compare_exchange_weak(v, v | 1, std::memory_order_acq_rel,
+                                                                    std::memory_order_relaxed))
+                ;
+        }
+        uintptr_t v = x->next[0].load(std::memory_order_relaxed);
+        do
+            if (marked(v))
+                return false;
+        while (!x->next[0].compare_exchange_weak(v, v | 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+        _size.fetch_sub(1, std::memory_order_relaxed);
+        node *preds[max_level], *succs[max_level];
+        search(x->key(), preds, succs);
+        release(x);
+        return true;
+    }
+
+    // append copies of the elements of o in order; this must be empty and unshared
+    void copy_from(const skiplist_map &o) {
+        node *last[max_level];
+        for (int lv = 0; lv < max_level; lv++)
+            last[lv] = head;
+        epoch_domain::guard g = o.dom.pin();
+        for (node *q = next_live(o.head); q != nullptr; q = next_live(q)) {
+            node *x = create(random_level(), *q->value());
+            x->owners.store(1, std::memory_order_relaxed);
+            if (x->height > levels.load(std::memory_order_relaxed))
+                levels.store(x->height, std::memory_order_relaxed);
+            for (int lv = 0; lv < x->height; lv++) {
+                last[lv]->next[lv].store(word(x), std::memory_order_relaxed);
+                last[lv] = x;
+            }
+            _size.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    // free every node still in the list; nobody else may be using the map
+    void destroy_all() {
+        node *p = ptr(head->next[0].load(std::memory_order_acquire));
+        while (p != nullptr) {
+            node *n = ptr(p->next[0].load(std::memory_order_relaxed));
+            destroy(p);
+            p = n;
+        }
+        for (int lv = 0; lv < max_level; lv++)
+            head->next[lv].store(0, std::memory_order_relaxed);
+        levels.store(1, std::memory_order_relaxed);
+        _size.store(0, std::memory_order_relaxed);
+    }
+    void init() {
+        head = new_node(max_level);
+    }
+
+public:
+    class iterator {
+        friend class skiplist_map;
+        friend const_iterator;
+
+    public:
+        typedef pair<const Key, T> value_type;
+        typedef value_type&         reference;
+        typedef value_type*           pointer;
+        typedef std::ptrdiff_t        difference_type;
+        typedef std::bidirectional_iterator_tag iterator_category;
+
+    private:
+        skiplist_map *_map;
+        node *p; // nullptr at end()
+        epoch_domain::guard g; // keeps p from being reclaimed
+
+    public:
+        iterator() : _map(nullptr), p(nullptr) {}
+        iterator(skiplist_map *__map, node *_p, const epoch_domain::guard &_g) : _map(__map), p(_p), g(_g) {}
+
+        iterator operator++(int) {
+            iterator res(*this);
+            ++*this;
+            return res;
+        }
+        iterator &operator++() {
+            if (_map == nullptr || p == nullptr)
+                throw invalid_iterator();
+            p = next_live(p);
+            return *this;
+        }
+        iterator operator--(int) {
+            iterator res(*this);
+            --*this;
+            return res;
+        }
+        iterator &operator--() {
+            if (_map == nullptr)
+                throw invalid_iterator();
+            epoch_domain::guard pin = _map->dom.pin();
+            node *q = _map->last_before(p == nullptr ? nullptr : &p->key());
+            if (q == _map->head)
+                throw invalid_iterator();
+            p = q, g = pin;
+            return *this;
+        }
+
+        reference operator*() const {
+            return *p->value();
+        }
+        pointer operator->() const noexcept {
+            return p->value();
+        }
+
+        bool operator==(const iterator &o) const {
+            return _map == o._map && p == o.p;
+        }
+        bool operator==(const const_iterator &o) const {
+            return _map == o._map && p == o.p;
+        }
+        bool operator!=(const iterator &o) const {
+            return !(*this == o);
+        }
+        bool operator!=(const const_iterator &o) const {
+            return !(*this == o);
+        }
+    };
+    class const_iterator {
+        friend class skiplist_map;
+        friend iterator;
+
+    public:
+        typedef const pair<const Key, T> value_type;
+        typedef value_type&         reference;
+        typedef value_type*           pointer;
+        typedef std::ptrdiff_t        difference_type;
+        typedef std::bidirectional_iterator_tag iterator_category;
+
+    private:
+        const skiplist_map *_map;
+        node *p;
+        epoch_domain::guard g;
+
+    public:
+        const_iterator() : _map(nullptr), p(nullptr) {}
+        const_iterator(const iterator &o) : _map(o._map), p(o.p), g(o.g) {}
+        const_iterator(const skiplist_map *__map, node *_p, const epoch_domain::guard &_g)
+            : _map(__map), p(_p), g(_g) {}
+
+        const_iterator operator++(int) {
+            const_iterator res(*this);
+            ++*this;
+            return res;
+        }
+        const_iterator &operator++() {
+            if (_map == nullptr || p == nullptr)
+                throw invalid_iterator();
+            p = next_live(p);
+            return *this;
+        }
+        const_iterator operator--(int) {
+            const_iterator res(*this);
+            --*this;
+            return res;
+        }
+        const_iterator &operator--() {
+            if (_map == nullptr)
+                throw invalid_iterator();
+            epoch_domain::guard pin = _map->dom.pin();
+            node *q = _map->last_before(p == nullptr ? nullptr : &p->key());
+            if (q == _map->head)
+                throw invalid_iterator();
+            p = q, g = pin;
+            return *this;
+        }
+
+        reference operator*() const {
+            return *p->value();
+        }
+        pointer operator->() const noexcept {
+            return p->value();
+        }
+
+        bool operator==(const iterator &o) const {
+            return _map == o._map && p == o.p;
+        }
+        bool operator==(const const_iterator &o) const {
+            return _map == o._map && p == o.p;
+        }
+        bool operator!=(const iterator &o) const {
+            return !(*this == o);
+        }
+        bool operator!=(const const_iterator &o) const {
+            return !(*this == o);
+        }
+    };
+
+    skiplist_map() : head(nullptr), levels(1), _size(0), cmp(), alloc(), nalloc(alloc) {
+        init();
+    }
+    explicit skiplist_map(const Allocator &a) : head(nullptr), levels(1), _size(0), cmp(), alloc(a), nalloc(alloc) {
+        init();
+    }
+    skiplist_map(const skiplist_map &o) : head(nullptr), levels(1), _size(0), cmp(o.cmp),
+                                          alloc(value_traits::select_on_container_copy_construction(o.alloc)),
+                                          nalloc(alloc) {
+        init();
+        try {
+            copy_from(o);
+        } catch (...) {
+            destroy_all();
+            free_node(head);
+            throw;
+        }
+    }
+    ~skiplist_map() {
+        destroy_all();
+        free_node(head);
+    }
+
+    skiplist_map &operator=(const skiplist_map &o) {
+        if (this == &o)
+            return *this;
+        destroy_all();
+        cmp = o.cmp;
+        copy_from(o);
+        return *this;
+    }
+
+    allocator_type get_allocator() const {
+        return alloc;
+    }
+
+    /**
+     * access specified element with bounds checking.
+     * throw index_out_of_bound if no such element exists.
+     */
+    T &at(const Key &key) {
+        epoch_domain::guard g = dom.pin();
+        node *p = find_node(key);
+        if (p == nullptr)
+            throw index_out_of_bound();
+        return p->value()->second;
+    }
+    const T &at(const Key &key) const {
+        epoch_domain::guard g = dom.pin();
+        node *p = find_node(key);
+        if (p == nullptr)
+            throw index_out_of_bound();
+        return p->value()->second;
+    }
+    /**
+     * access specified element, inserting a value-initialized T if the key is absent.
+     */
+    T &operator[](const Key &key) {
+        return try_emplace(key).first->second;
+    }
+    T &operator[](Key &&key) {
+        return try_emplace(std::move(key)).first->second;
+    }
+    // behave like at(): throw index_out_of_bound if no such element exists
+    const T &operator[](const Key &key) const {
+        return at(key);
+    }
+
+    iterator begin() {
+        epoch_domain::guard g = dom.pin();
+        return iterator(this, next_live(head), g);
+    }
+    const_iterator begin() const {
+        return cbegin();
+    }
+    const_iterator cbegin() const {
+        epoch_domain::guard g = dom.pin();
+        return const_iterator(this, next_live(head), g);
+    }
+    iterator end() {
+        return iterator(this, nullptr, epoch_domain::guard());
+    }
+    const_iterator end() const {
+        return cend();
+    }
+    const_iterator cend() const {
+        return const_iterator(this, nullptr, epoch_domain::guard());
+    }
+
+    // exact when no other thread is changing the map
+    bool empty() const {
+        return size() == 0;
+    }
+    size_t size() const {
+        return _size.load(std::memory_order_relaxed);
+    }
+    // erase the elements one by one, so other threads may go on using the map
+    void clear() {
+        epoch_domain::guard g = dom.pin();
+        for (node *p = next_live(head); p != nullptr; p = next_live(p))
+            erase_node(p);
+    }
+
+    /**
+     * insert value if its key is absent.
+     * return a pair of the iterator to the element with that key, and whether
+     * the insertion took place.
+     */
+    pair<iterator, bool> insert(const value_type &value) {
+        epoch_domain::guard g = dom.pin();
+        return insert_key<false>(g, value.first, value);
+    }
+    pair<iterator, bool> insert(value_type &&value) {
+        epoch_domain::guard g = dom.pin();
+        return insert_key<false>(g, value.first, std::move(value));
+    }
+    template<class... Args>
+    pair<iterator, bool> try_emplace(const Key &key, Args&&... args) {
+        return emplace_key(key, std::forward<Args>(args)...);
+    }
+    template<class... Args>
+    pair<iterator, bool> try_emplace(Key &&key, Args&&... args) {
+        return emplace_key(std::move(key), std::forward<Args>(args)...);
+    }
+    template<class M>
+    pair<iterator, bool> insert_or_assign(const Key &key, M &&obj) {
+        return assign_key(key, std::forward<M>(obj));
+    }
+    template<class M>
+    pair<iterator, bool> insert_or_assign(Key &&key, M &&obj) {
+        return assign_key(std::move(key), std::forward<M>(obj));
+    }
+
+    /**
+     * erase the element at pos.
+     * throw if pos pointed to a bad element (pos == this->end() || pos points an element out of this),
+     * or to one that is already erased.
+     */
+    void erase(iterator pos) {
+        if (this != pos._map || pos.p == nullptr)
+            throw invalid_iterator();
+        epoch_domain::guard g = dom.pin();
+        if (!erase_node(pos.p))
+            throw invalid_iterator();
+    }
+    /**
+     * erase the element with the given key, if any.
+     * return the number of elements removed (0 or 1).
+     */
+    size_t erase(const Key &key) {
+        epoch_domain::guard g = dom.pin();
+        node *preds[max_level], *succs[max_level];
+        if (!search(key, preds, succs))
+            return 0;
+        return erase_node(succs[0]) ? 1 : 0;
+    }
+
+    size_t count(const Key &key) const {
+        epoch_domain::guard g = dom.pin();
+        return find_node(key) != nullptr ? 1 : 0;
+    }
+    /**
+     * find an element with key equivalent to key.
+     * return an iterator to it, or end() if there is none.
+     */
+    iterator find(const Key &key) {
+        epoch_domain::guard g = dom.pin();
+        return iterator(this, find_node(key), g);
+    }
+    const_iterator find(const Key &key) const {
+        epoch_domain::guard g = dom.pin();
+        return const_iterator(this, find_node(key), g);
+    }
+    iterator lower_bound(const Key &key) {
+        epoch_domain::guard g = dom.pin();
+        return iterator(this, lower(key, false), g);
+    }
+    const_iterator lower_bound(const Key &key) const {
+        epoch_domain::guard g = dom.pin();
+        return const_iterator(this, lower(key, false), g);
+    }
+    iterator upper_bound(const Key &key) {
+        epoch_domain::guard g = dom.pin();
+        return iterator(this, lower(key, true), g);
+    }
+    const_iterator upper_bound(const Key &key) const {
+        epoch_domain::guard g = dom.pin();
+        return const_iterator(this, lower(key, true), g);
+    }
+    pair<iterator, iterator> equal_range(const Key &key) {
+        epoch_domain::guard g = dom.pin();
+        node *p = lower(key, false);
+        node *q = p != nullptr && !cmp(key, p->key()) ? next_live(p) : p;
+        return pair<iterator, iterator>(iterator(this, p, g), iterator(this, q, g));
+    }
+    pair<const_iterator, const_iterator> equal_range(const Key &key) const {
+        epoch_domain::guard g = dom.pin();
+        node *p = lower(key, false);
+        node *q = p != nullptr && !cmp(key, p->key()) ? next_live(p) : p;
+        return pair<const_iterator, const_iterator>(const_iterator(this, p, g), const_iterator(this, q, g));
+    }
+};
+
+}
+
+#endif
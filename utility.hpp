@@ -1,10 +1,20 @@
 #ifndef SJTU_UTILITY_HPP
 #define SJTU_UTILITY_HPP
 
+#include <cstddef>
+#include <tuple>
 #include <utility>
 
 namespace sjtu {
 
+// the indices 0 .. N - 1 of a tuple as a pack, for unpacking it into a call
+template<std::size_t... I>
+struct index_sequence {};
+template<std::size_t N, std::size_t... I>
+struct make_index_sequence : make_index_sequence<N - 1, N - 1, I...> {};
+template<std::size_t... I>
+struct make_index_sequence<0, I...> : index_sequence<I...> {};
+
 template<class T1, class T2>
 class pair {
 public:
@@ -15,12 +25,42 @@ public:
 	pair(pair &&other) = default;
 	pair(const T1 &x, const T2 &y) : first(x), second(y) {}
 	template<class U1, class U2>
-	pair(U1 &&x, U2 &&y) : first(x), second(y) {}
+	pair(U1 &&x, U2 &&y) : first(std::forward<U1>(x)), second(std::forward<U2>(y)) {}
 	template<class U1, class U2>
 	pair(const pair<U1, U2> &other) : first(other.first), second(other.second) {}
 	template<class U1, class U2>
-	pair(pair<U1, U2> &&other) : first(other.first), second(other.second) {}
+	pair(pair<U1, U2> &&other) : first(std::move(other.first)), second(std::move(other.second)) {}
+	/**
+	 * construct first from the elements of a and second from those of b, in place:
+	 * neither needs to be copyable or movable.
+	 */
+	template<class... Args1, class... Args2>
+	pair(std::piecewise_construct_t, std::tuple<Args1...> a, std::tuple<Args2...> b)
+		: pair(a, b, make_index_sequence<sizeof...(Args1)>(), make_index_sequence<sizeof...(Args2)>()) {}
+
+private:
+	template<class A, class B, std::size_t... I, std::size_t... J>
+	pair(A &a, B &b, index_sequence<I...>, index_sequence<J...>)
+		: first(std::forward<typename std::tuple_element<I, A>::type>(std::get<I>(a))...),
+		  second(std::forward<typename std::tuple_element<J, B>::type>(std::get<J>(b))...) {}
+};
+
+/**
+ * tag for the container constructors and assign() that take a range
+ * already sorted by the container's Compare and free of duplicate keys.
+ */
+struct sorted_unique_t {
+	explicit sorted_unique_t() = default;
+};
+constexpr sorted_unique_t sorted_unique{};
+
+/**
+ * tag for the copy constructor that may copy on more than one thread.
+ */
+struct parallel_copy_t {
+	explicit parallel_copy_t() = default;
 };
+constexpr parallel_copy_t parallel_copy{};
 
 }
 